@@ -25,12 +25,21 @@ enum {
 static GParamSpec *props[PROP_LAST_PROP];
 
 
+/* A property resolved at setup so easing it doesn't need any lookups */
 typedef struct _PhocEaseProp {
-  GParamSpec *pspec;
-  float start;
-  float end;
+  GParamSpec             *pspec;
+  GType                   value_type;
+  GObjectClass           *owner_class;
+  guint                   param_id;
+  PhocPropertyEaserSetter setter;
+  double                  min;
+  double                  max;
+  float                   start;
+  float                   end;
 } PhocEaseProp;
 
+G_DEFINE_QUARK (phoc-property-easer-setter, setter);
+
 
 /**
  * PhocPropertyEaser:
@@ -60,8 +69,14 @@ typedef struct _PhocEaseProp {
  *
  * would set `object.a == 0.0` and `object.b == 50.0`.
  *
- * The eased properties must be of type `float` or `int`. If the tracked object goes away the
- * easing stops. No ref is held on the object.
+ * The eased properties must be of type `float`, `double`, `int` or `uint`. If the tracked
+ * object goes away the easing stops. No ref is held on the object.
+ *
+ * Properties are resolved once when they're set up. Updating the
+ * progress then invokes the setter registered via
+ * [func@PropertyEaser.install_setter] or the owning class'
+ * `set_property()` directly so that it neither allocates nor looks
+ * up properties by name.
  */
 struct _PhocPropertyEaser {
   GObject         parent;
@@ -70,7 +85,7 @@ struct _PhocPropertyEaser {
   GObject        *target;
   PhocEasing      easing;
 
-  GHashTable     *ease_props;
+  GArray         *ease_props;
 };
 G_DEFINE_TYPE (PhocPropertyEaser, phoc_property_easer, G_TYPE_OBJECT)
 
@@ -95,25 +110,110 @@ phoc_lerp (double a, double b, double t)
 }
 
 
+static gboolean
+phoc_ease_prop_init (PhocEaseProp *ease_prop, GParamSpec *pspec, float start, float end)
+{
+  GObjectClass *owner_class;
+  GParamSpec *redirect;
+  guint param_id;
+
+  g_assert (G_IS_PARAM_SPEC (pspec));
+
+  /* Like g_object_set_property(): overridden properties are set via
+   * the overriding class but have the type and range of the original */
+  owner_class = g_type_class_peek (pspec->owner_type);
+  param_id = pspec->param_id;
+  redirect = g_param_spec_get_redirect_target (pspec);
+  if (redirect)
+    pspec = redirect;
+
+  *ease_prop = (PhocEaseProp) {
+    .pspec = pspec,
+    .value_type = G_PARAM_SPEC_VALUE_TYPE (pspec),
+    .owner_class = owner_class,
+    .param_id = param_id,
+    .setter = g_param_spec_get_qdata (pspec, setter_quark ()),
+    .start = start,
+    .end = end,
+  };
+
+  if (ease_prop->value_type == G_TYPE_FLOAT) {
+    ease_prop->min = G_PARAM_SPEC_FLOAT (pspec)->minimum;
+    ease_prop->max = G_PARAM_SPEC_FLOAT (pspec)->maximum;
+  } else if (ease_prop->value_type == G_TYPE_DOUBLE) {
+    ease_prop->min = G_PARAM_SPEC_DOUBLE (pspec)->minimum;
+    ease_prop->max = G_PARAM_SPEC_DOUBLE (pspec)->maximum;
+  } else if (ease_prop->value_type == G_TYPE_INT) {
+    ease_prop->min = G_PARAM_SPEC_INT (pspec)->minimum;
+    ease_prop->max = G_PARAM_SPEC_INT (pspec)->maximum;
+  } else if (ease_prop->value_type == G_TYPE_UINT) {
+    ease_prop->min = G_PARAM_SPEC_UINT (pspec)->minimum;
+    ease_prop->max = G_PARAM_SPEC_UINT (pspec)->maximum;
+  } else {
+    g_warning ("'%s' is not a float or int property", pspec->name);
+    return FALSE;
+  }
+
+  if (!(pspec->flags & G_PARAM_WRITABLE) || (pspec->flags & G_PARAM_CONSTRUCT_ONLY)) {
+    g_warning ("'%s' is not writable", pspec->name);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+
 static void
-phoc_ease_prop_free (PhocEaseProp *ease_prop)
+phoc_ease_prop_apply (PhocEaseProp *ease_prop, GObject *target, float t)
 {
-  g_free (ease_prop);
+  double value = phoc_lerp (ease_prop->start, ease_prop->end, t);
+  GValue gvalue = G_VALUE_INIT;
+
+  value = CLAMP (value, ease_prop->min, ease_prop->max);
+
+  if (ease_prop->setter) {
+    ease_prop->setter (target, value);
+    return;
+  }
+
+  /* Fundamental types don't need to be unset */
+  g_value_init (&gvalue, ease_prop->value_type);
+  if (ease_prop->value_type == G_TYPE_FLOAT)
+    g_value_set_float (&gvalue, value);
+  else if (ease_prop->value_type == G_TYPE_DOUBLE)
+    g_value_set_double (&gvalue, value);
+  else if (ease_prop->value_type == G_TYPE_INT)
+    g_value_set_int (&gvalue, (int)value);
+  else
+    g_value_set_uint (&gvalue, (guint)value);
+
+  ease_prop->owner_class->set_property (target, ease_prop->param_id, &gvalue, ease_prop->pspec);
+
+  if (!(ease_prop->pspec->flags & G_PARAM_EXPLICIT_NOTIFY))
+    g_object_notify_by_pspec (target, ease_prop->pspec);
 }
 
 
-static PhocEaseProp *
-phoc_ease_prop_new (GParamSpec *pspec, float start, float end)
+static gboolean
+add_ease_prop (PhocPropertyEaser *self, GParamSpec *pspec, float start, float end)
 {
-  PhocEaseProp *ease_prop = g_new0 (PhocEaseProp, 1);
+  PhocEaseProp ease_prop;
 
-  g_assert (G_IS_PARAM_SPEC (pspec));
+  if (!phoc_ease_prop_init (&ease_prop, pspec, start, end))
+    return FALSE;
+
+  /* Easing a property again replaces the old values */
+  for (guint i = 0; i < self->ease_props->len; i++) {
+    PhocEaseProp *old = &g_array_index (self->ease_props, PhocEaseProp, i);
 
-  ease_prop->pspec = pspec;
-  ease_prop->start = start;
-  ease_prop->end = end;
+    if (old->pspec == ease_prop.pspec) {
+      *old = ease_prop;
+      return TRUE;
+    }
+  }
 
-  return ease_prop;
+  g_array_append_val (self->ease_props, ease_prop);
+  return TRUE;
 }
 
 
@@ -150,7 +250,6 @@ set_props_variant (PhocPropertyEaser *self, GVariant *variant)
   g_variant_iter_init (&iter, variant);
   while (g_variant_iter_next (&iter, PROPS_FORMAT, &name, &start, &end, NULL)) {
     GParamSpec *pspec;
-    PhocEaseProp *ease_prop;
 
     pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (self->target), name);
 
@@ -159,10 +258,8 @@ set_props_variant (PhocPropertyEaser *self, GVariant *variant)
       continue;
     }
 
-    ease_prop = phoc_ease_prop_new (pspec, start, end);
-    g_hash_table_insert (self->ease_props, g_strdup (name), ease_prop);
-
-    n_params++;
+    if (add_ease_prop (self, pspec, start, end))
+      n_params++;
   }
 
   phoc_property_easer_set_progress (self, 0.0);
@@ -231,7 +328,7 @@ phoc_property_easer_dispose (GObject *object)
   PhocPropertyEaser *self = PHOC_PROPERTY_EASER(object);
 
   set_target (self, NULL);
-  g_clear_pointer (&self->ease_props, g_hash_table_destroy);
+  g_clear_pointer (&self->ease_props, g_array_unref);
 
   G_OBJECT_CLASS (phoc_property_easer_parent_class)->dispose (object);
 }
@@ -294,8 +391,7 @@ phoc_property_easer_class_init (PhocPropertyEaserClass *klass)
 static void
 phoc_property_easer_init (PhocPropertyEaser *self)
 {
-  self->ease_props = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
-                                            (GDestroyNotify)phoc_ease_prop_free);
+  self->ease_props = g_array_new (FALSE, FALSE, sizeof (PhocEaseProp));
 }
 
 
@@ -318,37 +414,34 @@ phoc_property_easer_new (GObject *target)
 void
 phoc_property_easer_set_progress (PhocPropertyEaser *self, float progress)
 {
-  GHashTableIter iter;
-  PhocEaseProp *ease_prop;
+  gboolean freeze;
+  float t;
 
   /* target disposed, nothing to do */
   if (self->target == NULL)
     return;
 
-  g_return_if_fail (g_hash_table_size (self->ease_props));
+  g_return_if_fail (self->ease_props->len);
   g_return_if_fail (PHOC_IS_PROPERTY_EASER (self));
   g_return_if_fail (progress >= 0.0 && progress <= 1.0);
 
   self->progress = progress;
+  t = phoc_easing_ease (self->easing, progress);
 
-  g_object_freeze_notify (self->target);
-  g_hash_table_iter_init (&iter, self->ease_props);
-  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &ease_prop)) {
-    float t = phoc_easing_ease (self->easing, progress);
-    g_auto (GValue) val = G_VALUE_INIT;
-    g_auto (GValue) target = G_VALUE_INIT;
-
-    g_value_init (&val, G_TYPE_FLOAT);
-    g_value_init (&target, G_PARAM_SPEC_VALUE_TYPE (ease_prop->pspec));
+  /* Freezing allocates a notify queue, only worth it when there's
+   * more than one notification to batch */
+  freeze = self->ease_props->len > 1;
+  if (freeze)
+    g_object_freeze_notify (self->target);
 
-    g_value_set_float (&val, phoc_lerp (ease_prop->start, ease_prop->end, t));
-    g_value_transform (&val, &target);
+  for (guint i = 0; i < self->ease_props->len; i++) {
+    PhocEaseProp *ease_prop = &g_array_index (self->ease_props, PhocEaseProp, i);
 
-    g_object_set_property (self->target,
-                           ease_prop->pspec->name,
-                           &target);
+    phoc_ease_prop_apply (ease_prop, self->target, t);
   }
-  g_object_thaw_notify (self->target);
+
+  if (freeze)
+    g_object_thaw_notify (self->target);
 
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_PROGRESS]);
 }
@@ -397,7 +490,6 @@ phoc_property_easer_set_props_valist (PhocPropertyEaser *self,
   name = first_property_name;
   do {
     GParamSpec *pspec;
-    PhocEaseProp *ease_prop;
     float start, end;
 
     pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (self->target), name);
@@ -421,10 +513,8 @@ phoc_property_easer_set_props_valist (PhocPropertyEaser *self,
       continue;
     }
 
-    ease_prop = phoc_ease_prop_new (pspec, start, end);
-    g_hash_table_insert (self->ease_props, g_strdup (name), ease_prop);
-
-    n_params++;
+    if (add_ease_prop (self, pspec, start, end))
+      n_params++;
   } while ((name = va_arg (var_args, const gchar *)));
 
   phoc_property_easer_set_progress (self, 0.0);
@@ -456,3 +546,22 @@ phoc_property_easer_set_props (PhocPropertyEaser *self,
   va_end (var_args);
   return n;
 }
+
+/**
+ * phoc_property_easer_install_setter:
+ * @pspec: The property
+ * @setter:(scope forever): The setter
+ *
+ * Registers a typed setter for @pspec. When easing the property the
+ * setter is invoked directly with the eased value instead of going
+ * through the owning class' `set_property()` and a `GValue`. The
+ * setter is responsible for emitting `notify`. This is meant to be
+ * invoked from `class_init` for properties that are eased often.
+ */
+void
+phoc_property_easer_install_setter (GParamSpec *pspec, PhocPropertyEaserSetter setter)
+{
+  g_return_if_fail (G_IS_PARAM_SPEC (pspec));
+
+  g_param_spec_set_qdata (pspec, setter_quark (), setter);
+}
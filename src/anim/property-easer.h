@@ -14,6 +14,16 @@ G_BEGIN_DECLS
 
 #define PHOC_TYPE_PROPERTY_EASER (phoc_property_easer_get_type ())
 
+/**
+ * PhocPropertyEaserSetter:
+ * @object: The object to set the property on
+ * @value: The eased value
+ *
+ * A typed setter for an eased property. See
+ * [func@PropertyEaser.install_setter].
+ */
+typedef void (*PhocPropertyEaserSetter) (GObject *object, float value);
+
 G_DECLARE_FINAL_TYPE (PhocPropertyEaser, phoc_property_easer, PHOC, PROPERTY_EASER, GObject)
 
 PhocPropertyEaser    *phoc_property_easer_new              (GObject            *target);
@@ -26,6 +36,8 @@ PhocEasing            phoc_property_easer_get_easing       (PhocPropertyEaser  *
 guint                 phoc_property_easer_set_props        (PhocPropertyEaser  *self,
                                                             const gchar        *first_property_name,
                                                             ...) G_GNUC_NULL_TERMINATED;
+void                  phoc_property_easer_install_setter   (GParamSpec         *pspec,
+                                                            PhocPropertyEaserSetter setter);
 
 double phoc_lerp (double a, double b, double t);
 
@@ -48,6 +48,7 @@ struct _PhocTimedAnimation {
   PhocAnimatable      *animatable;
   PhocPropertyEaser   *prop_easer;
   gint64               elapsed_ms;
+  gint64               start_us;
   int                  duration;
   PhocAnimationState   state;
   guint                frame_callback_id;
@@ -135,12 +136,11 @@ stop_animation (PhocTimedAnimation *self)
 
 static gboolean
 on_frame_callback (PhocAnimatable *animatable,
-                   guint64         last_frame,
+                   guint64         frame_time,
                    gpointer        user_data)
 {
   PhocTimedAnimation *self = PHOC_TIMED_ANIMATION (user_data);
-  guint64 now = g_get_monotonic_time ();
-  guint t = self->elapsed_ms + ((now - last_frame) / 1000);
+  guint t = MAX ((gint64)frame_time - self->start_us, 0) / 1000;
 
   g_debug ("t: %d/%d", t, self->duration);
   if (self->elapsed_ms > self->duration) {
@@ -172,6 +172,7 @@ play (PhocTimedAnimation *self)
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_STATE]);
 
   self->elapsed_ms = 0;
+  self->start_us = g_get_monotonic_time ();
 
   if (self->frame_callback_id)
     return;
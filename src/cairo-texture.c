@@ -217,6 +217,12 @@ phoc_cairo_texture_get_texture (PhocCairoTexture *self)
 }
 
 
+/**
+ * phoc_cairo_texture_update:
+ * @self: The cairo texture
+ *
+ * Uploads the whole backing Cairo surface to the texture.
+ */
 void
 phoc_cairo_texture_update (PhocCairoTexture *self)
 {
@@ -224,12 +230,39 @@ phoc_cairo_texture_update (PhocCairoTexture *self)
 
   g_assert (PHOC_IS_CAIRO_TEXTURE (self));
 
+  pixman_region32_init_rect (&region, 0, 0, self->width, self->height);
+  phoc_cairo_texture_update_region (self, &region);
+  pixman_region32_fini (&region);
+}
+
+/**
+ * phoc_cairo_texture_update_region:
+ * @self: The cairo texture
+ * @damage: The damaged region in surface coordinates
+ *
+ * Uploads only the parts of the backing Cairo surface that changed
+ * to the texture. Use this instead of
+ * [method@CairoTexture.update] when only a small part of a larger
+ * surface got redrawn.
+ */
+void
+phoc_cairo_texture_update_region (PhocCairoTexture *self, const pixman_region32_t *damage)
+{
+  pixman_region32_t region;
+
+  g_assert (PHOC_IS_CAIRO_TEXTURE (self));
+
   if (!self->texture)
     return;
 
-  cairo_surface_flush (self->surface);
+  pixman_region32_init (&region);
+  pixman_region32_intersect_rect (&region, damage, 0, 0, self->width, self->height);
+  if (!pixman_region32_not_empty (&region))
+    goto out;
 
-  pixman_region32_init_rect (&region, 0, 0, self->width, self->height);
+  cairo_surface_flush (self->surface);
   wlr_texture_update_from_buffer (self->texture, &self->buffer, &region);
+
+ out:
   pixman_region32_fini (&region);
 }
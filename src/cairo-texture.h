@@ -7,6 +7,7 @@
 #pragma once
 
 #include <glib-object.h>
+#include <pixman.h>
 
 G_BEGIN_DECLS
 
@@ -20,5 +21,7 @@ PhocCairoTexture   *phoc_cairo_texture_new         (int width, int height);
 cairo_t            *phoc_cairo_texture_get_context (PhocCairoTexture *self);
 struct wlr_texture *phoc_cairo_texture_get_texture (PhocCairoTexture *self);
 void                phoc_cairo_texture_update      (PhocCairoTexture *self);
+void                phoc_cairo_texture_update_region (PhocCairoTexture        *self,
+                                                      const pixman_region32_t *damage);
 
 G_END_DECLS
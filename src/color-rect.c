@@ -10,6 +10,7 @@
 
 #include "phoc-config.h"
 #include "color-rect.h"
+#include "property-easer.h"
 #include "output.h"
 #include "utils.h"
 
@@ -288,6 +289,8 @@ phoc_color_rect_class_init (PhocColorRectClass *klass)
                         G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
 
   g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+  phoc_property_easer_install_setter (props[PROP_ALPHA],
+                                      (PhocPropertyEaserSetter)phoc_color_rect_set_alpha);
 }
 
 
@@ -15,6 +15,7 @@
 #include "gesture-drag.h"
 #include "gesture-swipe.h"
 #include "layer-shell-effects.h"
+#include "motion-queue.h"
 
 #define _XOPEN_SOURCE 700
 #include <assert.h>
@@ -52,6 +53,12 @@ typedef struct _PhocCursorPrivate {
 
   gboolean                   has_pointer_motion;
 
+  /* Coalesced motion, see phoc_cursor_flush_motion() */
+  PhocMotionQueue           *pointer_queue;
+  PhocMotionQueue           *touch_queue;
+  guint64                    n_motion_events;
+  guint64                    n_motion_sent;
+
   /* State of the animated view when cursor touches a screen edge */
   struct {
     PhocColorRect         *rect;
@@ -508,11 +515,12 @@ send_touch_down (PhocSeat                    *seat,
 
 
 static void
-send_touch_motion (PhocSeat                      *seat,
-                   struct wlr_surface            *surface,
-                   struct wlr_touch_motion_event *event,
-                   double                         sx,
-                   double                         sy)
+send_touch_motion (PhocSeat           *seat,
+                   struct wlr_surface *surface,
+                   guint32             time,
+                   int                 touch_id,
+                   double              sx,
+                   double              sy)
 {
   if (should_ignore_touch_grab (seat, surface)) {
     // currently wlr_seat_touch_send_* functions don't work, so temporarily
@@ -520,13 +528,12 @@ send_touch_motion (PhocSeat                      *seat,
     // See https://gitlab.freedesktop.org/wlroots/wlroots/-/issues/3478
     struct wlr_seat_touch_grab *grab = seat->seat->touch_state.grab;
     seat->seat->touch_state.grab = seat->seat->touch_state.default_grab;
-    wlr_seat_touch_notify_motion (seat->seat, event->time_msec,
-                                  event->touch_id, sx, sy);
+    wlr_seat_touch_notify_motion (seat->seat, time, touch_id, sx, sy);
     seat->seat->touch_state.grab = grab;
     return;
   }
 
-  wlr_seat_touch_notify_motion (seat->seat, event->time_msec, event->touch_id, sx, sy);
+  wlr_seat_touch_notify_motion (seat->seat, time, touch_id, sx, sy);
 }
 
 
@@ -641,6 +648,152 @@ phoc_cursor_get_touch_point (PhocCursor *self, int touch_id)
 }
 
 
+static gboolean
+should_coalesce_motion (void)
+{
+  PhocConfig *config = phoc_server_get_config (phoc_server_get_default ());
+
+  return config->coalesce_motion;
+}
+
+/*
+ * Make sure there's an output frame that flushes the coalesced motion
+ */
+static void
+schedule_motion_flush (PhocCursor *self, double lx, double ly)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output = phoc_desktop_layout_get_output (desktop, lx, ly);
+
+  if (output && output->wlr_output->enabled)
+    wlr_output_schedule_frame (output->wlr_output);
+  else
+    phoc_cursor_flush_motion (self);
+}
+
+
+static void
+send_pointer_frame (PhocCursor *self)
+{
+  wlr_seat_pointer_notify_frame (self->seat->seat);
+
+  // make sure to always send frame events when necessary even when bypassing seat grabs
+  wlr_seat_pointer_send_frame (self->seat->seat);
+}
+
+
+static void
+send_touch_frame (PhocCursor *self)
+{
+  wlr_seat_touch_notify_frame (self->seat->seat);
+
+  // make sure to always send frame events when necessary even when bypassing seat grabs
+  wlr_seat_touch_send_frame (self->seat->seat);
+}
+
+
+static void
+on_pointer_motion_flushed (PhocCursor         *self,
+                           int                 id,
+                           struct wlr_surface *surface,
+                           guint32             time,
+                           double              sx,
+                           double              sy)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  /* Focus changes flush, so the surface can only be gone */
+  if (surface != self->seat->seat->pointer_state.focused_surface)
+    return;
+
+  send_pointer_motion (self->seat, surface, time, sx, sy);
+  priv->n_motion_sent++;
+}
+
+
+static void
+flush_pointer_motion (PhocCursor *self)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  phoc_motion_queue_flush (priv->pointer_queue);
+}
+
+
+static void
+queue_pointer_motion (PhocCursor *self, struct wlr_surface *surface, guint32 time, double sx, double sy)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  priv->n_motion_events++;
+
+  if (should_coalesce_motion () && !should_ignore_pointer_grab (self->seat, surface) &&
+      surface == self->seat->seat->pointer_state.focused_surface) {
+    phoc_motion_queue_push (priv->pointer_queue, 0, surface, time, sx, sy);
+    schedule_motion_flush (self, self->cursor->x, self->cursor->y);
+    return;
+  }
+
+  flush_pointer_motion (self);
+  send_pointer_motion (self->seat, surface, time, sx, sy);
+  priv->n_motion_sent++;
+}
+
+
+static void
+on_touch_motion_flushed (PhocCursor         *self,
+                         int                 touch_id,
+                         struct wlr_surface *surface,
+                         guint32             time,
+                         double              sx,
+                         double              sy)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+  struct wlr_touch_point *point;
+
+  /* Drop motion of canceled touch points */
+  point = wlr_seat_touch_get_point (self->seat->seat, touch_id);
+  if (point == NULL || point->surface != surface)
+    return;
+
+  send_touch_motion (self->seat, surface, time, touch_id, sx, sy);
+  priv->n_motion_sent++;
+}
+
+
+static void
+flush_touch_motion (PhocCursor *self)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  phoc_motion_queue_flush (priv->touch_queue);
+}
+
+
+static void
+queue_touch_motion (PhocCursor         *self,
+                    PhocTouchPoint     *touch_point,
+                    struct wlr_surface *surface,
+                    guint32             time,
+                    double              sx,
+                    double              sy)
+{
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
+
+  priv->n_motion_events++;
+
+  if (should_coalesce_motion () && !should_ignore_touch_grab (self->seat, surface)) {
+    phoc_motion_queue_push (priv->touch_queue, touch_point->touch_id, surface, time, sx, sy);
+    schedule_motion_flush (self, touch_point->lx, touch_point->ly);
+    return;
+  }
+
+  flush_touch_motion (self);
+  send_touch_motion (self->seat, surface, time, touch_point->touch_id, sx, sy);
+  priv->n_motion_sent++;
+}
+
+
 static void
 phoc_cursor_set_property (GObject      *object,
                           guint         property_id,
@@ -691,12 +844,13 @@ handle_gestures_for_event_at (PhocCursor   *self,
                               gpointer      wlr_event,
                               gsize         size)
 {
-  g_autoptr (PhocEvent) event = phoc_event_new (type, wlr_event, size);
+  g_autoptr (PhocEvent) event = NULL;
   GSList *gestures = phoc_cursor_get_gestures (self);
 
   if (gestures == NULL)
     return;
 
+  event = phoc_event_new (type, wlr_event, size);
   for (GSList *elem = gestures; elem; elem = elem->next) {
     PhocGesture *gesture = PHOC_GESTURE (elem->data);
 
@@ -895,9 +1049,13 @@ phoc_passthrough_cursor (PhocCursor *self, uint32_t time)
   self->wlr_surface = surface;
 
   if (surface) {
+    /* Pending motion belongs to the old surface */
+    if (surface != seat->seat->pointer_state.focused_surface)
+      flush_pointer_motion (self);
     send_pointer_enter (seat, surface, sx, sy);
-    send_pointer_motion (seat, surface, time, sx,sy);
+    queue_pointer_motion (self, surface, time, sx, sy);
   } else {
+    flush_pointer_motion (self);
     send_pointer_clear_focus (seat, seat->seat->pointer_state.focused_surface);
   }
 
@@ -977,6 +1135,8 @@ phoc_cursor_finalize (GObject *object)
   phoc_cursor_clear_view_state_change (self);
   g_clear_pointer (&priv->touch_points, g_hash_table_destroy);
   g_clear_pointer (&priv->gestures, free_gestures);
+  g_clear_object (&priv->pointer_queue);
+  g_clear_object (&priv->touch_queue);
 
   g_clear_object (&priv->interface_settings);
   phoc_cursor_set_image_surface (self, NULL);
@@ -1174,6 +1334,18 @@ phoc_cursor_init (PhocCursor *self)
                                               g_direct_equal,
                                               NULL,
                                               (GDestroyNotify)phoc_touch_point_destroy);
+
+  priv->pointer_queue = phoc_motion_queue_new ();
+  g_object_connect (priv->pointer_queue,
+                    "swapped-signal::motion", on_pointer_motion_flushed, self,
+                    "swapped-signal::frame", send_pointer_frame, self,
+                    NULL);
+  priv->touch_queue = phoc_motion_queue_new ();
+  g_object_connect (priv->touch_queue,
+                    "swapped-signal::motion", on_touch_motion_flushed, self,
+                    "swapped-signal::frame", send_touch_frame, self,
+                    NULL);
+
   /*
    * Drag gesture starting at the current cursor position
    */
@@ -1311,6 +1483,9 @@ phoc_cursor_press_button (PhocCursor              *self,
   PhocView *view;
   struct wlr_surface *surface;
 
+  /* Buttons are never delayed so send preceding motion first */
+  flush_pointer_motion (self);
+
   surface = phoc_desktop_wlr_surface_at (desktop, lx, ly, &sx, &sy, &view);
   if (state == WLR_BUTTON_PRESSED && view && phoc_seat_grab_meta_press (seat)) {
     phoc_seat_set_focus_view (seat, view);
@@ -1511,6 +1686,7 @@ handle_pointer_axis (struct wl_listener *listener, void *data)
   }
   phoc_seat_notify_activity (self->seat);
 
+  flush_pointer_motion (self);
   send_pointer_axis (self->seat, self->seat->seat->pointer_state.focused_surface, event);
 }
 
@@ -1519,12 +1695,15 @@ static void
 handle_pointer_frame (struct wl_listener *listener, void *data)
 {
   PhocCursor *self = wl_container_of (listener, self, frame);
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
 
   phoc_seat_notify_activity (self->seat);
-  wlr_seat_pointer_notify_frame (self->seat->seat);
 
-  // make sure to always send frame events when necessary even when bypassing seat grabs
-  wlr_seat_pointer_send_frame (self->seat->seat);
+  /* Terminate the coalesced motion's frame when it gets flushed */
+  if (phoc_motion_queue_push_frame (priv->pointer_queue))
+    return;
+
+  send_pointer_frame (self);
 }
 
 
@@ -1540,6 +1719,9 @@ phoc_cursor_handle_touch_down (PhocCursor                  *self,
   PhocTouchPoint *touch_point;
   double lx, ly;
 
+  /* Keep motion of other touch points ordered before the down */
+  flush_touch_motion (self);
+
   touch_point = phoc_cursor_add_touch_point (self, event);
   lx = touch_point->lx;
   ly = touch_point->ly;
@@ -1558,8 +1740,11 @@ phoc_cursor_handle_touch_down (PhocCursor                  *self,
 
   if (!shell_revealed && surface && phoc_seat_allow_input (seat, surface->resource)) {
     struct wlr_surface *root = wlr_surface_get_root_surface (surface);
+    double scale = view ? phoc_view_get_scale (view) : 1.0;
 
     send_touch_down (seat, surface, event, sx, sy);
+    /* Motion events can reuse the transform until something moves */
+    phoc_touch_point_set_transform (touch_point, surface, scale, lx / scale - sx, ly / scale - sy);
 
     if (view)
       phoc_seat_set_focus_view (seat, view);
@@ -1594,6 +1779,9 @@ phoc_cursor_handle_touch_up (PhocCursor                *self,
   if (!touch_point)
     return;
 
+  /* Motion must reach the client before the touch point goes away */
+  flush_touch_motion (self);
+
   handle_gestures_for_event_at (self, touch_point->lx, touch_point->ly,
                                 PHOC_EVENT_TOUCH_END, event, sizeof (*event));
   phoc_cursor_remove_touch_point (self, event->touch_id);
@@ -1617,6 +1805,77 @@ phoc_cursor_handle_touch_up (PhocCursor                *self,
 }
 
 
+/*
+ * Get the transform from layout coordinates into @surface local
+ * coordinates via @surface's subsurface and popup parents. A surface
+ * local coordinate is `lx / scale - x`.
+ */
+static gboolean
+get_surface_layout_transform (struct wlr_surface *surface, double *scale, double *x, double *y)
+{
+  struct wlr_layer_surface_v1 *wlr_layer_surface;
+  struct wlr_surface *root = surface;
+  PhocView *view;
+  double dx = 0, dy = 0;
+
+  while (TRUE) {
+    struct wlr_subsurface *subsurface = wlr_subsurface_try_from_wlr_surface (root);
+    struct wlr_xdg_popup *popup;
+
+    if (subsurface) {
+      dx += subsurface->current.x;
+      dy += subsurface->current.y;
+      root = subsurface->parent;
+      continue;
+    }
+
+    popup = wlr_xdg_popup_try_from_wlr_surface (root);
+    if (popup && popup->parent) {
+      double px, py;
+
+      wlr_xdg_popup_get_position (popup, &px, &py);
+      dx += px;
+      dy += py;
+      root = popup->parent;
+      continue;
+    }
+
+    break;
+  }
+
+  wlr_layer_surface = wlr_layer_surface_v1_try_from_wlr_surface (root);
+  if (wlr_layer_surface) {
+    PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+    PhocLayerSurface *layer_surface = wlr_layer_surface->data;
+    PhocOutput *output;
+    struct wlr_box output_box;
+
+    if (!layer_surface)
+      return FALSE;
+
+    output = phoc_layer_surface_get_output (layer_surface);
+    if (!output)
+      return FALSE;
+
+    wlr_output_layout_get_box (desktop->layout, output->wlr_output, &output_box);
+    *scale = 1.0;
+    *x = output_box.x + layer_surface->geo.x + dx;
+    *y = output_box.y + layer_surface->geo.y + dy;
+    return TRUE;
+  }
+
+  view = phoc_view_from_wlr_surface (root);
+  if (view) {
+    *scale = phoc_view_get_scale (view);
+    *x = view->box.x + dx;
+    *y = view->box.y + dy;
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+
 void
 phoc_cursor_handle_touch_motion (PhocCursor                    *self,
                                  struct wlr_touch_motion_event *event)
@@ -1647,71 +1906,21 @@ phoc_cursor_handle_touch_motion (PhocCursor                    *self,
 
   // TODO: test with input regions
   if (surface) {
-    bool found = false;
-    float scale = 1.0;
-
-    struct wlr_surface *root = wlr_surface_get_root_surface (surface);
-    struct wlr_layer_surface_v1 *wlr_layer_surface = wlr_layer_surface_v1_try_from_wlr_surface (root);
-    if (wlr_layer_surface) {
-
-      struct wlr_box output_box;
-      wlr_output_layout_get_box (desktop->layout, output->wlr_output, &output_box);
-
-      PhocLayerSurface *layer_surface;
-      wl_list_for_each_reverse (layer_surface, &output->layer_surfaces, link)
-      {
-        if (layer_surface->layer != wlr_layer_surface->current.layer)
-          continue;
-
-        if (layer_surface->layer_surface->surface == root) {
-          sx = lx - layer_surface->geo.x - output_box.x;
-          sy = ly - layer_surface->geo.y - output_box.y;
-          found = true;
-          break;
-        }
-      }
-      // try the overlay layer as well since the on-screen keyboard might have been elevated there
-      wl_list_for_each_reverse (layer_surface, &output->layer_surfaces, link)
-      {
-        if (layer_surface->layer != ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY)
-          continue;
-
-        if (layer_surface->layer_surface->surface == root) {
-          sx = lx - layer_surface->geo.x - output_box.x;
-          sy = ly - layer_surface->geo.y - output_box.y;
-          found = true;
-          break;
-        }
-      }
-      g_assert (found);
-    } else {
-      PhocView *view = phoc_view_from_wlr_surface (root);
-      if (view) {
-        scale = phoc_view_get_scale (view);
-        sx = lx / scale - view->box.x;
-        sy = ly / scale - view->box.y;
-        found = true;
-      } else {
-        // FIXME: buggy fallback, but at least handles xdg_popups for now...
-        surface = phoc_desktop_wlr_surface_at (desktop, lx, ly, &sx, &sy, NULL);
-      }
-    }
+    gboolean have_coords;
 
-    if (found) {
-      struct wlr_surface *sub = surface;
-      while (sub) {
-        struct wlr_subsurface *subsurface = wlr_subsurface_try_from_wlr_surface (sub);
-        if (subsurface == NULL)
-          break;
+    /* Only recalculate when something moved since the last event */
+    have_coords = phoc_touch_point_get_surface_coords (touch_point, surface, &sx, &sy);
+    if (!have_coords) {
+      double scale, x, y;
 
-        sx -= subsurface->current.x;
-        sy -= subsurface->current.y;
-        sub = subsurface->parent;
+      if (get_surface_layout_transform (surface, &scale, &x, &y)) {
+        phoc_touch_point_set_transform (touch_point, surface, scale, x, y);
+        have_coords = phoc_touch_point_get_surface_coords (touch_point, surface, &sx, &sy);
       }
     }
 
-    if (phoc_seat_allow_input (self->seat, surface->resource))
-      send_touch_motion (self->seat, surface, event, sx, sy);
+    if (have_coords && phoc_seat_allow_input (self->seat, surface->resource))
+      queue_touch_motion (self, touch_point, surface, event->time_msec, sx, sy);
   }
 
   if (event->touch_id == self->seat->touch_id) {
@@ -1733,12 +1942,13 @@ static void
 handle_touch_frame (struct wl_listener *listener, void *data)
 {
   PhocCursor *self = PHOC_CURSOR (wl_container_of (listener, self, touch_frame));
-  struct wlr_seat *wlr_seat = self->seat->seat;
+  PhocCursorPrivate *priv = phoc_cursor_get_instance_private (self);
 
-  wlr_seat_touch_notify_frame(wlr_seat);
+  /* Terminate the coalesced motion's frame when it gets flushed */
+  if (phoc_motion_queue_push_frame (priv->touch_queue))
+    return;
 
-  // make sure to always send frame events when necessary even when bypassing seat grabs
-  wlr_seat_touch_send_frame (wlr_seat);
+  send_touch_frame (self);
 }
 
 
@@ -2131,3 +2341,63 @@ phoc_cursor_get_touch_points (PhocCursor *self)
 
   return priv->touch_points;
 }
+
+/**
+ * phoc_cursor_flush_motion:
+ * @self: The cursor
+ *
+ * Sends pointer and touch motion that got coalesced since the last
+ * flush to the clients. This is invoked at output frame boundaries so
+ * clients see at most one motion event per touch point and pointer
+ * per frame. Buttons, axis, touch down and up events flush the
+ * pending motion too, so the order of events is kept.
+ */
+void
+phoc_cursor_flush_motion (PhocCursor *self)
+{
+  g_assert (PHOC_IS_CURSOR (self));
+
+  flush_pointer_motion (self);
+  flush_touch_motion (self);
+}
+
+/**
+ * phoc_cursor_get_motion_stats:
+ * @self: The cursor
+ * @n_events:(out)(nullable): The number of motion events destined for clients
+ * @n_sent:(out)(nullable): The number of motion events actually sent
+ *
+ * Gets the motion statistics since the cursor got created or the last
+ * reset. The ratio of the two values is the achieved coalescing ratio.
+ */
+void
+phoc_cursor_get_motion_stats (PhocCursor *self, guint64 *n_events, guint64 *n_sent)
+{
+  PhocCursorPrivate *priv;
+
+  g_assert (PHOC_IS_CURSOR (self));
+  priv = phoc_cursor_get_instance_private (self);
+
+  if (n_events)
+    *n_events = priv->n_motion_events;
+  if (n_sent)
+    *n_sent = priv->n_motion_sent;
+}
+
+/**
+ * phoc_cursor_reset_motion_stats:
+ * @self: The cursor
+ *
+ * Resets the motion statistics.
+ */
+void
+phoc_cursor_reset_motion_stats (PhocCursor *self)
+{
+  PhocCursorPrivate *priv;
+
+  g_assert (PHOC_IS_CURSOR (self));
+  priv = phoc_cursor_get_instance_private (self);
+
+  priv->n_motion_events = 0;
+  priv->n_motion_sent = 0;
+}
@@ -146,4 +146,8 @@ void        phoc_cursor_configure_xcursor (PhocCursor *self);
 
 GHashTable *phoc_cursor_get_touch_points (PhocCursor *self);
 
+void        phoc_cursor_flush_motion (PhocCursor *self);
+void        phoc_cursor_get_motion_stats (PhocCursor *self, guint64 *n_events, guint64 *n_sent);
+void        phoc_cursor_reset_motion_stats (PhocCursor *self);
+
 G_END_DECLS
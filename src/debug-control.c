@@ -11,6 +11,11 @@
 #include "phoc-config.h"
 #include "phoc-enums.h"
 #include "debug-control.h"
+#include "desktop.h"
+#include "cursor.h"
+#include "frame-stats.h"
+#include "output.h"
+#include "seat.h"
 #include "server.h"
 
 #include <gio/gio.h>
@@ -35,6 +40,7 @@ static GParamSpec *props[PROP_LAST_PROP];
 struct _PhocDebugControl {
   PhocDBusDebugControlSkeleton parent;
 
+  PhocServer                  *server;
   guint                        dbus_name_id;
   gboolean                     exported;
 };
@@ -46,9 +52,109 @@ G_DEFINE_TYPE_WITH_CODE (PhocDebugControl, phoc_debug_control,
                          G_IMPLEMENT_INTERFACE (PHOC_DBUS_TYPE_DEBUG_CONTROL,
                                                 phoc_dbus_debug_control_iface_init))
 
+static gboolean
+handle_get_frame_stats (PhocDBusDebugControl  *object,
+                        GDBusMethodInvocation *invocation)
+{
+  PhocDebugControl *self = PHOC_DEBUG_CONTROL (object);
+  PhocDesktop *desktop = phoc_server_get_desktop (self->server);
+  GVariantBuilder builder;
+  PhocOutput *output;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+  /* No outputs yet during startup */
+  if (desktop) {
+    wl_list_for_each (output, &desktop->outputs, link) {
+      PhocFrameStats *stats = phoc_output_get_frame_stats (output);
+
+      g_variant_builder_add (&builder, "{s@a{sv}}",
+                             phoc_output_get_name (output),
+                             phoc_frame_stats_to_variant (stats));
+    }
+  }
+
+  phoc_dbus_debug_control_complete_get_frame_stats (object,
+                                                    invocation,
+                                                    g_variant_builder_end (&builder));
+  return TRUE;
+}
+
+
+static gboolean
+handle_reset_frame_stats (PhocDBusDebugControl  *object,
+                          GDBusMethodInvocation *invocation)
+{
+  PhocDebugControl *self = PHOC_DEBUG_CONTROL (object);
+  PhocDesktop *desktop = phoc_server_get_desktop (self->server);
+  PhocOutput *output;
+
+  if (desktop) {
+    wl_list_for_each (output, &desktop->outputs, link)
+      phoc_frame_stats_reset (phoc_output_get_frame_stats (output));
+  }
+
+  phoc_dbus_debug_control_complete_reset_frame_stats (object, invocation);
+  return TRUE;
+}
+
+
+static gboolean
+handle_get_input_stats (PhocDBusDebugControl  *object,
+                        GDBusMethodInvocation *invocation)
+{
+  PhocDebugControl *self = PHOC_DEBUG_CONTROL (object);
+  PhocInput *input = phoc_server_get_input (self->server);
+  GVariantBuilder builder;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+  for (GSList *l = input ? phoc_input_get_seats (input) : NULL; l; l = l->next) {
+    PhocSeat *seat = PHOC_SEAT (l->data);
+    GVariantBuilder stats;
+    guint64 n_events, n_sent;
+
+    if (seat->cursor == NULL)
+      continue;
+
+    phoc_cursor_get_motion_stats (seat->cursor, &n_events, &n_sent);
+    g_variant_builder_init (&stats, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (&stats, "{sv}", "motion-events", g_variant_new_uint64 (n_events));
+    g_variant_builder_add (&stats, "{sv}", "motion-sent", g_variant_new_uint64 (n_sent));
+    g_variant_builder_add (&builder, "{sa{sv}}", seat->seat->name, &stats);
+  }
+
+  phoc_dbus_debug_control_complete_get_input_stats (object,
+                                                    invocation,
+                                                    g_variant_builder_end (&builder));
+  return TRUE;
+}
+
+
+static gboolean
+handle_reset_input_stats (PhocDBusDebugControl  *object,
+                          GDBusMethodInvocation *invocation)
+{
+  PhocDebugControl *self = PHOC_DEBUG_CONTROL (object);
+  PhocInput *input = phoc_server_get_input (self->server);
+
+  for (GSList *l = input ? phoc_input_get_seats (input) : NULL; l; l = l->next) {
+    PhocSeat *seat = PHOC_SEAT (l->data);
+
+    if (seat->cursor)
+      phoc_cursor_reset_motion_stats (seat->cursor);
+  }
+
+  phoc_dbus_debug_control_complete_reset_input_stats (object, invocation);
+  return TRUE;
+}
+
+
 static void
 phoc_dbus_debug_control_iface_init (PhocDBusDebugControlIface *iface)
 {
+  iface->handle_get_frame_stats = handle_get_frame_stats;
+  iface->handle_reset_frame_stats = handle_reset_frame_stats;
+  iface->handle_get_input_stats = handle_get_input_stats;
+  iface->handle_reset_input_stats = handle_reset_input_stats;
 }
 
 
@@ -117,6 +223,8 @@ phoc_debug_control_set_server (PhocDebugControl *self, PhocServer *server)
     PHOC_SERVER_DEBUG_FLAG_DAMAGE_WHOLE,
   };
 
+  self->server = server;
+
   eclass = G_FLAGS_CLASS (g_type_class_ref (phoc_server_debug_flags_get_type ()));
   for (int i = 0; i < G_N_ELEMENTS (exported); i++) {
     PhocServerDebugFlags flag = exported[i];
@@ -231,6 +339,8 @@ phoc_debug_control_class_init (PhocDebugControlClass *klass)
 static void
 phoc_debug_control_init (PhocDebugControl *self)
 {
+  phoc_dbus_debug_control_set_frame_stats_window_size (PHOC_DBUS_DEBUG_CONTROL (self),
+                                                       phoc_frame_stats_get_window_size ());
 }
 
 
@@ -9,6 +9,7 @@
 #include <time.h>
 #include <wlr/config.h>
 #include <wlr/types/wlr_alpha_modifier_v1.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_cursor.h>
 #include <wlr/types/wlr_data_control_v1.h>
@@ -36,6 +37,7 @@
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/util/box.h>
 
+#include "bling.h"
 #include "cursor.h"
 #include "desktop-xwayland.h"
 #include "device-state.h"
@@ -45,6 +47,7 @@
 #include "seat.h"
 #include "server.h"
 #include "shortcuts-inhibit.h"
+#include "spatial-index.h"
 #include "color-rect.h"
 #include "timed-animation.h"
 #include "outputs-states.h"
@@ -87,6 +90,9 @@ static GParamSpec *props[PROP_LAST_PROP];
 
 typedef struct _PhocDesktopPrivate {
   GQueue                *views;
+  PhocSpatialIndex      *view_index;
+  GPtrArray             *hits;
+  gboolean               visibility_dirty;
 
   PhocIdleInhibit       *idle_inhibit;
 
@@ -115,6 +121,8 @@ typedef struct _PhocDesktopPrivate {
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhocDesktop, phoc_desktop, G_TYPE_OBJECT);
 
+static void ensure_visibility (PhocDesktop *self);
+
 
 static void
 phoc_desktop_set_property (GObject      *object,
@@ -196,28 +204,54 @@ desktop_view_at (PhocDesktop         *self,
                  double              *sx,
                  double              *sy)
 {
-  for (GList *l = phoc_desktop_get_views (self)->head; l; l = l->next) {
-    PhocView *view = PHOC_VIEW (l->data);
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  PhocView *found = NULL;
+
+  /* Candidates are sorted top to bottom */
+  g_ptr_array_set_size (priv->hits, 0);
+  phoc_spatial_index_query (priv->view_index, lx, ly, priv->hits);
+
+  /* Bring the cached visibility up to date once for all candidates */
+  ensure_visibility (self);
+
+  for (guint i = 0; i < priv->hits->len; i++) {
+    PhocView *view = PHOC_VIEW (g_ptr_array_index (priv->hits, i));
 
-    if (phoc_desktop_view_check_visibility (self, view) && view_at (view, lx, ly, surface, sx, sy))
-      return view;
+    if (phoc_view_get_visible_outputs (view) && view_at (view, lx, ly, surface, sx, sy)) {
+      found = view;
+      break;
+    }
   }
-  return NULL;
+
+  g_ptr_array_set_size (priv->hits, 0);
+  return found;
 }
 
 static struct wlr_surface *
-layer_surface_at (PhocOutput                     *output,
+layer_surface_at (PhocDesktop                    *self,
+                  PhocOutput                     *output,
                   enum zwlr_layer_shell_v1_layer  layer,
                   double                          ox,
                   double                          oy,
                   double                         *sx,
                   double                         *sy)
 {
-  GQueue *layer_surfaces = phoc_output_get_layer_surfaces_for_layer (output, layer);
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  struct wlr_surface *sub = NULL;
+  GQueue *layer_surfaces;
 
-  for (GList *l = layer_surfaces->tail; l; l = l->prev) {
+  g_ptr_array_set_size (priv->hits, 0);
+  phoc_output_query_layer_surfaces (output, ox, oy, priv->hits);
+  if (priv->hits->len == 0)
+    return NULL;
+
+  /* Only few layer surfaces overlap so use the layer's stacking to find the topmost */
+  layer_surfaces = phoc_output_get_layer_surfaces_for_layer (output, layer);
+  for (GList *l = layer_surfaces->tail; l && !sub; l = l->prev) {
     PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
-    struct wlr_surface *sub;
+
+    if (!g_ptr_array_find (priv->hits, layer_surface, NULL))
+      continue;
 
     if (!phoc_layer_surface_get_mapped (layer_surface))
       continue;
@@ -226,11 +260,10 @@ layer_surface_at (PhocOutput                     *output,
     double _sy = oy - layer_surface->geo.y;
 
     sub = wlr_layer_surface_v1_surface_at (layer_surface->layer_surface, _sx, _sy, sx, sy);
-    if (sub)
-      return sub;
   }
 
-  return NULL;
+  g_ptr_array_set_size (priv->hits, 0);
+  return sub;
 }
 
 /**
@@ -267,13 +300,13 @@ phoc_desktop_wlr_surface_at (PhocDesktop *desktop,
 
   /* Layers above regular views */
   if (output) {
-    surface = layer_surface_at (output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, ox, oy, sx, sy);
+    surface = layer_surface_at (desktop, output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, ox, oy, sx, sy);
     if (surface)
       return surface;
 
     if (output->fullscreen_view) {
       if (phoc_output_has_shell_revealed (output)) {
-        surface = layer_surface_at (output, ZWLR_LAYER_SHELL_V1_LAYER_TOP, ox, oy, sx, sy);
+        surface = layer_surface_at (desktop, output, ZWLR_LAYER_SHELL_V1_LAYER_TOP, ox, oy, sx, sy);
         if (surface)
           return surface;
       }
@@ -287,7 +320,7 @@ phoc_desktop_wlr_surface_at (PhocDesktop *desktop,
       }
     }
 
-    surface = layer_surface_at (output, ZWLR_LAYER_SHELL_V1_LAYER_TOP, ox, oy, sx, sy);
+    surface = layer_surface_at (desktop, output, ZWLR_LAYER_SHELL_V1_LAYER_TOP, ox, oy, sx, sy);
     if (surface)
       return surface;
   }
@@ -302,11 +335,11 @@ phoc_desktop_wlr_surface_at (PhocDesktop *desktop,
 
   /* Layers below regular views */
   if (output) {
-    surface = layer_surface_at (output, ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, ox, oy, sx, sy);
+    surface = layer_surface_at (desktop, output, ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, ox, oy, sx, sy);
     if (surface)
       return surface;
 
-    surface = layer_surface_at (output, ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, ox, oy, sx, sy);
+    surface = layer_surface_at (desktop, output, ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, ox, oy, sx, sy);
     if (surface)
       return surface;
   }
@@ -314,76 +347,345 @@ phoc_desktop_wlr_surface_at (PhocDesktop *desktop,
   return NULL;
 }
 
-/**
- * phoc_desktop_view_check_visibility:
- * @self: The desktop
- * @view: The view to check
- *
- * Checks if a view is currently visible. This is currently very
- * pessimistic and only assumes that the view is not visible when
- * we're certain it is covered by other windows.
- *
- * Returns: `FALSE` when it's certain that the view is not visible, otherwise `TRUE`
+typedef struct {
+  pixman_region32_t *bounds;
+  pixman_region32_t *opaque;
+  float              alpha;
+} ViewRegionData;
+
+
+static void
+view_region_iterator (PhocOutput         *output,
+                      struct wlr_surface *surface,
+                      struct wlr_box     *box,
+                      float               scale,
+                      void               *user_data)
+{
+  ViewRegionData *data = user_data;
+  const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+  struct wlr_box surface_box = *box;
+  float alpha = data->alpha;
+
+  phoc_utils_scale_box (&surface_box, scale);
+
+  if (data->bounds) {
+    pixman_region32_union_rect (data->bounds, data->bounds,
+                                surface_box.x, surface_box.y,
+                                surface_box.width, surface_box.height);
+  }
+
+  if (data->opaque == NULL)
+    return;
+
+  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+  if (alpha_modifier_state)
+    alpha *= (float)alpha_modifier_state->multiplier;
+
+  if (!G_APPROX_VALUE (alpha, 1.0, FLT_EPSILON))
+    return;
+
+  if (surface->buffer && wlr_buffer_is_opaque (&surface->buffer->base)) {
+    pixman_region32_union_rect (data->opaque, data->opaque,
+                                surface_box.x, surface_box.y,
+                                surface_box.width, surface_box.height);
+  } else {
+    pixman_region32_t opaque;
+
+    pixman_region32_init (&opaque);
+    phoc_utils_scale_opaque_region (&opaque, &surface->opaque_region, box->x, box->y, scale);
+    pixman_region32_intersect_rect (&opaque, &opaque,
+                                    surface_box.x, surface_box.y,
+                                    surface_box.width, surface_box.height);
+    pixman_region32_union (data->opaque, data->opaque, &opaque);
+    pixman_region32_fini (&opaque);
+  }
+}
+
+/*
+ * Get the area a view's surfaces and blings cover (bounds) and the
+ * part of it that is opaque in output local coordinates.
  */
-gboolean
-phoc_desktop_view_check_visibility (PhocDesktop *self, PhocView *view)
+static void
+view_get_output_region (PhocView          *view,
+                        PhocOutput        *output,
+                        pixman_region32_t *bounds,
+                        pixman_region32_t *opaque)
 {
-  PhocDesktopPrivate *priv;
-  PhocOutput *output;
-  PhocView *top_view;
-  GQueue *layer_surfaces;
-  gboolean visible = TRUE;
+  ViewRegionData data = {
+    .bounds = bounds,
+    .opaque = opaque,
+    .alpha = phoc_view_get_alpha (view),
+  };
 
-  g_assert (PHOC_IS_DESKTOP (self));
-  g_assert (PHOC_IS_VIEW (view));
+  phoc_output_view_for_each_surface (output, view, view_region_iterator, &data);
 
-  priv = phoc_desktop_get_instance_private (self);
+  if (bounds == NULL)
+    return;
+
+  for (GSList *l = phoc_view_get_blings (view); l; l = l->next) {
+    PhocBling *bling = PHOC_BLING (l->data);
+    struct wlr_box output_box;
+    PhocBox box;
+
+    if (!phoc_bling_is_mapped (bling))
+      continue;
+
+    wlr_output_layout_get_box (output->desktop->layout, output->wlr_output, &output_box);
+    box = phoc_bling_get_box (bling);
+    pixman_region32_union_rect (bounds, bounds,
+                                box.x - output_box.x, box.y - output_box.y,
+                                box.width, box.height);
+  }
+}
+
+
+/*
+ * Whether the view is hidden on the output by a fullscreen view, a
+ * covering overlay layer surface or a maximized view above. Sets
+ * `unoccluded` if the view is visible regardless of opaque views above.
+ */
+static gboolean
+view_is_hidden_on_output (PhocDesktop *self,
+                          PhocView    *view,
+                          PhocOutput  *output,
+                          PhocView    *top_view,
+                          gboolean     covered,
+                          gboolean    *unoccluded)
+{
+  *unoccluded = FALSE;
+
+  if (output->fullscreen_view) {
+    PhocView *fullscreen_view = output->fullscreen_view;
+
+    *unoccluded = TRUE;
+    if (fullscreen_view == view)
+      return FALSE;
+
+    if (PHOC_IS_XWAYLAND_SURFACE (fullscreen_view) && PHOC_IS_XWAYLAND_SURFACE (view)) {
+      return !phoc_xwayland_surface_is_child (PHOC_XWAYLAND_SURFACE (view),
+                                              PHOC_XWAYLAND_SURFACE (fullscreen_view));
+    }
+
+    return TRUE;
+  }
+
+  /* Views fullscreened on other outputs aren't rendered here */
+  if (phoc_view_is_fullscreen (view) && phoc_view_get_fullscreen_output (view) != output)
+    return TRUE;
+
+  if (covered)
+    return TRUE;
+
+  if (top_view) {
+    /* XWayland parent relations can be complicated and aren't described by PhocView
+     * relationships very well at the moment, so just make all XWayland windows visible
+     * when some XWayland window is active for now */
+    if (PHOC_IS_XWAYLAND_SURFACE (view) && PHOC_IS_XWAYLAND_SURFACE (top_view)) {
+      *unoccluded = TRUE;
+      return FALSE;
+    }
+
+    for (PhocView *v = top_view; v; v = v->parent) {
+      if (v == view)
+        break;
 
-  if (!phoc_view_is_mapped (view)) {
-    visible = FALSE;
-    goto out;
+      if (phoc_view_is_maximized (v))
+        return TRUE;
+    }
   }
 
-  g_assert_true (priv->views->head);
+  return FALSE;
+}
 
-  /* current heuristics work well only for single output */
-  if (wl_list_length (&self->outputs) != 1)
-    goto out;
+/*
+ * Walk the views front to back and determine which ones remain visible
+ * on the output after removing what's covered by opaque views above.
+ * The output's mask is added to `visible_outputs` (indexed by stack
+ * position) of the visible ones.
+ */
+static void
+update_output_visibility (PhocDesktop *self, PhocOutput *output, guint32 *visible_outputs)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  guint32 mask = phoc_output_get_mask (output);
+  struct wlr_box output_box = { 0 };
+  pixman_region32_t occluded, region, opaque;
+  PhocView *top_view = NULL;
+  GQueue *layer_surfaces;
+  gboolean covered = FALSE;
+  guint i = 0;
 
-  output = wl_container_of (self->outputs.next, output, link);
   layer_surfaces = phoc_output_get_layer_surfaces_for_layer (output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY);
   for (GList *l = layer_surfaces->head; l; l = l->next) {
-    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
+    if (phoc_layer_surface_covers_output (PHOC_LAYER_SURFACE (l->data))) {
+      covered = TRUE;
+      break;
+    }
+  }
 
-    if (phoc_layer_surface_covers_output (layer_surface)) {
-      visible = FALSE;
-      goto out;
+  /* Views in the stack above that are maximized on this output hide the view */
+  if (self->maximize) {
+    for (GList *l = priv->views->head; l; l = l->next) {
+      struct wlr_box box;
+
+      phoc_view_get_box (PHOC_VIEW (l->data), &box);
+      if (wlr_output_layout_intersects (self->layout, output->wlr_output, &box)) {
+        top_view = PHOC_VIEW (l->data);
+        break;
+      }
     }
   }
 
-  if (!self->maximize)
-    goto out;
+  wlr_output_effective_resolution (output->wlr_output, &output_box.width, &output_box.height);
+  pixman_region32_init (&occluded);
+  pixman_region32_init (&region);
+  pixman_region32_init (&opaque);
+
+  for (GList *l = priv->views->head; l; l = l->next, i++) {
+    PhocView *view = PHOC_VIEW (l->data);
+    gboolean unoccluded, visible;
+
+    if (!phoc_view_is_mapped (view))
+      continue;
 
-  top_view = phoc_desktop_get_view_by_index (self, 0);
-  /* XWayland parent relations can be complicated and aren't described by PhocView
-   * relationships very well at the moment, so just make all XWayland windows visible
-   * when some XWayland window is active for now */
-  if (PHOC_IS_XWAYLAND_SURFACE (view) && PHOC_IS_XWAYLAND_SURFACE (top_view))
-    goto out;
+    if (phoc_view_is_fullscreen (view) && phoc_view_get_fullscreen_output (view) != output)
+      continue;
 
-  for (PhocView *v = top_view; v; v = v->parent) {
-    if (v == view)
-      goto out;
+    pixman_region32_clear (&region);
+    pixman_region32_clear (&opaque);
+    view_get_output_region (view, output, &region, &opaque);
 
-    if (phoc_view_is_maximized (v)) {
+    if (view_is_hidden_on_output (self, view, output, top_view, covered, &unoccluded)) {
       visible = FALSE;
-      goto out;
+    } else if (unoccluded) {
+      visible = TRUE;
+    } else {
+      /* Check if anything of the view remains after removing what's covered by opaque views above */
+      pixman_region32_intersect_rect (&region, &region,
+                                      output_box.x, output_box.y,
+                                      output_box.width, output_box.height);
+      pixman_region32_subtract (&region, &region, &occluded);
+      visible = pixman_region32_not_empty (&region);
+    }
+
+    if (visible) {
+      /* Can't track this output, assume the view is visible everywhere */
+      visible_outputs[i] |= mask ? mask : G_MAXUINT32;
     }
+
+    pixman_region32_union (&occluded, &occluded, &opaque);
   }
 
- out:
-  phoc_view_set_visibility (view, visible);
-  return visible;
+  pixman_region32_fini (&opaque);
+  pixman_region32_fini (&region);
+  pixman_region32_fini (&occluded);
+}
+
+/*
+ * Recompute the visible outputs of all views if anything affecting
+ * visibility changed since the last time.
+ */
+static void
+ensure_visibility (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  g_autofree guint32 *visible_outputs = NULL;
+  PhocOutput *output;
+  guint i = 0;
+
+  if (!priv->visibility_dirty)
+    return;
+
+  /* Cleared first as updating the views' visibility can invalidate it again */
+  priv->visibility_dirty = FALSE;
+
+  visible_outputs = g_new0 (guint32, g_queue_get_length (priv->views));
+  wl_list_for_each (output, &self->outputs, link)
+    update_output_visibility (self, output, visible_outputs);
+
+  for (GList *l = priv->views->head; l; l = l->next, i++)
+    phoc_view_set_visible_outputs (PHOC_VIEW (l->data), visible_outputs[i]);
+}
+
+/**
+ * phoc_desktop_invalidate_visibility:
+ * @self: The desktop
+ *
+ * Marks the visibility of all views as outdated. It's recomputed on
+ * the next visibility check. This needs to be invoked whenever the
+ * view stack, a view's geometry, opacity, fullscreen or maximized
+ * state, a covering overlay layer surface or the output layout
+ * changes.
+ */
+void
+phoc_desktop_invalidate_visibility (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv;
+
+  g_assert (PHOC_IS_DESKTOP (self));
+  priv = phoc_desktop_get_instance_private (self);
+
+  priv->visibility_dirty = TRUE;
+}
+
+/**
+ * phoc_desktop_view_check_visibility:
+ * @self: The desktop
+ * @view: The view to check
+ *
+ * Checks on which outputs a view is currently visible. A view is
+ * visible on an output when it intersects the output and isn't fully
+ * covered by opaque views above it, a covering overlay layer surface
+ * or a fullscreen view. The views' visible outputs are only
+ * recomputed if the visibility got invalidated via
+ * [method@Desktop.invalidate_visibility]. See
+ * [method@View.get_visible_outputs].
+ *
+ * Returns: `FALSE` when it's certain that the view is not visible on
+ *   any output, otherwise `TRUE`
+ */
+gboolean
+phoc_desktop_view_check_visibility (PhocDesktop *self, PhocView *view)
+{
+  g_assert (PHOC_IS_DESKTOP (self));
+  g_assert (PHOC_IS_VIEW (view));
+
+  ensure_visibility (self);
+
+  /* Views not in the stack (e.g. while unmapping) aren't visible */
+  if (!phoc_view_is_mapped (view))
+    return FALSE;
+
+  return !!phoc_view_get_visible_outputs (view);
+}
+
+/**
+ * phoc_desktop_view_is_visible_on_output:
+ * @self: The desktop
+ * @view: The view to check
+ * @output: The output to check
+ *
+ * Checks if a view is currently visible on the given output. See
+ * [method@Desktop.view_check_visibility].
+ *
+ * Returns: `FALSE` when it's certain that the view is not visible on
+ *   `output`, otherwise `TRUE`
+ */
+gboolean
+phoc_desktop_view_is_visible_on_output (PhocDesktop *self, PhocView *view, PhocOutput *output)
+{
+  guint32 mask;
+
+  g_assert (PHOC_IS_OUTPUT (output));
+
+  if (!phoc_desktop_view_check_visibility (self, view))
+    return FALSE;
+
+  mask = phoc_output_get_mask (output);
+  if (mask == 0)
+    return TRUE;
+
+  return !!(phoc_view_get_visible_outputs (view) & mask);
 }
 
 
@@ -418,6 +720,8 @@ handle_layout_change (struct wl_listener *listener, void *data)
   PhocOutput *output;
 
   self = wl_container_of (listener, self, layout_change);
+  phoc_desktop_invalidate_visibility (self);
+
   center_output = wlr_output_layout_get_center_output (self->layout);
   if (center_output == NULL)
     return;
@@ -730,6 +1034,8 @@ phoc_desktop_finalize (GObject *object)
   PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
 
   g_clear_pointer (&priv->views, g_queue_free);
+  g_clear_object (&priv->view_index);
+  g_clear_pointer (&priv->hits, g_ptr_array_unref);
 
   wl_list_remove (&priv->gamma_control_set_gamma.link);
   wl_list_remove (&self->layout_change.link);
@@ -801,6 +1107,9 @@ phoc_desktop_init (PhocDesktop *self)
 
   priv = phoc_desktop_get_instance_private (self);
   priv->views = g_queue_new ();
+  priv->view_index = phoc_spatial_index_new ();
+  priv->hits = g_ptr_array_new ();
+  priv->visibility_dirty = TRUE;
   priv->enable_animations = TRUE;
 
   self->input_output_map = g_hash_table_new_full (g_str_hash,
@@ -862,6 +1171,7 @@ phoc_desktop_set_auto_maximize (PhocDesktop *self, gboolean enable)
 
   g_debug ("auto-maximize: %d", enable);
   self->maximize = enable;
+  phoc_desktop_invalidate_visibility (self);
 
   phoc_desktop_for_each_view (self,
                               toggle_auto_max_iterator,
@@ -1215,6 +1525,19 @@ phoc_desktop_get_views (PhocDesktop *self)
   return priv->views;
 }
 
+/* Keep the hit testing order in sync with the view stack */
+static void
+update_view_stacking (PhocDesktop *self)
+{
+  PhocDesktopPrivate *priv = phoc_desktop_get_instance_private (self);
+  guint order = g_queue_get_length (priv->views);
+
+  for (GList *l = priv->views->head; l; l = l->next)
+    phoc_spatial_index_set_order (priv->view_index, l->data, order--);
+
+  priv->visibility_dirty = TRUE;
+}
+
 /**
  * phoc_desktop_move_view_to_top:
  * @self: the desktop
@@ -1251,6 +1574,7 @@ phoc_desktop_move_view_to_top (PhocDesktop *self, PhocView *view)
     g_queue_insert_before_link (priv->views, l, view_link);
   }
 
+  update_view_stacking (self);
   phoc_view_damage_whole (view);
 }
 
@@ -1331,7 +1655,45 @@ phoc_desktop_remove_view (PhocDesktop *self, PhocView *view)
   g_assert (PHOC_IS_DESKTOP (self));
   priv = phoc_desktop_get_instance_private (self);
 
-  return g_queue_remove (priv->views, view);
+  phoc_spatial_index_remove (priv->view_index, view);
+  if (!g_queue_remove (priv->views, view))
+    return FALSE;
+
+  priv->visibility_dirty = TRUE;
+  phoc_view_set_visible_outputs (view, 0);
+  return TRUE;
+}
+
+/**
+ * phoc_desktop_update_view_bounds:
+ * @self: the desktop
+ * @view: The view to update
+ *
+ * Updates the view's input bounds in the index used for hit
+ * testing. This needs to be invoked whenever the view or one of its
+ * popups or subsurfaces changes position or size.
+ */
+void
+phoc_desktop_update_view_bounds (PhocDesktop *self, PhocView *view)
+{
+  PhocDesktopPrivate *priv;
+  struct wlr_box bounds;
+  guint n_items;
+
+  g_assert (PHOC_IS_DESKTOP (self));
+  priv = phoc_desktop_get_instance_private (self);
+
+  /* Only views in the stack take part in hit testing */
+  if (!g_queue_find (priv->views, view))
+    return;
+
+  n_items = phoc_spatial_index_get_n_items (priv->view_index);
+  phoc_view_get_input_bounds (view, &bounds);
+  if (phoc_spatial_index_update (priv->view_index, view, &bounds))
+    priv->visibility_dirty = TRUE;
+
+  if (phoc_spatial_index_get_n_items (priv->view_index) > n_items)
+    update_view_stacking (self);
 }
 
 /**
@@ -125,6 +125,8 @@ void                    phoc_desktop_insert_view                  (PhocDesktop *
                                                                    PhocView    *view);
 gboolean                phoc_desktop_remove_view                  (PhocDesktop *self,
                                                                    PhocView    *view);
+void                    phoc_desktop_update_view_bounds           (PhocDesktop *self,
+                                                                   PhocView    *view);
 void                    phoc_desktop_for_each_view                (PhocDesktop        *self,
                                                                    PhocDesktopViewIter view_iter,
                                                                    gpointer            user_data);
@@ -153,8 +155,12 @@ struct wlr_surface *    phoc_desktop_wlr_surface_at               (PhocDesktop *
                                                                   double      *sx,
                                                                   double      *sy,
                                                                   PhocView   **view);
+void                    phoc_desktop_invalidate_visibility       (PhocDesktop *self);
 gboolean                phoc_desktop_view_check_visibility       (PhocDesktop *self,
                                                                   PhocView    *view);
+gboolean                phoc_desktop_view_is_visible_on_output   (PhocDesktop *self,
+                                                                  PhocView    *view,
+                                                                  PhocOutput  *output);
 void                    phoc_desktop_set_view_always_on_top      (PhocDesktop *self,
                                                                   PhocView    *view,
                                                                   gboolean     on_top);
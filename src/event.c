@@ -23,13 +23,22 @@
 typedef struct _PhocEventPrivate {
   PhocEvent base;
 
-  gpointer unused;
+  grefcount ref_count;
 } PhocEventPrivate;
 
+/* Input events are created at a high rate (e.g. for every touch
+ * motion) but usually dropped right away. Keep some around for reuse
+ * rather than hitting the allocator each time. Events are only
+ * created and released on the main thread. */
+#define PHOC_EVENT_POOL_SIZE 16
+
+static PhocEventPrivate *event_pool[PHOC_EVENT_POOL_SIZE];
+static guint event_pool_len;
+
 
 G_DEFINE_BOXED_TYPE (PhocEvent, phoc_event,
-                     phoc_event_copy,
-                     phoc_event_free);
+                     phoc_event_ref,
+                     phoc_event_unref);
 
 static PhocEventSequence *
 phoc_event_sequence_copy (PhocEventSequence *sequence)
@@ -48,9 +57,37 @@ G_DEFINE_BOXED_TYPE (PhocEventSequence, phoc_event_sequence,
                      phoc_event_sequence_copy,
                      phoc_event_sequence_free);
 
+static PhocEventPrivate *
+event_alloc (void)
+{
+  PhocEventPrivate *priv;
+
+  if (event_pool_len == 0)
+    return g_new0 (PhocEventPrivate, 1);
+
+  priv = event_pool[--event_pool_len];
+  memset (priv, 0, sizeof (*priv));
+
+  return priv;
+}
+
+
+static void
+event_release (PhocEventPrivate *priv)
+{
+  if (event_pool_len == PHOC_EVENT_POOL_SIZE) {
+    g_free (priv);
+    return;
+  }
+
+  event_pool[event_pool_len++] = priv;
+}
+
 /**
  * phoc_event_new:
  * @type: The type of event.
+ * @wlr_event:(nullable): The wlroots event to copy the data from
+ * @size: The size of `wlr_event`
  *
  * Creates a new #PhocEvent of the specified type.
  *
@@ -64,7 +101,8 @@ phoc_event_new (PhocEventType type, gpointer wlr_event, gsize size)
 
   g_assert (wlr_event == NULL || size >= sizeof (struct wlr_touch_cancel_event));
 
-  priv = g_new0 (PhocEventPrivate, 1);
+  priv = event_alloc ();
+  g_ref_count_init (&priv->ref_count);
 
   new_event = (PhocEvent *) priv;
   new_event->type = type;
@@ -79,7 +117,8 @@ phoc_event_new (PhocEventType type, gpointer wlr_event, gsize size)
  * phoc_event_copy:
  * @event: A #PhocEvent.
  *
- * Copies @event.
+ * Copies @event. As events can't be modified after creation taking a
+ * reference via [method@Event.ref] is usually sufficient.
  *
  * Return value: (transfer full): A newly allocated #PhocEvent
  */
@@ -102,24 +141,63 @@ phoc_event_copy (const PhocEvent *event)
   return new_event;
 }
 
+/**
+ * phoc_event_ref:
+ * @event: A #PhocEvent.
+ *
+ * Takes a reference on @event.
+ *
+ * Return value: (transfer full): The event
+ */
+PhocEvent *
+phoc_event_ref (PhocEvent *event)
+{
+  PhocEventPrivate *priv = (PhocEventPrivate *) event;
+
+  g_return_val_if_fail (event != NULL, NULL);
+
+  g_ref_count_inc (&priv->ref_count);
+
+  return event;
+}
+
+/**
+ * phoc_event_unref:
+ * @event: A #PhocEvent.
+ *
+ * Drops a reference on @event. When the last reference is dropped all
+ * resources used by @event are released.
+ */
+void
+phoc_event_unref (PhocEvent *event)
+{
+  PhocEventPrivate *priv = (PhocEventPrivate *) event;
+
+  if (G_UNLIKELY (event == NULL))
+    return;
+
+  if (!g_ref_count_dec (&priv->ref_count))
+    return;
+
+  switch (event->type) {
+  /* Nothing to do here atm */
+  default:
+    break;
+  }
+
+  event_release (priv);
+}
+
 /**
  * phoc_event_free:
  * @event: A #PhocEvent.
  *
- * Frees all resources used by @event.
+ * Drops a reference on @event. Same as [method@Event.unref].
  */
 void
 phoc_event_free (PhocEvent *event)
 {
-  if (G_LIKELY (event != NULL)) {
-    switch (event->type) {
-    /* Nothing to do here atm */
-    default:
-      break;
-    }
-
-    g_free ((PhocEventPrivate *) event);
-  }
+  phoc_event_unref (event);
 }
 
 /**
@@ -146,6 +146,8 @@ PhocEvent                  *phoc_event_new                           (PhocEventT
                                                                       const gpointer   wlr_event,
                                                                       gsize            size);
 PhocEvent                  *phoc_event_copy                          (const PhocEvent *event);
+PhocEvent                  *phoc_event_ref                           (PhocEvent       *event);
+void                        phoc_event_unref                         (PhocEvent       *event);
 void                        phoc_event_free                          (PhocEvent       *event);
 PhocEventSequence          *phoc_event_get_event_sequence            (const PhocEvent *event);
 /* TODO: #include "input-device.h" tirggers header fallout again */
@@ -160,6 +162,6 @@ guint                      phoc_event_get_touchpad_gesture_n_fingers (const Phoc
 guint32                    phoc_event_get_time                       (const PhocEvent *event);
 
 
-G_DEFINE_AUTOPTR_CLEANUP_FUNC (PhocEvent, phoc_event_free)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PhocEvent, phoc_event_unref)
 
 G_END_DECLS
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-frame-clock"
+
+#include "phoc-config.h"
+
+#include "frame-clock.h"
+
+/**
+ * PhocFrameClock:
+ *
+ * Predicts when a frame will be presented on an output.
+ *
+ * The clock is fed the timestamps of presented frames and the refresh
+ * interval reported with them. From that it extrapolates the vblank
+ * the frame that is currently being prepared will be displayed at so
+ * animations can sample their timeline at that point in time rather
+ * than at the (jittery) time the frame happens to be prepared.
+ *
+ * All timestamps are in µs using the same clock as
+ * `g_get_monotonic_time()`.
+ */
+struct _PhocFrameClock {
+  GObject  parent;
+
+  /* Refresh interval of the current mode */
+  gint64   mode_refresh_us;
+  /* Last presentation and the refresh interval reported with it */
+  gint64   presented_us;
+  gint64   presented_refresh_us;
+  /* Last predicted frame time */
+  gint64   frame_time_us;
+};
+G_DEFINE_TYPE (PhocFrameClock, phoc_frame_clock, G_TYPE_OBJECT)
+
+
+static void
+phoc_frame_clock_class_init (PhocFrameClockClass *klass)
+{
+}
+
+
+static void
+phoc_frame_clock_init (PhocFrameClock *self)
+{
+}
+
+
+PhocFrameClock *
+phoc_frame_clock_new (void)
+{
+  return g_object_new (PHOC_TYPE_FRAME_CLOCK, NULL);
+}
+
+/**
+ * phoc_frame_clock_set_refresh_rate:
+ * @self: The frame clock
+ * @refresh_mhz: The refresh rate of the output's mode in mHz or `0` if unknown
+ *
+ * Sets the nominal refresh rate. This is used until presentation
+ * feedback reports the actual refresh interval. Changing the refresh
+ * rate invalidates the recorded vblank phase.
+ */
+void
+phoc_frame_clock_set_refresh_rate (PhocFrameClock *self, int refresh_mhz)
+{
+  gint64 refresh_us;
+
+  g_assert (PHOC_IS_FRAME_CLOCK (self));
+
+  refresh_us = refresh_mhz > 0 ? (G_USEC_PER_SEC * (gint64)1000) / refresh_mhz : 0;
+  if (refresh_us == self->mode_refresh_us)
+    return;
+
+  self->mode_refresh_us = refresh_us;
+  self->presented_us = 0;
+  self->presented_refresh_us = 0;
+}
+
+/**
+ * phoc_frame_clock_add_presentation:
+ * @self: The frame clock
+ * @presented_us: When the frame was presented
+ * @refresh_us: The refresh interval reported by the backend or `0` if unknown
+ *
+ * Records the presentation of a frame. Subsequent predictions are
+ * aligned to this vblank.
+ */
+void
+phoc_frame_clock_add_presentation (PhocFrameClock *self, gint64 presented_us, gint64 refresh_us)
+{
+  g_assert (PHOC_IS_FRAME_CLOCK (self));
+
+  if (presented_us <= 0)
+    return;
+
+  self->presented_us = presented_us;
+  self->presented_refresh_us = MAX (refresh_us, 0);
+}
+
+/**
+ * phoc_frame_clock_get_refresh_interval:
+ * @self: The frame clock
+ *
+ * Gets the refresh interval predictions are based on. The interval
+ * reported with the last presentation takes precedence over the
+ * nominal one.
+ *
+ * Returns: The refresh interval in µs or `0` if unknown
+ */
+gint64
+phoc_frame_clock_get_refresh_interval (PhocFrameClock *self)
+{
+  g_assert (PHOC_IS_FRAME_CLOCK (self));
+
+  if (self->presented_refresh_us > 0)
+    return self->presented_refresh_us;
+
+  return self->mode_refresh_us;
+}
+
+/**
+ * phoc_frame_clock_get_frame_time:
+ * @self: The frame clock
+ * @now_us: The current time
+ *
+ * Predicts when a frame prepared at @now_us will be presented. This
+ * is the first vblank after @now_us based on the last presentation.
+ * Without presentation feedback it's one refresh interval from
+ * @now_us or @now_us itself if the refresh interval isn't known
+ * either.
+ *
+ * Frame times are strictly increasing: a frame is never predicted to
+ * be shown at or before the vblank predicted for the previous one.
+ *
+ * Returns: The predicted presentation time
+ */
+gint64
+phoc_frame_clock_get_frame_time (PhocFrameClock *self, gint64 now_us)
+{
+  gint64 interval, frame_time;
+
+  g_assert (PHOC_IS_FRAME_CLOCK (self));
+
+  interval = phoc_frame_clock_get_refresh_interval (self);
+
+  if (interval == 0) {
+    frame_time = now_us;
+  } else if (self->presented_us == 0) {
+    frame_time = now_us + interval;
+  } else if (now_us < self->presented_us) {
+    frame_time = self->presented_us + interval;
+  } else {
+    gint64 cycles = (now_us - self->presented_us) / interval + 1;
+
+    frame_time = self->presented_us + cycles * interval;
+  }
+
+  if (self->frame_time_us && frame_time <= self->frame_time_us)
+    frame_time = self->frame_time_us + MAX (interval, 1);
+
+  self->frame_time_us = frame_time;
+  return frame_time;
+}
+
+/**
+ * phoc_frame_clock_is_synced:
+ * @self: The frame clock
+ *
+ * Whether predictions are aligned to actual vblanks. This is the case
+ * once a presentation was recorded for the current mode.
+ *
+ * Returns: %TRUE if the vblank phase is known
+ */
+gboolean
+phoc_frame_clock_is_synced (PhocFrameClock *self)
+{
+  g_assert (PHOC_IS_FRAME_CLOCK (self));
+
+  return self->presented_us != 0 && phoc_frame_clock_get_refresh_interval (self) > 0;
+}
+
+/**
+ * phoc_frame_clock_reset:
+ * @self: The frame clock
+ *
+ * Forgets the recorded presentations and predictions, e.g. when the
+ * output got disabled.
+ */
+void
+phoc_frame_clock_reset (PhocFrameClock *self)
+{
+  g_assert (PHOC_IS_FRAME_CLOCK (self));
+
+  self->presented_us = 0;
+  self->presented_refresh_us = 0;
+  self->frame_time_us = 0;
+}
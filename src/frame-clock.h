@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PHOC_TYPE_FRAME_CLOCK (phoc_frame_clock_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocFrameClock, phoc_frame_clock, PHOC, FRAME_CLOCK, GObject)
+
+PhocFrameClock     *phoc_frame_clock_new                    (void);
+void                phoc_frame_clock_set_refresh_rate       (PhocFrameClock *self,
+                                                             int             refresh_mhz);
+void                phoc_frame_clock_add_presentation       (PhocFrameClock *self,
+                                                             gint64          presented_us,
+                                                             gint64          refresh_us);
+gint64              phoc_frame_clock_get_refresh_interval   (PhocFrameClock *self);
+gint64              phoc_frame_clock_get_frame_time         (PhocFrameClock *self,
+                                                             gint64          now_us);
+gboolean            phoc_frame_clock_is_synced              (PhocFrameClock *self);
+void                phoc_frame_clock_reset                  (PhocFrameClock *self);
+
+G_END_DECLS
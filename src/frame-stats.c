@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-frame-stats"
+
+#include "phoc-config.h"
+
+#include "frame-stats.h"
+
+#include <string.h>
+
+/* Number of most recent samples the histograms are built from */
+#define PHOC_FRAME_STATS_WINDOW 256
+#define PHOC_FRAME_STATS_N_BUCKETS 12
+
+/**
+ * PhocFrameStats:
+ *
+ * Cheap frame timing statistics for an output.
+ *
+ * For each histogram the samples of the last frames are kept in a
+ * fixed size ring buffer. Adding a sample evicts the oldest one so the
+ * histograms always describe the most recent frames while recording
+ * a sample is constant time and doesn't allocate. The frame counters
+ * count all frames since creation or the last reset.
+ */
+
+/* Upper bounds (inclusive) of the buckets */
+static const guint64 time_bounds[PHOC_FRAME_STATS_N_BUCKETS] = {
+  250, 500, 1000, 2000, 4000, 8000, 12000, 16667, 25000, 33333, 50000, G_MAXUINT64
+};
+
+static const guint64 area_bounds[PHOC_FRAME_STATS_N_BUCKETS] = {
+  0, 1024, 4096, 16384, 65536, 131072, 262144, 524288, 1048576, 2097152, 4194304, G_MAXUINT64
+};
+
+static const guint64 rects_bounds[PHOC_FRAME_STATS_N_BUCKETS] = {
+  1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, G_MAXUINT64
+};
+
+static const char * const histogram_names[PHOC_FRAME_STATS_N_HISTOGRAMS] = {
+  [PHOC_FRAME_STATS_RENDER_TIME] = "render-time",
+  [PHOC_FRAME_STATS_PRESENT_LATENCY] = "present-latency",
+  [PHOC_FRAME_STATS_DAMAGE_AREA] = "damage-area",
+  [PHOC_FRAME_STATS_DAMAGE_RECTS] = "damage-rects",
+};
+
+typedef struct {
+  guint32  counts[PHOC_FRAME_STATS_N_BUCKETS];
+  guint64  samples[PHOC_FRAME_STATS_WINDOW];
+  guint    head;
+  guint    len;
+  guint64  sum;
+} PhocFrameStatsRing;
+
+struct _PhocFrameStats {
+  GObject            parent;
+
+  PhocFrameStatsRing rings[PHOC_FRAME_STATS_N_HISTOGRAMS];
+
+  guint64            n_composited;
+  guint64            n_scanout;
+  guint64            n_missed;
+  guint64            n_simplified;
+};
+G_DEFINE_TYPE (PhocFrameStats, phoc_frame_stats, G_TYPE_OBJECT)
+
+
+static guint
+get_bucket (PhocFrameStatsHistogram histogram, guint64 value)
+{
+  const guint64 *bounds = phoc_frame_stats_get_bucket_bounds (histogram, NULL);
+  guint i;
+
+  for (i = 0; i < PHOC_FRAME_STATS_N_BUCKETS - 1; i++) {
+    if (value <= bounds[i])
+      break;
+  }
+
+  return i;
+}
+
+
+static void
+add_sample (PhocFrameStats *self, PhocFrameStatsHistogram histogram, guint64 value)
+{
+  PhocFrameStatsRing *ring = &self->rings[histogram];
+
+  if (ring->len == PHOC_FRAME_STATS_WINDOW) {
+    guint64 oldest = ring->samples[ring->head];
+
+    ring->counts[get_bucket (histogram, oldest)]--;
+    ring->sum -= oldest;
+  } else {
+    ring->len++;
+  }
+
+  ring->samples[ring->head] = value;
+  ring->head = (ring->head + 1) % PHOC_FRAME_STATS_WINDOW;
+  ring->counts[get_bucket (histogram, value)]++;
+  ring->sum += value;
+}
+
+
+static void
+phoc_frame_stats_class_init (PhocFrameStatsClass *klass)
+{
+}
+
+
+static void
+phoc_frame_stats_init (PhocFrameStats *self)
+{
+}
+
+
+PhocFrameStats *
+phoc_frame_stats_new (void)
+{
+  return g_object_new (PHOC_TYPE_FRAME_STATS, NULL);
+}
+
+/**
+ * phoc_frame_stats_add_composited:
+ * @self: The frame stats
+ * @render_time_us: The CPU time spent rendering the frame
+ * @damage_area: The damaged area of the frame in buffer pixels
+ *
+ * Records a frame that was composited by the renderer.
+ */
+void
+phoc_frame_stats_add_composited (PhocFrameStats *self, guint64 render_time_us, guint64 damage_area)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  self->n_composited++;
+  add_sample (self, PHOC_FRAME_STATS_RENDER_TIME, render_time_us);
+  add_sample (self, PHOC_FRAME_STATS_DAMAGE_AREA, damage_area);
+}
+
+/**
+ * phoc_frame_stats_add_damage_rects:
+ * @self: The frame stats
+ * @n_rects: The number of rectangles the frame's damage consisted of
+ * @simplified: Whether the damage was simplified to get there
+ *
+ * Records the complexity of a composited frame's damage.
+ */
+void
+phoc_frame_stats_add_damage_rects (PhocFrameStats *self, guint n_rects, gboolean simplified)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  if (simplified)
+    self->n_simplified++;
+
+  add_sample (self, PHOC_FRAME_STATS_DAMAGE_RECTS, n_rects);
+}
+
+/**
+ * phoc_frame_stats_add_scanout:
+ * @self: The frame stats
+ *
+ * Records a frame where a client buffer was scanned out directly.
+ */
+void
+phoc_frame_stats_add_scanout (PhocFrameStats *self)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  self->n_scanout++;
+}
+
+/**
+ * phoc_frame_stats_add_presented:
+ * @self: The frame stats
+ * @latency_us: The time between commit and presentation
+ * @missed: Whether the frame missed its refresh cycle
+ *
+ * Records the presentation of a committed frame.
+ */
+void
+phoc_frame_stats_add_presented (PhocFrameStats *self, guint64 latency_us, gboolean missed)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  if (missed)
+    self->n_missed++;
+
+  add_sample (self, PHOC_FRAME_STATS_PRESENT_LATENCY, latency_us);
+}
+
+/**
+ * phoc_frame_stats_add_discarded:
+ * @self: The frame stats
+ *
+ * Records a committed frame that was never presented. Such frames
+ * count as missed.
+ */
+void
+phoc_frame_stats_add_discarded (PhocFrameStats *self)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  self->n_missed++;
+}
+
+/**
+ * phoc_frame_stats_reset:
+ * @self: The frame stats
+ *
+ * Drops all recorded samples and resets the counters.
+ */
+void
+phoc_frame_stats_reset (PhocFrameStats *self)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  memset (self->rings, 0, sizeof (self->rings));
+  self->n_composited = 0;
+  self->n_scanout = 0;
+  self->n_missed = 0;
+  self->n_simplified = 0;
+}
+
+
+guint64
+phoc_frame_stats_get_n_composited (PhocFrameStats *self)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  return self->n_composited;
+}
+
+
+guint64
+phoc_frame_stats_get_n_scanout (PhocFrameStats *self)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  return self->n_scanout;
+}
+
+
+guint64
+phoc_frame_stats_get_n_missed (PhocFrameStats *self)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  return self->n_missed;
+}
+
+
+guint64
+phoc_frame_stats_get_n_simplified (PhocFrameStats *self)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  return self->n_simplified;
+}
+
+/**
+ * phoc_frame_stats_get_histogram:
+ * @self: The frame stats
+ * @histogram: The histogram to get
+ * @n_buckets:(out)(optional): The number of buckets
+ *
+ * Gets the number of samples in each bucket of the given histogram.
+ * See [func@FrameStats.get_bucket_bounds] for the buckets' bounds.
+ *
+ * Returns:(transfer none): The sample counts
+ */
+const guint32 *
+phoc_frame_stats_get_histogram (PhocFrameStats          *self,
+                                PhocFrameStatsHistogram  histogram,
+                                guint                   *n_buckets)
+{
+  g_assert (PHOC_IS_FRAME_STATS (self));
+  g_assert (histogram < PHOC_FRAME_STATS_N_HISTOGRAMS);
+
+  if (n_buckets)
+    *n_buckets = PHOC_FRAME_STATS_N_BUCKETS;
+
+  return self->rings[histogram].counts;
+}
+
+/**
+ * phoc_frame_stats_get_bucket_bounds:
+ * @histogram: The histogram
+ * @n_buckets:(out)(optional): The number of buckets
+ *
+ * Gets the inclusive upper bounds of the given histogram's
+ * buckets. The last bucket is unbounded.
+ *
+ * Returns:(transfer none): The bounds
+ */
+const guint64 *
+phoc_frame_stats_get_bucket_bounds (PhocFrameStatsHistogram histogram, guint *n_buckets)
+{
+  g_assert (histogram < PHOC_FRAME_STATS_N_HISTOGRAMS);
+
+  if (n_buckets)
+    *n_buckets = PHOC_FRAME_STATS_N_BUCKETS;
+
+  if (histogram == PHOC_FRAME_STATS_DAMAGE_AREA)
+    return area_bounds;
+
+  if (histogram == PHOC_FRAME_STATS_DAMAGE_RECTS)
+    return rects_bounds;
+
+  return time_bounds;
+}
+
+/**
+ * phoc_frame_stats_get_mean:
+ * @self: The frame stats
+ * @histogram: The histogram
+ *
+ * Gets the mean of the samples currently in the given histogram.
+ *
+ * Returns: The mean or `0` if there are no samples
+ */
+guint64
+phoc_frame_stats_get_mean (PhocFrameStats *self, PhocFrameStatsHistogram histogram)
+{
+  PhocFrameStatsRing *ring;
+
+  g_assert (PHOC_IS_FRAME_STATS (self));
+  g_assert (histogram < PHOC_FRAME_STATS_N_HISTOGRAMS);
+
+  ring = &self->rings[histogram];
+  if (ring->len == 0)
+    return 0;
+
+  return ring->sum / ring->len;
+}
+
+/**
+ * phoc_frame_stats_get_window_size:
+ *
+ * Gets the number of most recent samples the histograms are built from.
+ *
+ * Returns: The window size
+ */
+guint
+phoc_frame_stats_get_window_size (void)
+{
+  return PHOC_FRAME_STATS_WINDOW;
+}
+
+/**
+ * phoc_frame_stats_to_variant:
+ * @self: The frame stats
+ *
+ * Serializes the frame stats into a dictionary of type `a{sv}`. The
+ * counters are stored under `composited`, `scanout`, `missed` and
+ * `simplified`. For each histogram `<name>-bounds`, `<name>-counts`
+ * and `<name>-mean` are stored where `<name>` is one of
+ * `render-time`, `present-latency`, `damage-area` and `damage-rects`.
+ *
+ * Returns:(transfer floating): The serialized stats
+ */
+GVariant *
+phoc_frame_stats_to_variant (PhocFrameStats *self)
+{
+  GVariantBuilder builder;
+
+  g_assert (PHOC_IS_FRAME_STATS (self));
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+  g_variant_builder_add (&builder, "{sv}", "composited", g_variant_new_uint64 (self->n_composited));
+  g_variant_builder_add (&builder, "{sv}", "scanout", g_variant_new_uint64 (self->n_scanout));
+  g_variant_builder_add (&builder, "{sv}", "missed", g_variant_new_uint64 (self->n_missed));
+  g_variant_builder_add (&builder, "{sv}", "simplified", g_variant_new_uint64 (self->n_simplified));
+
+  for (int i = 0; i < PHOC_FRAME_STATS_N_HISTOGRAMS; i++) {
+    const guint64 *bounds = phoc_frame_stats_get_bucket_bounds (i, NULL);
+    g_autofree char *bounds_key = g_strdup_printf ("%s-bounds", histogram_names[i]);
+    g_autofree char *counts_key = g_strdup_printf ("%s-counts", histogram_names[i]);
+    g_autofree char *mean_key = g_strdup_printf ("%s-mean", histogram_names[i]);
+
+    g_variant_builder_add (&builder, "{sv}", bounds_key,
+                           g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64,
+                                                      bounds,
+                                                      PHOC_FRAME_STATS_N_BUCKETS,
+                                                      sizeof (guint64)));
+    g_variant_builder_add (&builder, "{sv}", counts_key,
+                           g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+                                                      self->rings[i].counts,
+                                                      PHOC_FRAME_STATS_N_BUCKETS,
+                                                      sizeof (guint32)));
+    g_variant_builder_add (&builder, "{sv}", mean_key,
+                           g_variant_new_uint64 (phoc_frame_stats_get_mean (self, i)));
+  }
+
+  return g_variant_builder_end (&builder);
+}
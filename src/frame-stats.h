@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PhocFrameStatsHistogram:
+ * @PHOC_FRAME_STATS_RENDER_TIME: CPU time spent rendering a frame in µs
+ * @PHOC_FRAME_STATS_PRESENT_LATENCY: Time from commit to presentation in µs
+ * @PHOC_FRAME_STATS_DAMAGE_AREA: Damaged area of a frame in buffer pixels
+ * @PHOC_FRAME_STATS_DAMAGE_RECTS: Number of rectangles a frame was rendered with
+ *
+ * The histograms kept by [type@FrameStats].
+ */
+typedef enum {
+  PHOC_FRAME_STATS_RENDER_TIME,
+  PHOC_FRAME_STATS_PRESENT_LATENCY,
+  PHOC_FRAME_STATS_DAMAGE_AREA,
+  PHOC_FRAME_STATS_DAMAGE_RECTS,
+  PHOC_FRAME_STATS_N_HISTOGRAMS,
+} PhocFrameStatsHistogram;
+
+#define PHOC_TYPE_FRAME_STATS (phoc_frame_stats_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocFrameStats, phoc_frame_stats, PHOC, FRAME_STATS, GObject)
+
+PhocFrameStats     *phoc_frame_stats_new                (void);
+void                phoc_frame_stats_add_composited     (PhocFrameStats          *self,
+                                                         guint64                  render_time_us,
+                                                         guint64                  damage_area);
+void                phoc_frame_stats_add_damage_rects   (PhocFrameStats          *self,
+                                                         guint                    n_rects,
+                                                         gboolean                 simplified);
+void                phoc_frame_stats_add_scanout        (PhocFrameStats          *self);
+void                phoc_frame_stats_add_presented      (PhocFrameStats          *self,
+                                                         guint64                  latency_us,
+                                                         gboolean                 missed);
+void                phoc_frame_stats_add_discarded      (PhocFrameStats          *self);
+void                phoc_frame_stats_reset              (PhocFrameStats          *self);
+guint64             phoc_frame_stats_get_n_composited   (PhocFrameStats          *self);
+guint64             phoc_frame_stats_get_n_scanout      (PhocFrameStats          *self);
+guint64             phoc_frame_stats_get_n_missed       (PhocFrameStats          *self);
+guint64             phoc_frame_stats_get_n_simplified   (PhocFrameStats          *self);
+const guint32      *phoc_frame_stats_get_histogram      (PhocFrameStats          *self,
+                                                         PhocFrameStatsHistogram  histogram,
+                                                         guint                   *n_buckets);
+const guint64      *phoc_frame_stats_get_bucket_bounds  (PhocFrameStatsHistogram  histogram,
+                                                         guint                   *n_buckets);
+guint64             phoc_frame_stats_get_mean           (PhocFrameStats          *self,
+                                                         PhocFrameStatsHistogram  histogram);
+guint               phoc_frame_stats_get_window_size    (void);
+GVariant           *phoc_frame_stats_to_variant         (PhocFrameStats          *self);
+
+G_END_DECLS
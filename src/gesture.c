@@ -391,10 +391,9 @@ phoc_gesture_update_point (PhocGesture     *self,
     g_hash_table_insert (priv->points, sequence, data);
   }
 
-  if (data->event)
-    phoc_event_free (data->event);
-
-  data->event = phoc_event_copy (event);
+  g_clear_pointer (&data->event, phoc_event_unref);
+  /* Events are immutable, share them instead of copying */
+  data->event = phoc_event_ref ((PhocEvent *)event);
   update_touchpad_deltas (data);
   data->lx = lx + data->accum_dx;
   data->ly = ly + data->accum_dy;
@@ -719,7 +718,7 @@ free_point_data (gpointer data)
 {
   PointData *point = data;
 
-  g_clear_pointer (&point->event, phoc_event_free);
+  g_clear_pointer (&point->event, phoc_event_unref);
   g_free (point);
 }
 
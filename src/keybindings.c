@@ -48,6 +48,8 @@ typedef struct _PhocKeybindings
   GObject parent;
 
   GSList *bindings;
+  /* combo key -> PhocKeybinding */
+  GHashTable *index;
   GSettings *settings;
   GSettings *mutter_settings;
 } PhocKeybindings;
@@ -456,28 +458,48 @@ phoc_keybinding_free (PhocKeybinding *keybinding)
 
 
 static gboolean
-key_combo_eq (const PhocKeyCombo *sym1, const PhocKeyCombo *sym2)
+keybinding_by_name (const PhocKeybinding *keybinding, const gchar *name)
 {
-  return (sym1->modifiers == sym2->modifiers && sym1->keysym == sym2->keysym);
+  return g_strcmp0 (keybinding->name, name);
 }
 
 
-static gboolean
-keybinding_by_name (const PhocKeybinding *keybinding, const gchar *name)
+/**
+ * phoc_key_combo_get_key: (skip)
+ * @combo: The key combination
+ *
+ * Packs modifiers and keysym of @combo into a single value suitable as
+ * key for `g_int64_hash()` based hash tables.
+ *
+ * Returns: The packed key combination
+ */
+gint64
+phoc_key_combo_get_key (const PhocKeyCombo *combo)
 {
-  return g_strcmp0 (keybinding->name, name);
+  return ((gint64) combo->modifiers << 32) | combo->keysym;
 }
 
 
-static gboolean
-keybinding_by_key_combo (const PhocKeybinding *keybinding, const PhocKeyCombo *combo)
+static void
+rebuild_index (PhocKeybindings *self)
 {
-  for (GSList *elem = keybinding->combos; elem; elem = elem->next) {
-    if (key_combo_eq (elem->data, combo))
-      return FALSE;
-  }
+  g_hash_table_remove_all (self->index);
 
-  return TRUE;
+  for (GSList *l = self->bindings; l; l = l->next) {
+    PhocKeybinding *keybinding = l->data;
+
+    for (GSList *elem = keybinding->combos; elem; elem = elem->next) {
+      gint64 key = phoc_key_combo_get_key (elem->data);
+
+      /* Like with the former list walk the first binding wins */
+      if (g_hash_table_contains (self->index, &key)) {
+        g_debug ("Keybinding %s shadowed by an earlier binding", keybinding->name);
+        continue;
+      }
+
+      g_hash_table_insert (self->index, g_memdup2 (&key, sizeof (key)), keybinding);
+    }
+  }
 }
 
 
@@ -517,6 +539,8 @@ on_keybinding_setting_changed (PhocKeybindings *self,
     if (combo)
       keybinding->combos = g_slist_append (keybinding->combos, combo);
   }
+
+  rebuild_index (self);
 }
 
 
@@ -557,6 +581,7 @@ phoc_keybindings_dispose (GObject *object)
 {
   PhocKeybindings *self = PHOC_KEYBINDINGS (object);
 
+  g_clear_pointer (&self->index, g_hash_table_destroy);
   g_slist_free_full (self->bindings, (GDestroyNotify)phoc_keybinding_free);
   self->bindings = NULL;
 
@@ -653,6 +678,7 @@ static void
 phoc_keybindings_init (PhocKeybindings *self)
 {
   self->bindings = NULL;
+  self->index = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
 }
 
 
@@ -682,8 +708,8 @@ phoc_keybindings_handle_pressed (PhocKeybindings *self,
                                  PhocSeat        *seat)
 {
   PhocKeybinding *keybinding;
-  GSList *elem;
   PhocKeyCombo combo;
+  gint64 key;
 
   if (length != 1)
     return FALSE;
@@ -691,14 +717,13 @@ phoc_keybindings_handle_pressed (PhocKeybindings *self,
   combo.keysym = pressed_keysyms[0];
   combo.modifiers = modifiers;
 
-  elem = g_slist_find_custom (self->bindings,
-                              &combo,
-                              (GCompareFunc)keybinding_by_key_combo);
-  if (!elem)
+  if (self->index == NULL)
     return FALSE;
 
-  g_return_val_if_fail (elem->data, FALSE);
-  keybinding = elem->data;
+  key = phoc_key_combo_get_key (&combo);
+  keybinding = g_hash_table_lookup (self->index, &key);
+  if (!keybinding)
+    return FALSE;
 
   (*keybinding->func) (seat, keybinding->param);
   return TRUE;
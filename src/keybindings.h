@@ -37,4 +37,5 @@ gboolean         phoc_keybindings_handle_pressed (PhocKeybindings *self,
                                                   guint32 length,
                                                   PhocSeat *seat);
 PhocKeyCombo    *phoc_parse_accelerator (const gchar * accelerator);
+gint64           phoc_key_combo_get_key (const PhocKeyCombo *combo);
 G_END_DECLS
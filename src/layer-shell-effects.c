@@ -72,6 +72,7 @@ struct _PhocDraggableLayerSurface {
     /* Slide in/out animation */
     guint    anim_id;
     float    anim_t;
+    gint64   anim_start_us;
     int32_t  anim_duration;
     int32_t  anim_start;
     int32_t  anim_end;
@@ -1085,7 +1086,7 @@ apply_state (PhocDraggableLayerSurface *drag_surface, PhocDraggableSurfaceState
 
 
 static gboolean
-on_output_frame_callback (PhocAnimatable *animatable, guint64 last_frame, gpointer user_data)
+on_output_frame_callback (PhocAnimatable *animatable, guint64 frame_time, gpointer user_data)
 
 {
   PhocDraggableLayerSurface *drag_surface = user_data;
@@ -1147,9 +1148,12 @@ on_output_frame_callback (PhocAnimatable *animatable, guint64 last_frame, gpoint
     apply_state (drag_surface, PHOC_DRAGGABLE_SURFACE_STATE_NONE);
     drag_surface->drag.anim_id = 0;
   } else {
-    gint64 now = g_get_monotonic_time ();
+    gint64 elapsed = (gint64)frame_time - drag_surface->drag.anim_start_us;
 
-    drag_surface->drag.anim_t += ((float)(now - last_frame)) / drag_surface->drag.anim_duration;
+    if (drag_surface->drag.anim_duration > 0)
+      drag_surface->drag.anim_t = ((float)MAX (elapsed, 0)) / drag_surface->drag.anim_duration;
+    else
+      drag_surface->drag.anim_t = 1.0;
     if (drag_surface->drag.anim_t > 1.0)
       drag_surface->drag.anim_t = 1.0;
 
@@ -1167,9 +1171,7 @@ on_output_frame_callback (PhocAnimatable *animatable, guint64 last_frame, gpoint
   }
 
   apply_margin (drag_surface, margin);
-  phoc_layer_shell_arrange (output);
-  /* FIXME: way too much damage */
-  phoc_output_damage_whole (output);
+  phoc_layer_shell_arrange_surface (output, layer_surface);
 
   return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
 }
@@ -1210,6 +1212,7 @@ phoc_draggable_layer_surface_slide (PhocDraggableLayerSurface *drag_surface, Pho
   }
 
   drag_surface->drag.anim_t = 0;
+  drag_surface->drag.anim_start_us = g_get_monotonic_time ();
   drag_surface->drag.anim_start = margin;
   drag_surface->drag.anim_dir = anim_dir;
   drag_surface->drag.anim_end = (anim_dir == ANIM_DIR_OUT) ?
@@ -1328,10 +1331,7 @@ accept_drag (PhocDraggableLayerSurface *drag_surface,
   wlr_layer_surface->pending.exclusive_zone = wlr_layer_surface->current.exclusive_zone;
 
   zphoc_draggable_layer_surface_v1_send_dragged (drag_surface->resource, margin);
-  phoc_layer_shell_arrange (output);
-
-  /* FIXME: way too much damage */
-  phoc_output_damage_whole (output);
+  phoc_layer_shell_arrange_surface (output, drag_surface->layer_surface);
 
   apply_state (drag_surface, PHOC_DRAGGABLE_SURFACE_STATE_DRAGGING);
 }
@@ -130,6 +130,130 @@ phoc_layer_shell_update_cursors (PhocLayerSurface *layer_surface, GSList *seats)
 }
 
 
+/* Layers are arranged top to bottom */
+static const enum zwlr_layer_shell_v1_layer arrange_order[] = {
+  ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY,
+  ZWLR_LAYER_SHELL_V1_LAYER_TOP,
+  ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM,
+  ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND
+};
+
+
+static gboolean
+get_layer_surface_box (PhocLayerSurface *layer_surface, const struct wlr_box *bounds, struct wlr_box *box)
+{
+  struct wlr_layer_surface_v1_state *state = &layer_surface->layer_surface->current;
+
+  *box = (struct wlr_box) {
+    .width = state->desired_width,
+    .height = state->desired_height
+  };
+  /* Horizontal axis */
+  const uint32_t both_horiz = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT
+    | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT;
+  if ((state->anchor & both_horiz) && box->width == 0) {
+    box->x = bounds->x;
+    box->width = bounds->width;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
+    box->x = bounds->x;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
+    box->x = bounds->x + (bounds->width - box->width);
+  } else {
+    box->x = bounds->x + ((bounds->width / 2) - (box->width / 2));
+  }
+  /* Vertical axis */
+  const uint32_t both_vert = ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP
+    | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM;
+  if ((state->anchor & both_vert) && box->height == 0) {
+    box->y = bounds->y;
+    box->height = bounds->height;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
+    box->y = bounds->y;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
+    box->y = bounds->y + (bounds->height - box->height);
+  } else {
+    box->y = bounds->y + ((bounds->height / 2) - (box->height / 2));
+  }
+  /* Margin */
+  if ((state->anchor & both_horiz) == both_horiz) {
+    box->x += state->margin.left;
+    box->width -= state->margin.left + state->margin.right;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
+    box->x += state->margin.left;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
+    box->x -= state->margin.right;
+  }
+  if ((state->anchor & both_vert) == both_vert) {
+    box->y += state->margin.top;
+    box->height -= state->margin.top + state->margin.bottom;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
+    box->y += state->margin.top;
+  } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
+    box->y -= state->margin.bottom;
+  }
+
+  return box->width >= 0 && box->height >= 0;
+}
+
+/*
+ * Position a layer surface within the given bounds. If usable_area
+ * is given the surface's exclusive zone is subtracted from it.
+ */
+static gboolean
+arrange_layer_surface (PhocOutput           *output,
+                       GSList               *seats, /* PhocSeat */
+                       PhocLayerSurface     *layer_surface,
+                       const struct wlr_box *bounds,
+                       struct wlr_box       *usable_area)
+{
+  struct wlr_layer_surface_v1 *wlr_layer_surface = layer_surface->layer_surface;
+  struct wlr_layer_surface_v1_state *state = &wlr_layer_surface->current;
+  gboolean sent_configure = FALSE;
+  struct wlr_box box;
+
+  if (!get_layer_surface_box (layer_surface, bounds, &box)) {
+    g_warning_once ("Layer surface '%s' has negative bounds %dx%d - ignoring",
+                    layer_surface->layer_surface->namespace ?: "<unknown>",
+                    box.width, box.height);
+    /* The layer surface never gets configured, hence the client sees a protocol error */
+    return FALSE;
+  }
+
+  /* Keep showing the current layout until the client caught up with the new size */
+  if (wlr_layer_surface->surface->mapped &&
+      (box.width != layer_surface->geo.width || box.height != layer_surface->geo.height)) {
+    phoc_layout_transaction_save_element (phoc_layout_transaction_get_default (), layer_surface);
+  }
+
+  /* Apply */
+  struct wlr_box old_geo = layer_surface->geo;
+  layer_surface->geo = box;
+  phoc_output_update_layer_surface_bounds (output, layer_surface);
+  if (usable_area && wlr_layer_surface->surface->mapped) {
+    apply_exclusive (usable_area, state->anchor, state->exclusive_zone,
+                     state->margin.top, state->margin.right,
+                     state->margin.bottom, state->margin.left);
+  }
+
+  if (box.width != old_geo.width || box.height != old_geo.height) {
+    phoc_layer_surface_send_configure (layer_surface);
+    sent_configure = TRUE;
+  }
+
+  /* Having a cursor newly end up over the moved layer will not
+   * automatically send a motion event to the surface. The event needs to
+   * be synthesized.
+   * Only update layer surfaces which kept their size (and so buffers) the
+   * same, because those with resized buffers will be handled separately. */
+  if (layer_surface->geo.x != old_geo.x || layer_surface->geo.y != old_geo.y) {
+    phoc_touch_point_invalidate_transforms ();
+    phoc_layer_shell_update_cursors (layer_surface, seats);
+  }
+
+  return sent_configure;
+}
+
+
 static gboolean
 arrange_layer (PhocOutput                     *output,
                GSList                         *seats, /* PhocSeat */
@@ -144,8 +268,8 @@ arrange_layer (PhocOutput                     *output,
   g_assert (PHOC_IS_OUTPUT (output));
   wlr_output_effective_resolution (output->wlr_output, &full_area.width, &full_area.height);
   wl_list_for_each_reverse (layer_surface, &output->layer_surfaces, link) {
-    struct wlr_layer_surface_v1 *wlr_layer_surface = layer_surface->layer_surface;
-    struct wlr_layer_surface_v1_state *state = &wlr_layer_surface->current;
+    struct wlr_layer_surface_v1_state *state = &layer_surface->layer_surface->current;
+    struct wlr_box bounds;
 
     if (layer_surface->layer != layer)
       continue;
@@ -153,91 +277,62 @@ arrange_layer (PhocOutput                     *output,
     if (exclusive != (state->exclusive_zone > 0))
       continue;
 
-    struct wlr_box bounds;
     if (state->exclusive_zone == -1)
       bounds = full_area;
     else
       bounds = *usable_area;
 
-    struct wlr_box box = {
-      .width = state->desired_width,
-      .height = state->desired_height
-    };
-    /* Horizontal axis */
-    const uint32_t both_horiz = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT
-      | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT;
-    if ((state->anchor & both_horiz) && box.width == 0) {
-      box.x = bounds.x;
-      box.width = bounds.width;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
-      box.x = bounds.x;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
-      box.x = bounds.x + (bounds.width - box.width);
-    } else {
-      box.x = bounds.x + ((bounds.width / 2) - (box.width / 2));
-    }
-    /* Vertical axis */
-    const uint32_t both_vert = ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP
-      | ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM;
-    if ((state->anchor & both_vert) && box.height == 0) {
-      box.y = bounds.y;
-      box.height = bounds.height;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
-      box.y = bounds.y;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
-      box.y = bounds.y + (bounds.height - box.height);
-    } else {
-      box.y = bounds.y + ((bounds.height / 2) - (box.height / 2));
-    }
-    /* Margin */
-    if ((state->anchor & both_horiz) == both_horiz) {
-      box.x += state->margin.left;
-      box.width -= state->margin.left + state->margin.right;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT)) {
-      box.x += state->margin.left;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT)) {
-      box.x -= state->margin.right;
-    }
-    if ((state->anchor & both_vert) == both_vert) {
-      box.y += state->margin.top;
-      box.height -= state->margin.top + state->margin.bottom;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP)) {
-      box.y += state->margin.top;
-    } else if ((state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM)) {
-      box.y -= state->margin.bottom;
-    }
-    if (box.width < 0 || box.height < 0) {
-      g_warning_once ("Layer surface '%s' has negative bounds %dx%d - ignoring",
-                      layer_surface->layer_surface->namespace ?: "<unknown>",
-                      box.width, box.height);
-      /* The layer surface never gets configured, hence the client sees a protocol error */
-      continue;
-    }
+    sent_configure |= arrange_layer_surface (output, seats, layer_surface, &bounds, usable_area);
+  }
 
-    /* Apply */
-    struct wlr_box old_geo = layer_surface->geo;
-    layer_surface->geo = box;
-    if (wlr_layer_surface->surface->mapped) {
-      apply_exclusive (usable_area, state->anchor, state->exclusive_zone,
-                       state->margin.top, state->margin.right,
-                       state->margin.bottom, state->margin.left);
-    }
+  return sent_configure;
+}
 
-    if (box.width != old_geo.width || box.height != old_geo.height) {
-      phoc_layer_surface_send_configure (layer_surface);
-      sent_configure = TRUE;
-    }
+/*
+ * Compute the usable area left by the exclusive layer surfaces
+ * without touching any surface. Also gets the bounds `target` is
+ * arranged within.
+ */
+static void
+get_usable_area (PhocOutput       *output,
+                 PhocLayerSurface *target,
+                 struct wlr_box   *target_bounds,
+                 struct wlr_box   *usable_area)
+{
+  struct wlr_layer_surface_v1_state *target_state = &target->layer_surface->current;
+  PhocLayerSurface *layer_surface;
+  struct wlr_box full_area = { 0 };
+
+  wlr_output_effective_resolution (output->wlr_output, &full_area.width, &full_area.height);
+  *usable_area = full_area;
+
+  for (size_t i = 0; i < G_N_ELEMENTS (arrange_order); ++i) {
+    wl_list_for_each_reverse (layer_surface, &output->layer_surfaces, link) {
+      struct wlr_layer_surface_v1 *wlr_layer_surface = layer_surface->layer_surface;
+      struct wlr_layer_surface_v1_state *state = &wlr_layer_surface->current;
+      struct wlr_box box;
+
+      if (layer_surface->layer != arrange_order[i] || state->exclusive_zone <= 0)
+        continue;
 
-    /* Having a cursor newly end up over the moved layer will not
-     * automatically send a motion event to the surface. The event needs to
-     * be synthesized.
-     * Only update layer surfaces which kept their size (and so buffers) the
-     * same, because those with resized buffers will be handled separately. */
-    if (layer_surface->geo.x != old_geo.x || layer_surface->geo.y != old_geo.y)
-      phoc_layer_shell_update_cursors (layer_surface, seats);
+      if (layer_surface == target)
+        *target_bounds = *usable_area;
+
+      if (!get_layer_surface_box (layer_surface, usable_area, &box))
+        continue;
+
+      if (wlr_layer_surface->surface->mapped) {
+        apply_exclusive (usable_area, state->anchor, state->exclusive_zone,
+                         state->margin.top, state->margin.right,
+                         state->margin.bottom, state->margin.left);
+      }
+    }
   }
 
-  return sent_configure;
+  if (target_state->exclusive_zone == -1)
+    *target_bounds = full_area;
+  else if (target_state->exclusive_zone <= 0)
+    *target_bounds = *usable_area;
 }
 
 /**
@@ -288,23 +383,21 @@ phoc_layer_shell_arrange (PhocOutput *output)
   struct wlr_box usable_area = { 0 };
   GSList *seats = phoc_input_get_seats (input);
   gboolean usable_area_changed, sent_configure = FALSE;
-  enum zwlr_layer_shell_v1_layer layers[] = {
-    ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY,
-    ZWLR_LAYER_SHELL_V1_LAYER_TOP,
-    ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM,
-    ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND
-  };
 
   /*
    * Whenever we rearrange layers we need to check for the OSK's layer as
    * the new surface might need it raised (or the new surface might be the OSK itself)
    */
   phoc_layer_shell_update_osk (output, FALSE);
+  /* The output itself might have moved */
+  phoc_touch_point_invalidate_transforms ();
+  /* Overlay layer surfaces might cover the output now */
+  phoc_desktop_invalidate_visibility (desktop);
 
   wlr_output_effective_resolution (output->wlr_output, &usable_area.width, &usable_area.height);
   /* Arrange exclusive surfaces from top->bottom */
-  for (size_t i = 0; i < G_N_ELEMENTS (layers); ++i)
-    sent_configure |= arrange_layer (output, seats, layers[i], &usable_area, true);
+  for (size_t i = 0; i < G_N_ELEMENTS (arrange_order); ++i)
+    sent_configure |= arrange_layer (output, seats, arrange_order[i], &usable_area, true);
 
   usable_area_changed = memcmp (&output->usable_area, &usable_area, sizeof (output->usable_area));
   if (usable_area_changed) {
@@ -314,8 +407,8 @@ phoc_layer_shell_arrange (PhocOutput *output)
   }
 
   /* Arrange non-exlusive surfaces from top->bottom */
-  for (size_t i = 0; i < G_N_ELEMENTS (layers); ++i)
-    sent_configure |= arrange_layer (output, seats, layers[i], &usable_area, false);
+  for (size_t i = 0; i < G_N_ELEMENTS (arrange_order); ++i)
+    sent_configure |= arrange_layer (output, seats, arrange_order[i], &usable_area, false);
 
   phoc_output_update_shell_reveal (output);
 
@@ -338,6 +431,41 @@ phoc_layer_shell_arrange (PhocOutput *output)
   return sent_configure;
 }
 
+/**
+ * phoc_layer_shell_arrange_surface:
+ * @output: The output the layer surface is on
+ * @layer_surface: The layer surface to arrange
+ *
+ * Arrange a single layer surface after its margin or exclusive zone
+ * changed, e.g. while it's being dragged, and damage the area it
+ * moved across. As long as the usable area of the output stays the
+ * same no other layer surface or view is affected by the change. If
+ * it doesn't, the whole output is arranged and damaged.
+ */
+void
+phoc_layer_shell_arrange_surface (PhocOutput *output, PhocLayerSurface *layer_surface)
+{
+  PhocInput *input = phoc_server_get_input (phoc_server_get_default ());
+  struct wlr_box usable_area, bounds;
+
+  g_assert (PHOC_IS_OUTPUT (output));
+  g_assert (PHOC_IS_LAYER_SURFACE (layer_surface));
+
+  get_usable_area (output, layer_surface, &bounds, &usable_area);
+  if (memcmp (&output->usable_area, &usable_area, sizeof (output->usable_area))) {
+    phoc_layer_shell_arrange (output);
+    phoc_output_damage_whole (output);
+    return;
+  }
+
+  /* Damage old and new position */
+  phoc_output_damage_from_layer_surface (output, layer_surface, TRUE);
+  arrange_layer_surface (output, phoc_input_get_seats (input), layer_surface, &bounds, NULL);
+  phoc_output_damage_from_layer_surface (output, layer_surface, TRUE);
+
+  phoc_output_update_shell_reveal (output);
+}
+
 
 void
 phoc_layer_shell_update_focus (void)
@@ -163,6 +163,8 @@ phoc_layer_surface_apply_damage (PhocLayerSurface *self)
   phoc_output_damage_from_layer_surface (PHOC_OUTPUT (wlr_output->data),
                                          self,
                                          FALSE);
+  /* Popups and subsurfaces might have moved */
+  phoc_output_update_layer_surface_bounds (PHOC_OUTPUT (wlr_output->data), self);
 }
 
 
@@ -182,6 +184,7 @@ phoc_layer_surface_damage_whole (PhocLayerSurface *self)
   phoc_output_damage_from_layer_surface (PHOC_OUTPUT (wlr_output->data),
                                          self,
                                          TRUE);
+  phoc_output_update_layer_surface_bounds (PHOC_OUTPUT (wlr_output->data), self);
 }
 
 
@@ -277,6 +280,8 @@ handle_surface_commit (struct wl_listener *listener, void *data)
   if (layer_changed || exclusive_zone_changed)
     phoc_output_set_layer_dirty (output, self->layer);
 
+  phoc_output_update_layer_surface_bounds (output, self);
+
   if (self->pending_serial &&
       self->layer_surface->current.configure_serial >= self->pending_serial) {
     g_debug ("layer-surface ack'ed serial %d", self->layer_surface->current.configure_serial);
@@ -379,6 +384,8 @@ handle_unmap (struct wl_listener *listener, void *data)
   wl_list_remove (&self->new_subsurface.link);
   phoc_layer_surface_drop_child_surfaces (self);
 
+  /* Nothing to show anymore, the layout transaction doesn't apply */
+  phoc_renderer_drop_saved_element (phoc_server_get_renderer (phoc_server_get_default ()), self);
   phoc_layer_surface_damage_whole (self);
   phoc_input_update_cursor_focus (input);
 
@@ -490,8 +497,10 @@ phoc_layer_surface_finalize (GObject *object)
   g_assert (!self->layer_surface->surface->mapped);
 
   wl_list_remove (&self->link);
-  if (output)
+  if (output) {
     phoc_output_set_layer_dirty (output, self->layer);
+    phoc_output_remove_layer_surface_bounds (output, self);
+  }
 
   wl_list_remove (&self->destroy.link);
   wl_list_remove (&self->map.link);
@@ -646,6 +655,52 @@ phoc_layer_surface_get_mapped (PhocLayerSurface *self)
   return self->mapped;
 }
 
+typedef struct {
+  int x1, y1, x2, y2;
+} LayerSurfaceBoundsData;
+
+
+static void
+layer_surface_bounds_iterator (struct wlr_surface *wlr_surface, int sx, int sy, void *user_data)
+{
+  LayerSurfaceBoundsData *data = user_data;
+
+  data->x1 = MIN (data->x1, sx);
+  data->y1 = MIN (data->y1, sy);
+  data->x2 = MAX (data->x2, sx + wlr_surface->current.width);
+  data->y2 = MAX (data->y2, sy + wlr_surface->current.height);
+}
+
+/**
+ * phoc_layer_surface_get_input_bounds:
+ * @self: The layer surface
+ * @bounds: (out): The bounds
+ *
+ * Gets a box in output local coordinates that contains all positions
+ * where the layer surface or its popups and subsurfaces can receive
+ * input. The box is empty when the layer surface isn't mapped.
+ */
+void
+phoc_layer_surface_get_input_bounds (PhocLayerSurface *self, struct wlr_box *bounds)
+{
+  LayerSurfaceBoundsData data = { G_MAXINT, G_MAXINT, G_MININT, G_MININT };
+
+  g_assert (PHOC_IS_LAYER_SURFACE (self));
+
+  *bounds = (struct wlr_box){ 0 };
+  if (!self->mapped || !self->layer_surface)
+    return;
+
+  wlr_layer_surface_v1_for_each_surface (self->layer_surface, layer_surface_bounds_iterator, &data);
+  if (data.x1 > data.x2 || data.y1 > data.y2)
+    return;
+
+  bounds->x = self->geo.x + data.x1;
+  bounds->y = self->geo.y + data.y1;
+  bounds->width = data.x2 - data.x1;
+  bounds->height = data.y2 - data.y1;
+}
+
 /**
  * phoc_layer_surface_covers_output:
  * @self: The layer surface
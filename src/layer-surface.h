@@ -54,6 +54,8 @@ enum zwlr_layer_shell_v1_layer
 gboolean          phoc_layer_surface_get_mapped (PhocLayerSurface *self);
 gboolean          phoc_layer_surface_covers_output (PhocLayerSurface *self);
 struct wlr_box    phoc_layer_surface_get_geometry (PhocLayerSurface *self);
+void              phoc_layer_surface_get_input_bounds (PhocLayerSurface *self,
+                                                       struct wlr_box   *bounds);
 
 void              phoc_layer_surface_send_configure (PhocLayerSurface *self);
 uint32_t          phoc_layer_surface_get_pending_serial (PhocLayerSurface *self);
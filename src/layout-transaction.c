@@ -19,8 +19,15 @@
 /**
  * PhocLayoutTransaction:
  *
- * Track configures from layer surfaces and emit a signal when all of
- * them have committed new matching buffers.
+ * Track configures from layer surfaces and views and emit a signal
+ * when all of them have committed new matching buffers.
+ *
+ * While the transaction is in progress the elements that are part of
+ * it keep showing their buffers from before the layout change so
+ * intermediate states with only some of the clients updated never
+ * make it to the screen. Everything else is rendered as usual. Once
+ * all configures got acked (or the timeout expired) the new state is
+ * shown in a single frame.
  */
 
 #define TIMEOUT_LAYER_MS 3000
@@ -37,7 +44,11 @@ struct _PhocLayoutTransaction {
 
   gint64                starttime;
   guint                 pending_layer_configures;
+  guint                 pending_view_configures;
   guint                 layer_timer_id;
+  /* Identifies the current transaction */
+  guint                 id;
+  gboolean              has_saved_elements;
 };
 G_DEFINE_TYPE (PhocLayoutTransaction, phoc_layout_transaction, G_TYPE_OBJECT)
 
@@ -45,19 +56,30 @@ G_DEFINE_TYPE (PhocLayoutTransaction, phoc_layout_transaction, G_TYPE_OBJECT)
 static void
 apply_transaction (PhocLayoutTransaction *self)
 {
-  g_debug ("Would apply layout transaction");
+  /* Views still referring to this transaction are ignored from now on */
+  self->id = self->id == G_MAXUINT ? 1 : self->id + 1;
+  if (!self->has_saved_elements)
+    return;
+
+  self->has_saved_elements = FALSE;
+  g_debug ("Applying layout transaction");
+
+  phoc_renderer_drop_saved_elements (phoc_server_get_renderer (phoc_server_get_default ()));
 }
 
 
 static void
 abort_transaction (PhocLayoutTransaction *self)
 {
-  g_return_if_fail (self->pending_layer_configures);
+  gboolean was_active = phoc_layout_transaction_is_active (self);
+
+  self->pending_layer_configures = 0;
+  self->pending_view_configures = 0;
 
   apply_transaction (self);
 
-  self->pending_layer_configures = 0;
-  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
+  if (was_active)
+    g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
 }
 
 
@@ -67,12 +89,44 @@ on_timeout_expired (gpointer user_data)
   PhocLayoutTransaction *self = PHOC_LAYOUT_TRANSACTION (user_data);
 
   self->layer_timer_id = 0;
-  g_warning ("Timeout (%dms) expired with %u configures pending",
-             TIMEOUT_LAYER_MS, self->pending_layer_configures);
+  g_warning ("Timeout (%dms) expired with %u layer and %u view configures pending",
+             TIMEOUT_LAYER_MS, self->pending_layer_configures, self->pending_view_configures);
   abort_transaction (self);
 }
 
 
+static void
+start_transaction (PhocLayoutTransaction *self)
+{
+  if (self->layer_timer_id)
+    return;
+
+  g_debug ("Starting new layout transaction");
+  self->starttime = g_get_monotonic_time ();
+  self->layer_timer_id = g_timeout_add_once (TIMEOUT_LAYER_MS, on_timeout_expired, self);
+  g_source_set_name_by_id (self->layer_timer_id, "[phoc] layout transaction timer");
+}
+
+
+static void
+finish_transaction (PhocLayoutTransaction *self)
+{
+  gint64 now;
+
+  if (phoc_layout_transaction_is_active (self))
+    return;
+
+  /* All outstanding configures committed buffers */
+  now = g_get_monotonic_time ();
+  g_debug ("Layout transaction finished after %" G_GINT64_FORMAT "ms",
+           (now - self->starttime) / 1000);
+  g_clear_handle_id (&self->layer_timer_id, g_source_remove);
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
+
+  apply_transaction (self);
+}
+
+
 static void
 phoc_layout_transaction_get_property (GObject    *object,
                                       guint       property_id,
@@ -135,6 +189,8 @@ phoc_layout_transaction_class_init (PhocLayoutTransactionClass *klass)
 static void
 phoc_layout_transaction_init (PhocLayoutTransaction *self)
 {
+  /* 0 is used by views that aren't part of any transaction */
+  self->id = 1;
 }
 
 /**
@@ -163,7 +219,33 @@ phoc_layout_transaction_is_active (PhocLayoutTransaction *self)
 {
   g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
 
-  return self->pending_layer_configures > 0;
+  return self->pending_layer_configures > 0 || self->pending_view_configures > 0;
+}
+
+/**
+ * phoc_layout_transaction_save_element:
+ * @self: The transaction
+ * @element: The view or layer surface to save
+ *
+ * Save the current buffers of @element so they keep being shown until
+ * the transaction is applied. This needs to be invoked before the
+ * element's layout changes, the buffers are only saved once per
+ * transaction.
+ */
+void
+phoc_layout_transaction_save_element (PhocLayoutTransaction *self, gpointer element)
+{
+  PhocRenderer *renderer = phoc_server_get_renderer (phoc_server_get_default ());
+
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+  g_assert (PHOC_IS_VIEW (element) || PHOC_IS_LAYER_SURFACE (element));
+
+  g_debug ("Saving %p for layout transaction", element);
+  self->has_saved_elements = TRUE;
+  phoc_renderer_save_element (renderer, element);
+
+  /* Ensure the saved buffers go away even if no configures get added */
+  start_transaction (self);
 }
 
 /**
@@ -177,19 +259,20 @@ phoc_layout_transaction_is_active (PhocLayoutTransaction *self)
 void
 phoc_layout_transaction_add_layer_dirty (PhocLayoutTransaction *self)
 {
+  gboolean was_active;
+
   g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
 
+  was_active = phoc_layout_transaction_is_active (self);
   self->pending_layer_configures++;
-  if (self->pending_layer_configures > 1) {
-    g_debug ("Layout transaction, adding %dth pending configure", self->pending_layer_configures);
+  if (was_active) {
+    g_debug ("Layout transaction, adding %dth pending layer configure",
+             self->pending_layer_configures);
     return;
   }
 
   /* Outstanding configures. Transaction started */
-  g_debug ("Starting new layout transaction");
-  self->starttime = g_get_monotonic_time ();
-  self->layer_timer_id = g_timeout_add_once (TIMEOUT_LAYER_MS, on_timeout_expired, self);
-  g_source_set_name_by_id (self->layer_timer_id, "[phoc] layout transaction timer");
+  start_transaction (self);
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
 }
 
@@ -204,24 +287,72 @@ phoc_layout_transaction_add_layer_dirty (PhocLayoutTransaction *self)
 void
 phoc_layout_transaction_notify_layer_configured (PhocLayoutTransaction *self)
 {
-  gint64 now;
-
   g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
 
   g_return_if_fail (self->pending_layer_configures > 0);
 
   self->pending_layer_configures--;
   if (self->pending_layer_configures) {
-    g_debug ("Layout transaction has %u configures pending", self->pending_layer_configures);
+    g_debug ("Layout transaction has %u layer configures pending", self->pending_layer_configures);
     return;
   }
 
-  /* All outstanding configures committed buffers */
-  now = g_get_monotonic_time ();
-  g_debug ("Layout transaction finished after %" G_GINT64_FORMAT "ms",
-           (now - self->starttime) / 1000);
-  g_clear_handle_id (&self->layer_timer_id, g_source_remove);
-  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ACTIVE]);
+  finish_transaction (self);
+}
 
-  apply_transaction (self);
+/**
+ * phoc_layout_transaction_add_view_dirty:
+ * @self: The transaction
+ * @id: (inout): The id of the transaction the view is part of or `0`
+ *
+ * Invoked by views when they get configured while a transaction is
+ * active. If the view isn't part of the current transaction yet it's
+ * added and @id is updated. Once the view committed a matching buffer
+ * it needs to invoke [method@LayoutTransaction.notify_view_configured].
+ */
+void
+phoc_layout_transaction_add_view_dirty (PhocLayoutTransaction *self, guint *id)
+{
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+  g_assert (id);
+
+  if (!phoc_layout_transaction_is_active (self) || *id == self->id)
+    return;
+
+  *id = self->id;
+  self->pending_view_configures++;
+  g_debug ("Layout transaction, adding %dth pending view configure",
+           self->pending_view_configures);
+}
+
+/**
+ * phoc_layout_transaction_notify_view_configured:
+ * @self: The transaction
+ * @id: (inout): The id set by [method@LayoutTransaction.add_view_dirty]
+ *
+ * Invoked by views when they committed a buffer matching the
+ * configure they got as part of a transaction. Views that are unmapped
+ * before doing so need to invoke this too. @id is reset to `0`. If the
+ * transaction got applied in the meantime this does nothing.
+ */
+void
+phoc_layout_transaction_notify_view_configured (PhocLayoutTransaction *self, guint *id)
+{
+  gboolean current;
+
+  g_assert (PHOC_IS_LAYOUT_TRANSACTION (self));
+  g_assert (id);
+
+  current = *id == self->id;
+  *id = 0;
+  if (!current || self->pending_view_configures == 0)
+    return;
+
+  self->pending_view_configures--;
+  if (self->pending_view_configures) {
+    g_debug ("Layout transaction has %u view configures pending", self->pending_view_configures);
+    return;
+  }
+
+  finish_transaction (self);
 }
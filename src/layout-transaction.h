@@ -20,5 +20,11 @@ PhocLayoutTransaction *
 gboolean          phoc_layout_transaction_is_active (PhocLayoutTransaction *self);
 void              phoc_layout_transaction_notify_layer_configured (PhocLayoutTransaction *self);
 void              phoc_layout_transaction_add_layer_dirty (PhocLayoutTransaction *self);
+void              phoc_layout_transaction_add_view_dirty (PhocLayoutTransaction *self,
+                                                          guint                 *id);
+void              phoc_layout_transaction_notify_view_configured (PhocLayoutTransaction *self,
+                                                                  guint                 *id);
+void              phoc_layout_transaction_save_element (PhocLayoutTransaction *self,
+                                                        gpointer               element);
 
 G_END_DECLS
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-motion-queue"
+
+#include "phoc-config.h"
+
+#include "motion-queue.h"
+
+/**
+ * PhocMotionQueue:
+ *
+ * Coalesces motion events until they're flushed.
+ *
+ * Input devices can report motion way more often than the output
+ * refreshes. Sending every single event makes clients process motion
+ * they can never present. The queue only keeps the most recent motion
+ * of each pointer or touch point (identified by `id`) and emits it
+ * when the queue is flushed, usually at the start of the next output
+ * frame.
+ *
+ * A frame event that arrives while motion is pending is deferred as
+ * well so it terminates the coalesced motion when that gets
+ * flushed. Users must flush the queue before sending any other event
+ * (like button presses) to keep the order of events intact.
+ */
+
+enum {
+  MOTION,
+  FRAME,
+  N_SIGNALS
+};
+static guint signals[N_SIGNALS];
+
+typedef struct {
+  int      id;
+  gpointer target;
+  guint32  time_msec;
+  double   x, y;
+} PhocMotion;
+
+struct _PhocMotionQueue {
+  GObject   parent;
+
+  /* Pending motion, in order of the first event of each id */
+  GArray   *motions;
+  gboolean  frame_pending;
+};
+G_DEFINE_TYPE (PhocMotionQueue, phoc_motion_queue, G_TYPE_OBJECT)
+
+
+static void
+phoc_motion_queue_finalize (GObject *object)
+{
+  PhocMotionQueue *self = PHOC_MOTION_QUEUE (object);
+
+  g_clear_pointer (&self->motions, g_array_unref);
+
+  G_OBJECT_CLASS (phoc_motion_queue_parent_class)->finalize (object);
+}
+
+
+static void
+phoc_motion_queue_class_init (PhocMotionQueueClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phoc_motion_queue_finalize;
+
+  /**
+   * PhocMotionQueue::motion:
+   * @self: The motion queue
+   * @id: The id of the pointer or touch point
+   * @target: The target as passed to [method@MotionQueue.push]
+   * @time_msec: The time of the most recent motion
+   * @x: The most recent x position
+   * @y: The most recent y position
+   *
+   * Emitted for each id with pending motion when the queue is flushed.
+   */
+  signals[MOTION] = g_signal_new ("motion",
+                                  G_TYPE_FROM_CLASS (klass),
+                                  G_SIGNAL_RUN_LAST,
+                                  0,
+                                  NULL, NULL, NULL,
+                                  G_TYPE_NONE,
+                                  5,
+                                  G_TYPE_INT,
+                                  G_TYPE_POINTER,
+                                  G_TYPE_UINT,
+                                  G_TYPE_DOUBLE,
+                                  G_TYPE_DOUBLE);
+  /**
+   * PhocMotionQueue::frame:
+   * @self: The motion queue
+   *
+   * Emitted after the pending motion when a frame event got deferred.
+   */
+  signals[FRAME] = g_signal_new ("frame",
+                                 G_TYPE_FROM_CLASS (klass),
+                                 G_SIGNAL_RUN_LAST,
+                                 0,
+                                 NULL, NULL, NULL,
+                                 G_TYPE_NONE, 0);
+}
+
+
+static void
+phoc_motion_queue_init (PhocMotionQueue *self)
+{
+  self->motions = g_array_new (FALSE, FALSE, sizeof (PhocMotion));
+}
+
+
+PhocMotionQueue *
+phoc_motion_queue_new (void)
+{
+  return g_object_new (PHOC_TYPE_MOTION_QUEUE, NULL);
+}
+
+/**
+ * phoc_motion_queue_push:
+ * @self: The motion queue
+ * @id: The id of the pointer or touch point
+ * @target: The motion's target, e.g. the surface
+ * @time_msec: The time of the motion
+ * @x: The x position
+ * @y: The y position
+ *
+ * Queues a motion event replacing any pending motion of the same
+ * @id. A change of @target doesn't flush, callers have to do that
+ * before pushing the motion for the new target.
+ */
+void
+phoc_motion_queue_push (PhocMotionQueue *self,
+                        int              id,
+                        gpointer         target,
+                        guint32          time_msec,
+                        double           x,
+                        double           y)
+{
+  PhocMotion motion = {
+    .id = id,
+    .target = target,
+    .time_msec = time_msec,
+    .x = x,
+    .y = y,
+  };
+
+  g_assert (PHOC_IS_MOTION_QUEUE (self));
+
+  for (guint i = 0; i < self->motions->len; i++) {
+    PhocMotion *pending = &g_array_index (self->motions, PhocMotion, i);
+
+    if (pending->id == id) {
+      *pending = motion;
+      return;
+    }
+  }
+
+  g_array_append_val (self->motions, motion);
+}
+
+/**
+ * phoc_motion_queue_push_frame:
+ * @self: The motion queue
+ *
+ * Defers a frame event if there's pending motion.
+ *
+ * Returns: `TRUE` if the frame got deferred. Otherwise the caller
+ *   needs to send the frame right away.
+ */
+gboolean
+phoc_motion_queue_push_frame (PhocMotionQueue *self)
+{
+  g_assert (PHOC_IS_MOTION_QUEUE (self));
+
+  if (self->motions->len == 0)
+    return FALSE;
+
+  self->frame_pending = TRUE;
+  return TRUE;
+}
+
+/**
+ * phoc_motion_queue_is_pending:
+ * @self: The motion queue
+ *
+ * Returns: `TRUE` if there's motion waiting to be flushed
+ */
+gboolean
+phoc_motion_queue_is_pending (PhocMotionQueue *self)
+{
+  g_assert (PHOC_IS_MOTION_QUEUE (self));
+
+  return self->motions->len > 0;
+}
+
+/**
+ * phoc_motion_queue_flush:
+ * @self: The motion queue
+ *
+ * Emits the pending motion followed by a deferred frame event, if
+ * any, and empties the queue.
+ */
+void
+phoc_motion_queue_flush (PhocMotionQueue *self)
+{
+  g_autoptr (GArray) motions = NULL;
+  gboolean frame_pending;
+
+  g_assert (PHOC_IS_MOTION_QUEUE (self));
+
+  if (self->motions->len == 0)
+    return;
+
+  /* Handlers may push new motion */
+  motions = g_steal_pointer (&self->motions);
+  self->motions = g_array_new (FALSE, FALSE, sizeof (PhocMotion));
+  frame_pending = self->frame_pending;
+  self->frame_pending = FALSE;
+
+  for (guint i = 0; i < motions->len; i++) {
+    PhocMotion *motion = &g_array_index (motions, PhocMotion, i);
+
+    g_signal_emit (self, signals[MOTION], 0,
+                   motion->id, motion->target, motion->time_msec, motion->x, motion->y);
+  }
+
+  if (frame_pending)
+    g_signal_emit (self, signals[FRAME], 0);
+}
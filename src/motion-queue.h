@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PHOC_TYPE_MOTION_QUEUE (phoc_motion_queue_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocMotionQueue, phoc_motion_queue, PHOC, MOTION_QUEUE, GObject)
+
+PhocMotionQueue *phoc_motion_queue_new        (void);
+void             phoc_motion_queue_push       (PhocMotionQueue *self,
+                                               int              id,
+                                               gpointer         target,
+                                               guint32          time_msec,
+                                               double           x,
+                                               double           y);
+gboolean         phoc_motion_queue_push_frame (PhocMotionQueue *self);
+gboolean         phoc_motion_queue_is_pending (PhocMotionQueue *self);
+void             phoc_motion_queue_flush      (PhocMotionQueue *self);
+
+G_END_DECLS
@@ -7,12 +7,15 @@
 #define _POSIX_C_SOURCE 200809L
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <wlr/backend/drm.h>
 #include <wlr/config.h>
 #include <wlr/render/swapchain.h>
 #include <wlr/types/wlr_compositor.h>
+#include <wlr/types/wlr_data_device.h>
 #include <wlr/types/wlr_gamma_control_v1.h>
+#include <wlr/types/wlr_output_layer.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_output_power_management_v1.h>
 #include <wlr/types/wlr_xdg_shell.h>
@@ -23,7 +26,9 @@
 #include "bling.h"
 #include "cursor.h"
 #include "cutouts-overlay.h"
+#include "frame-clock.h"
 #include "settings.h"
+#include "spatial-index.h"
 #include "layer-shell.h"
 #include "layer-shell-effects.h"
 #include "layout-transaction.h"
@@ -31,6 +36,7 @@
 #include "output-shield.h"
 #include "render.h"
 #include "render-private.h"
+#include "render-scheduler.h"
 #include "seat.h"
 #include "server.h"
 #include "surface.h"
@@ -46,19 +52,35 @@ enum {
 };
 static GParamSpec *props[PROP_LAST_PROP];
 
+/* Max number of overlay planes we try to put surfaces on */
+#define PHOC_OUTPUT_MAX_OVERLAY_PLANES 3
+
 enum {
   OUTPUT_DESTROY,
   N_SIGNALS
 };
 static guint signals[N_SIGNALS];
 
+/* A plane candidate as passed to a test commit */
+typedef struct {
+  struct wlr_surface *surface;
+  struct wlr_box      dst_box;
+  int                 width;
+  int                 height;
+  uint32_t            format;
+  uint64_t            modifier;
+  gboolean            accepted;
+} PhocPlaneAssignment;
+
 typedef struct _PhocOutputPrivate {
   PhocRenderer            *renderer;
   PhocOutputShield        *shield;
 
   GSList                  *frame_callbacks;
   gint                     frame_callback_next_id;
-  gint64                   last_frame_us;
+  PhocFrameClock          *frame_clock;
+  PhocRenderScheduler     *render_scheduler;
+  gint64                   deferred_frame_time;
 
   PhocCutoutsOverlay      *cutouts;
   gulong                   render_cutouts_id;
@@ -70,6 +92,7 @@ typedef struct _PhocOutputPrivate {
   struct wl_listener     damage;
   struct wl_listener     frame;
   struct wl_listener     needs_frame;
+  struct wl_listener     present;
   struct wl_listener     request_state;
 
   PhocOutputScaleFilter  scale_filter;
@@ -81,10 +104,37 @@ typedef struct _PhocOutputPrivate {
   gboolean               modeset_shield;
 
   GSList                *debug_damage;
+
+  guint32                mask;
+
+  GHashTable            *frame_done_surfaces; /* PhocSurface */
+
+  PhocSpatialIndex      *layer_index; /* PhocLayerSurface */
+
+  PhocFrameStats        *frame_stats;
+  /* The last frame we committed, to match up presentation feedback */
+  guint32                stats_commit_seq;
+  gint64                 stats_commit_ns;
+  /* The vblank a deferred frame needs to meet */
+  gint64                 commit_deadline_us;
+
+  /* Overlay planes */
+  struct wlr_output_layer       *overlay_layers[PHOC_OUTPUT_MAX_OVERLAY_PLANES];
+  struct wlr_output_layer_state  overlay_states[PHOC_OUTPUT_MAX_OVERLAY_PLANES];
+  GPtrArray                     *plane_surfaces; /* struct wlr_surface */
+  /* Everything considered for a plane in the last frame */
+  GPtrArray                     *plane_candidates; /* struct wlr_surface */
+  /* The candidates of the last test commit and the backend's verdict */
+  PhocPlaneAssignment            tested_planes[PHOC_OUTPUT_MAX_OVERLAY_PLANES];
+  guint                          n_tested_planes;
+  /* Surfaces we sent scanout dmabuf feedback */
+  GPtrArray                     *scanout_feedback_surfaces; /* PhocSurface */
 } PhocOutputPrivate;
 
 static void phoc_output_initable_iface_init (GInitableIface *iface);
 
+static void on_render_deadline (PhocOutput *self, PhocRenderScheduler *scheduler);
+
 static void phoc_output_animatable_interface_init (PhocAnimatableInterface *iface);
 
 G_DEFINE_TYPE_WITH_CODE (PhocOutput, phoc_output, G_TYPE_OBJECT,
@@ -97,8 +147,7 @@ G_DEFINE_TYPE_WITH_CODE (PhocOutput, phoc_output, G_TYPE_OBJECT,
 
 static void phoc_output_for_each_surface (PhocOutput          *self,
                                           PhocSurfaceIterator  iterator,
-                                          void                *user_data,
-                                          gboolean             visible_only);
+                                          void                *user_data);
 
 typedef struct {
   PhocAnimatable    *animatable;
@@ -296,7 +345,10 @@ phoc_output_init (PhocOutput *self)
   PhocOutputPrivate *priv = phoc_output_get_instance_private(self);
 
   priv->frame_callback_next_id = 1;
-  priv->last_frame_us = g_get_monotonic_time ();
+  priv->frame_clock = phoc_frame_clock_new ();
+  priv->render_scheduler = phoc_render_scheduler_new ();
+  g_signal_connect_swapped (priv->render_scheduler, "render",
+                            G_CALLBACK (on_render_deadline), self);
   priv->shield = phoc_output_shield_new (self);
 
   wl_list_init (&self->layer_surfaces);
@@ -304,11 +356,19 @@ phoc_output_init (PhocOutput *self)
   wl_list_init (&priv->damage.link);
   wl_list_init (&priv->frame.link);
   wl_list_init (&priv->needs_frame.link);
+  wl_list_init (&priv->present.link);
   wl_list_init (&priv->request_state.link);
   wl_list_init (&self->commit.link);
   wl_list_init (&self->output_destroy.link);
 
   priv->scale_filter = PHOC_OUTPUT_SCALE_FILTER_AUTO;
+  priv->frame_done_surfaces = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                     g_object_unref, NULL);
+  priv->layer_index = phoc_spatial_index_new ();
+  priv->frame_stats = phoc_frame_stats_new ();
+  priv->plane_surfaces = g_ptr_array_new ();
+  priv->plane_candidates = g_ptr_array_new ();
+  priv->scanout_feedback_surfaces = g_ptr_array_new_with_free_func (g_object_unref);
 
   priv->renderer = g_object_ref (phoc_server_get_renderer (server));
 
@@ -360,10 +420,14 @@ phoc_output_handle_destroy (struct wl_listener *listener, void *data)
   if (self->fullscreen_view)
     phoc_view_set_fullscreen (self->fullscreen_view, false, NULL);
 
+  /* Don't let a deferred frame fire on a destroyed output */
+  phoc_render_scheduler_reset (priv->render_scheduler);
+
   wl_list_remove (&priv->request_state.link);
   wl_list_remove (&priv->damage.link);
   wl_list_remove (&priv->frame.link);
   wl_list_remove (&priv->needs_frame.link);
+  wl_list_remove (&priv->present.link);
   wl_list_remove (&self->commit.link);
   wl_list_remove (&self->output_destroy.link);
 
@@ -424,16 +488,67 @@ phoc_output_set_gamma_lut (PhocOutput *self, struct wlr_output_state *pending)
 }
 
 
+/*
+ * Check whether the surface is shown on the output so it should get
+ * its frame callbacks. Subsurfaces and popups are attributed to the
+ * layer surface or view they belong to.
+ */
+static gboolean
+surface_is_visible_on_output (PhocOutput *self, struct wlr_surface *wlr_surface)
+{
+  struct wlr_surface *root = wlr_surface_get_root_surface (wlr_surface);
+  struct wlr_layer_surface_v1 *layer_surface;
+  struct wlr_xdg_surface *xdg_surface;
+  PhocSurface *surface;
+  PhocView *view;
+
+  while ((xdg_surface = wlr_xdg_surface_try_from_wlr_surface (root)) &&
+         xdg_surface->role == WLR_XDG_SURFACE_ROLE_POPUP &&
+         xdg_surface->popup->parent) {
+    root = wlr_surface_get_root_surface (xdg_surface->popup->parent);
+  }
+
+  layer_surface = wlr_layer_surface_v1_try_from_wlr_surface (root);
+  if (layer_surface)
+    return layer_surface->output == self->wlr_output;
+
+  if (wlr_drag_icon_try_from_wlr_surface (root))
+    return TRUE;
+
+  /* Views register with their root surface so there's no need to walk the view stack */
+  surface = root->data;
+  view = surface ? phoc_surface_get_view (surface) : NULL;
+  if (view)
+    return phoc_desktop_view_is_visible_on_output (self->desktop, view, self);
+
+  return FALSE;
+}
+
+/*
+ * Send frame done to the surfaces with pending frame callbacks that
+ * are visible on this output. Surfaces that aren't visible stay in
+ * the index so they get their frame done once they become visible.
+ */
 static void
-surface_send_frame_done_iterator (PhocOutput         *output,
-                                  struct wlr_surface *wlr_surface,
-                                  struct wlr_box     *box,
-                                  float               scale,
-                                  void               *data)
+send_frame_done (PhocOutput *self, struct timespec *when)
 {
-  struct timespec *when = data;
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  GHashTableIter iter;
+  PhocSurface *surface;
 
-  wlr_surface_send_frame_done (wlr_surface, when);
+  g_hash_table_iter_init (&iter, priv->frame_done_surfaces);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&surface, NULL)) {
+    struct wlr_surface *wlr_surface = phoc_surface_get_wlr_surface (surface);
+
+    if (wlr_surface && !wl_list_empty (&wlr_surface->current.frame_callback_list)) {
+      if (!surface_is_visible_on_output (self, wlr_surface))
+        continue;
+
+      wlr_surface_send_frame_done (wlr_surface, when);
+    }
+
+    g_hash_table_iter_remove (&iter);
+  }
 }
 
 
@@ -453,6 +568,7 @@ count_surface_iterator (PhocOutput         *output,
 PHOC_TRACE_NO_INLINE static bool
 scan_out_fullscreen_view (PhocOutput *self, PhocView *view, struct wlr_output_state *pending)
 {
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
   PhocInput *input = phoc_server_get_input (phoc_server_get_default ());
   struct wlr_output *wlr_output = self->wlr_output;
   size_t n_surfaces = 0;
@@ -460,6 +576,10 @@ scan_out_fullscreen_view (PhocOutput *self, PhocView *view, struct wlr_output_st
 
   g_assert (PHOC_IS_VIEW (view));
 
+  /* Saved buffers are shown until the layout transaction is done */
+  if (phoc_renderer_is_element_saved (priv->renderer, view))
+    return false;
+
   for (GSList *elem = phoc_input_get_seats (input); elem; elem = elem->next) {
     PhocSeat *seat = PHOC_SEAT (elem->data);
     PhocDragIcon *drag_icon;
@@ -511,6 +631,184 @@ scan_out_fullscreen_view (PhocOutput *self, PhocView *view, struct wlr_output_st
 }
 
 
+static gboolean
+overlay_planes_usable (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  PhocServer *server = phoc_server_get_default ();
+  guint render_end_id;
+
+  /* Screen capture and software cursors need everything composited */
+  if (!wlr_output_is_direct_scanout_allowed (self->wlr_output))
+    return FALSE;
+
+  /* Anything drawn on top of the composited content would end up below the planes */
+  if (phoc_server_check_debug_flags (server, PHOC_SERVER_DEBUG_FLAG_DAMAGE_TRACKING) ||
+      phoc_server_check_debug_flags (server, PHOC_SERVER_DEBUG_FLAG_TOUCH_POINTS)) {
+    return FALSE;
+  }
+
+  render_end_id = g_signal_lookup ("render-end", PHOC_TYPE_RENDERER);
+  if (g_signal_has_handler_pending (priv->renderer, render_end_id, 0, FALSE))
+    return FALSE;
+
+  return TRUE;
+}
+
+
+static void
+set_overlay_layers (PhocOutput *self, struct wlr_output_state *pending)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  /* Layers are created on first use */
+  if (priv->overlay_layers[0] == NULL)
+    return;
+
+  for (int i = 0; i < PHOC_OUTPUT_MAX_OVERLAY_PLANES; i++)
+    priv->overlay_states[i].layer = priv->overlay_layers[i];
+
+  /* All layers need to be part of every commit */
+  wlr_output_state_set_layers (pending, priv->overlay_states, PHOC_OUTPUT_MAX_OVERLAY_PLANES);
+}
+
+
+static void
+update_plane_surfaces (PhocOutput *self, struct wlr_surface **surfaces, guint n_surfaces)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  gboolean changed = priv->plane_surfaces->len != n_surfaces;
+
+  for (guint i = 0; !changed && i < n_surfaces; i++)
+    changed = g_ptr_array_index (priv->plane_surfaces, i) != surfaces[i];
+
+  if (!changed)
+    return;
+
+  g_ptr_array_set_size (priv->plane_surfaces, 0);
+  for (guint i = 0; i < n_surfaces; i++)
+    g_ptr_array_add (priv->plane_surfaces, surfaces[i]);
+
+  /* Whatever is below surfaces leaving or entering planes needs to be redrawn */
+  wlr_damage_ring_add_whole (&self->damage_ring);
+}
+
+static void
+get_plane_assignment (struct wlr_output_layer_state *state,
+                      struct wlr_surface            *surface,
+                      PhocPlaneAssignment           *assignment)
+{
+  struct wlr_dmabuf_attributes dmabuf;
+
+  *assignment = (PhocPlaneAssignment) {
+    .surface = surface,
+    .dst_box = state->dst_box,
+    .width = state->buffer->width,
+    .height = state->buffer->height,
+    .accepted = state->accepted,
+  };
+
+  if (wlr_buffer_get_dmabuf (state->buffer, &dmabuf)) {
+    assignment->format = dmabuf.format;
+    assignment->modifier = dmabuf.modifier;
+  }
+}
+
+/*
+ * Whether the candidates are the same as in the last test commit. In
+ * that case the backend's verdict still applies.
+ */
+static gboolean
+plane_assignment_is_tested (PhocOutput                    *self,
+                            struct wlr_output_layer_state *states,
+                            struct wlr_surface           **surfaces,
+                            guint                          n_surfaces)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  if (n_surfaces != priv->n_tested_planes)
+    return FALSE;
+
+  for (guint i = 0; i < n_surfaces; i++) {
+    PhocPlaneAssignment *tested = &priv->tested_planes[i];
+    PhocPlaneAssignment assignment;
+
+    get_plane_assignment (&states[i], surfaces[i], &assignment);
+    if (assignment.surface != tested->surface ||
+        !wlr_box_equal (&assignment.dst_box, &tested->dst_box) ||
+        assignment.width != tested->width ||
+        assignment.height != tested->height ||
+        assignment.format != tested->format ||
+        assignment.modifier != tested->modifier) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/*
+ * Move surfaces that don't need composition to overlay planes and
+ * validate the result with a test commit. Surfaces that end up on a
+ * plane are tracked in plane_surfaces so the renderer skips them.
+ */
+PHOC_TRACE_NO_INLINE static void
+assign_overlay_planes (PhocOutput *self, struct wlr_output_state *pending)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  struct wlr_surface *surfaces[PHOC_OUTPUT_MAX_OVERLAY_PLANES];
+  struct wlr_surface *accepted[PHOC_OUTPUT_MAX_OVERLAY_PLANES];
+  struct wlr_output_layer_state *states = priv->overlay_states;
+  guint n_surfaces = 0, n_accepted = 0;
+
+  memset (states, 0, sizeof (priv->overlay_states));
+
+  if (overlay_planes_usable (self)) {
+    n_surfaces = phoc_renderer_assign_planes (priv->renderer, self, states, surfaces,
+                                              PHOC_OUTPUT_MAX_OVERLAY_PLANES);
+  }
+
+  if (n_surfaces && priv->overlay_layers[0] == NULL) {
+    for (int i = 0; i < PHOC_OUTPUT_MAX_OVERLAY_PLANES; i++)
+      priv->overlay_layers[i] = wlr_output_layer_create (self->wlr_output);
+  }
+
+  set_overlay_layers (self, pending);
+
+  g_ptr_array_set_size (priv->plane_candidates, 0);
+  for (guint i = 0; i < n_surfaces; i++)
+    g_ptr_array_add (priv->plane_candidates, surfaces[i]);
+
+  if (n_surfaces == 0)
+    goto out;
+
+  if (plane_assignment_is_tested (self, states, surfaces, n_surfaces)) {
+    /* Same as last time, skip the test commit */
+    for (guint i = 0; i < n_surfaces; i++)
+      states[i].accepted = priv->tested_planes[i].accepted;
+  } else {
+    if (!wlr_output_test_state (self->wlr_output, pending)) {
+      for (guint i = 0; i < n_surfaces; i++)
+        states[i].accepted = false;
+    }
+
+    for (guint i = 0; i < n_surfaces; i++)
+      get_plane_assignment (&states[i], surfaces[i], &priv->tested_planes[i]);
+    priv->n_tested_planes = n_surfaces;
+  }
+
+  for (guint i = 0; i < n_surfaces; i++) {
+    if (states[i].accepted)
+      accepted[n_accepted++] = surfaces[i];
+    else
+      states[i].buffer = NULL;
+  }
+
+ out:
+  update_plane_surfaces (self, accepted, n_accepted);
+}
+
+
 static void
 build_debug_damage_tracking (PhocOutput *self)
 {
@@ -560,7 +858,204 @@ build_debug_damage_tracking (PhocOutput *self)
 }
 
 
-PHOC_TRACE_NO_INLINE static void
+static guint64
+region_area (pixman_region32_t *region)
+{
+  const pixman_box32_t *rects;
+  guint64 area = 0;
+  int n_rects;
+
+  rects = pixman_region32_rectangles (region, &n_rects);
+  for (int i = 0; i < n_rects; i++)
+    area += (guint64)(rects[i].x2 - rects[i].x1) * (rects[i].y2 - rects[i].y1);
+
+  return area;
+}
+
+
+static gint64
+timespec_to_nsec (const struct timespec *ts)
+{
+  return (gint64)ts->tv_sec * G_NSEC_PER_SEC + ts->tv_nsec;
+}
+
+/* Remember the committed frame so we can measure its presentation latency */
+static void
+record_commit (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  struct timespec now;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  /* Present events carry the sequence number of the commit they belong to */
+  priv->stats_commit_seq = self->wlr_output->commit_seq;
+  priv->stats_commit_ns = timespec_to_nsec (&now);
+}
+
+
+static void
+phoc_output_handle_present (struct wl_listener *listener, void *data)
+{
+  PhocOutputPrivate *priv = wl_container_of (listener, priv, present);
+  struct wlr_output_event_present *event = data;
+  gint64 latency_ns;
+  gboolean missed;
+
+  if (event->presented) {
+    phoc_frame_clock_add_presentation (priv->frame_clock,
+                                       timespec_to_nsec (&event->when) / 1000,
+                                       event->refresh / 1000);
+  }
+
+  /* Not a frame we rendered (e.g. a modeset) or we already handled it */
+  if (priv->stats_commit_ns == 0 || event->commit_seq != priv->stats_commit_seq)
+    return;
+
+  latency_ns = timespec_to_nsec (&event->when) - priv->stats_commit_ns;
+  priv->stats_commit_ns = 0;
+
+  /* Back off if deferring made us miss the vblank */
+  if (priv->commit_deadline_us && event->presented &&
+      timespec_to_nsec (&event->when) / 1000 > priv->commit_deadline_us + event->refresh / 2000) {
+    phoc_render_scheduler_add_missed (priv->render_scheduler);
+  }
+  priv->commit_deadline_us = 0;
+
+  if (!event->presented) {
+    phoc_frame_stats_add_discarded (priv->frame_stats);
+    return;
+  }
+
+  /* We commit right after a vblank so anything taking longer than a
+   * refresh cycle missed the next one */
+  missed = event->refresh > 0 && latency_ns > event->refresh;
+  phoc_frame_stats_add_presented (priv->frame_stats, MAX (latency_ns, 0) / 1000, missed);
+}
+
+
+/*
+ * The view that would benefit from scanout capable buffers: the
+ * topmost view if it covers the output on its own.
+ */
+static PhocView *
+get_scanout_feedback_view (PhocOutput *self)
+{
+  guint32 mask = phoc_output_get_mask (self);
+  GQueue *views;
+
+  if (self->fullscreen_view)
+    return phoc_view_is_mapped (self->fullscreen_view) ? self->fullscreen_view : NULL;
+
+  if (phoc_output_has_shell_revealed (self))
+    return NULL;
+
+  views = phoc_desktop_get_views (self->desktop);
+  for (GList *l = views->head; l; l = l->next) {
+    PhocView *view = PHOC_VIEW (l->data);
+    guint32 visible_outputs;
+
+    if (!phoc_desktop_view_check_visibility (self->desktop, view))
+      continue;
+
+    visible_outputs = phoc_view_get_visible_outputs (view);
+    if (!(visible_outputs & mask))
+      continue;
+
+    /* Only send feedback for this output if the view isn't shown elsewhere */
+    if (!phoc_view_is_maximized (view) || visible_outputs != mask)
+      return NULL;
+
+    return view;
+  }
+
+  return NULL;
+}
+
+
+static void
+add_scanout_feedback_surface (GPtrArray *surfaces, struct wlr_surface *wlr_surface)
+{
+  PhocSurface *surface = wlr_surface ? wlr_surface->data : NULL;
+
+  if (!surface || g_ptr_array_find (surfaces, surface, NULL))
+    return;
+
+  g_ptr_array_add (surfaces, g_object_ref (surface));
+}
+
+/*
+ * Whether another output sent scanout feedback to the surface. That
+ * output is responsible for resetting it.
+ */
+static gboolean
+is_scanout_feedback_claimed (PhocOutput *self, PhocSurface *surface)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output;
+
+  if (desktop == NULL)
+    return FALSE;
+
+  wl_list_for_each (output, &desktop->outputs, link) {
+    PhocOutputPrivate *priv = phoc_output_get_instance_private (output);
+
+    if (output == self || priv->scanout_feedback_surfaces == NULL)
+      continue;
+
+    if (g_ptr_array_find (priv->scanout_feedback_surfaces, surface, NULL))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/*
+ * Publish scanout tranches to the topmost view and the plane
+ * candidates so they can allocate buffers suitable for direct scanout
+ * and overlay planes. Surfaces that aren't eligible anymore, e.g.
+ * because they got covered or moved, get the default feedback again.
+ */
+static void
+update_scanout_feedback (PhocOutput *self)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+  PhocServer *server = phoc_server_get_default ();
+  g_autoptr (GPtrArray) surfaces = g_ptr_array_new_with_free_func (g_object_unref);
+  PhocView *view = NULL;
+
+  if (self->wlr_output->enabled)
+    view = get_scanout_feedback_view (self);
+
+  if (view)
+    add_scanout_feedback_surface (surfaces, view->wlr_surface);
+
+  for (guint i = 0; i < priv->plane_candidates->len; i++)
+    add_scanout_feedback_surface (surfaces, g_ptr_array_index (priv->plane_candidates, i));
+
+  for (guint i = 0; i < priv->scanout_feedback_surfaces->len; i++) {
+    PhocSurface *surface = g_ptr_array_index (priv->scanout_feedback_surfaces, i);
+    struct wlr_surface *wlr_surface = phoc_surface_get_wlr_surface (surface);
+
+    if (wlr_surface && !g_ptr_array_find (surfaces, surface, NULL) &&
+        !is_scanout_feedback_claimed (self, surface))
+      phoc_server_set_linux_dmabuf_surface_feedback (server, wlr_surface, NULL);
+  }
+
+  for (guint i = 0; i < surfaces->len; i++) {
+    PhocSurface *surface = g_ptr_array_index (surfaces, i);
+    struct wlr_surface *wlr_surface = phoc_surface_get_wlr_surface (surface);
+
+    if (!g_ptr_array_find (priv->scanout_feedback_surfaces, surface, NULL))
+      phoc_server_set_linux_dmabuf_surface_feedback (server, wlr_surface, self);
+  }
+
+  g_ptr_array_unref (priv->scanout_feedback_surfaces);
+  priv->scanout_feedback_surfaces = g_steal_pointer (&surfaces);
+}
+
+
+/* Returns: Whether a frame got composited and committed */
+PHOC_TRACE_NO_INLINE static gboolean
 phoc_output_draw (PhocOutput *self)
 {
   PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
@@ -572,9 +1067,20 @@ phoc_output_draw (PhocOutput *self)
   struct wlr_render_pass *render_pass;
   struct wlr_output_state pending = { 0 };
   PhocServerDebugFlags flags;
-
-  if (!wlr_output->enabled)
-    return;
+  PhocConfig *config;
+  gint64 render_start_us;
+  guint64 damage_area;
+  gboolean simplified, composited = FALSE;
+  int n_damage_rects;
+
+  /* Candidates of earlier frames might be gone by now */
+  g_ptr_array_set_size (priv->plane_candidates, 0);
+
+  if (!wlr_output->enabled) {
+    if (priv->scanout_feedback_surfaces->len)
+      update_scanout_feedback (self);
+    return FALSE;
+  }
 
   needs_frame = wlr_output->needs_frame;
   needs_frame |= pixman_region32_not_empty (&self->damage_ring.current);
@@ -582,7 +1088,15 @@ phoc_output_draw (PhocOutput *self)
   needs_frame |= (priv->debug_damage != NULL);
 
   if (!needs_frame)
-    return;
+    return FALSE;
+
+  /* Clients can submit lots of small damage rectangles. Merge them as
+   * clipping cost grows with the number of rectangles. This also keeps
+   * the damage the ring keeps around for later buffers simple. */
+  config = phoc_server_get_config (phoc_server_get_default ());
+  simplified = phoc_utils_simplify_region (&self->damage_ring.current,
+                                           config->max_damage_rects,
+                                           config->damage_overdraw);
 
   if (G_UNLIKELY (priv->gamma_lut_changed))
     phoc_output_set_gamma_lut (self, &pending);
@@ -593,11 +1107,18 @@ phoc_output_draw (PhocOutput *self)
   pixman_region32_fini (&frame_damage);
 
   /* Check if we can delegate the fullscreen surface to the output */
-  if (self->fullscreen_view)
+  if (self->fullscreen_view) {
+    memset (priv->overlay_states, 0, sizeof (priv->overlay_states));
+    set_overlay_layers (self, &pending);
     scanned_out = scan_out_fullscreen_view (self, self->fullscreen_view, &pending);
+  }
 
-  if (scanned_out)
+  if (scanned_out) {
+    update_plane_surfaces (self, NULL, 0);
+    phoc_frame_stats_add_scanout (priv->frame_stats);
+    record_commit (self);
     goto out;
+  }
 
   if (!wlr_output_configure_primary_swapchain (wlr_output, &pending, &wlr_output->swapchain))
     goto out;
@@ -606,6 +1127,15 @@ phoc_output_draw (PhocOutput *self)
   if (!buffer)
     goto out;
 
+  render_start_us = g_get_monotonic_time ();
+  phoc_renderer_prepare_output (priv->renderer, self);
+
+  /* Test commits need the primary buffer attached, it's rendered to below */
+  wlr_output_state_set_buffer (&pending, buffer);
+  assign_overlay_planes (self, &pending);
+  /* Plane changes might have damaged the whole output */
+  wlr_output_state_set_damage (&pending, &self->damage_ring.current);
+
   render_pass = wlr_renderer_begin_buffer_pass (wlr_output->renderer, buffer, NULL);
   if (!render_pass) {
     wlr_buffer_unlock (buffer);
@@ -614,15 +1144,22 @@ phoc_output_draw (PhocOutput *self)
 
   pixman_region32_init (&buffer_damage);
   wlr_damage_ring_rotate_buffer (&self->damage_ring, buffer, &buffer_damage);
+  /* Adding the damage of older buffers can make it complex again */
+  simplified |= phoc_utils_simplify_region (&buffer_damage,
+                                            config->max_damage_rects,
+                                            config->damage_overdraw);
 
   render_context = (PhocRenderContext){
     .output = self,
     .damage = &buffer_damage,
     .alpha = 1.0,
     .render_pass = render_pass,
+    .plane_surfaces = priv->plane_surfaces,
   };
   phoc_renderer_render_output (priv->renderer, self, &render_context);
 
+  damage_area = region_area (&buffer_damage);
+  n_damage_rects = pixman_region32_n_rects (&buffer_damage);
   pixman_region32_fini (&buffer_damage);
 
   if (!wlr_render_pass_submit (render_pass)) {
@@ -632,27 +1169,47 @@ phoc_output_draw (PhocOutput *self)
     goto out;
   }
 
-  wlr_output_state_set_buffer (&pending, buffer);
+  phoc_frame_stats_add_composited (priv->frame_stats,
+                                   g_get_monotonic_time () - render_start_us,
+                                   damage_area);
+  phoc_frame_stats_add_damage_rects (priv->frame_stats, n_damage_rects, simplified);
+
   wlr_buffer_unlock (buffer);
 
-  if (!wlr_output_commit_state (wlr_output, &pending))
+  if (!wlr_output_commit_state (wlr_output, &pending)) {
+    /* Don't trust the plane configuration we didn't test */
+    priv->n_tested_planes = 0;
     goto out;
+  }
+
+  for (guint i = 0; i < priv->plane_surfaces->len; i++)
+    wlr_presentation_surface_scanned_out_on_output (g_ptr_array_index (priv->plane_surfaces, i),
+                                                    wlr_output);
+
+  record_commit (self);
+  composited = TRUE;
 
  out:
   wlr_output_state_finish (&pending);
 
+  update_scanout_feedback (self);
+
   flags = phoc_server_get_debug_flags (phoc_server_get_default ());
   if (G_UNLIKELY (flags & PHOC_SERVER_DEBUG_FLAG_DAMAGE_WHOLE))
     phoc_output_damage_whole (self);
+
+  return composited;
 }
 
 
 static void
-phoc_output_handle_frame (struct wl_listener *listener, void *data)
+phoc_output_frame (PhocOutput *self, gint64 frame_time)
 {
-  PhocOutputPrivate *priv = wl_container_of (listener, priv, frame);
-  PhocOutput *self = PHOC_OUTPUT_SELF (priv);
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
   struct timespec now;
+  gint64 start_us;
+
+  start_us = g_get_monotonic_time ();
 
   /* Process all registered frame callbacks */
   GSList *l = priv->frame_callbacks;
@@ -661,14 +1218,13 @@ phoc_output_handle_frame (struct wl_listener *listener, void *data)
     PhocOutputFrameCallbackInfo *cb_info = l->data;
     gboolean ret;
 
-    ret = cb_info->callback(cb_info->animatable, priv->last_frame_us, cb_info->user_data);
+    ret = cb_info->callback(cb_info->animatable, frame_time, cb_info->user_data);
     if (ret == G_SOURCE_REMOVE) {
       phoc_output_frame_callback_info_free (cb_info);
       priv->frame_callbacks = g_slist_delete_link (priv->frame_callbacks, l);
     }
     l = next;
   }
-  priv->last_frame_us = g_get_monotonic_time ();
 
   /* Ensure the cutouts are drawn */
   if (G_UNLIKELY (priv->cutouts_texture)) {
@@ -679,11 +1235,14 @@ phoc_output_handle_frame (struct wl_listener *listener, void *data)
   build_debug_damage_tracking (self);
 
   /* Repaint the output */
-  phoc_output_draw (self);
+  if (phoc_output_draw (self)) {
+    phoc_render_scheduler_add_render_time (priv->render_scheduler,
+                                           g_get_monotonic_time () - start_us);
+  }
 
-  /* Send frame done events to all visible surfaces */
+  /* Send frame done events to visible surfaces waiting for it */
   clock_gettime (CLOCK_MONOTONIC, &now);
-  phoc_output_for_each_surface (self, surface_send_frame_done_iterator, &now, true);
+  send_frame_done (self, &now);
 
   /* Want frame clock ticking as long as we have frame callbacks */
   if (priv->frame_callbacks)
@@ -695,6 +1254,63 @@ phoc_output_handle_frame (struct wl_listener *listener, void *data)
 }
 
 
+static void
+on_render_deadline (PhocOutput *self, PhocRenderScheduler *scheduler)
+{
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  if (!self->wlr_output || !self->wlr_output->enabled)
+    return;
+
+  priv->commit_deadline_us = priv->deferred_frame_time;
+  phoc_output_frame (self, priv->deferred_frame_time);
+}
+
+
+static void
+phoc_output_handle_frame (struct wl_listener *listener, void *data)
+{
+  PhocOutputPrivate *priv = wl_container_of (listener, priv, frame);
+  PhocOutput *self = PHOC_OUTPUT_SELF (priv);
+  PhocServer *server = phoc_server_get_default ();
+  PhocInput *input = phoc_server_get_input (server);
+  PhocConfig *config = phoc_server_get_config (server);
+  gint64 now, frame_time, start_us;
+
+  /* The deferred frame renders all pending updates */
+  if (phoc_render_scheduler_is_deferred (priv->render_scheduler))
+    return;
+
+  /* Hand coalesced motion to clients so they can respond in this frame */
+  for (GSList *l = phoc_input_get_seats (input); l; l = l->next) {
+    PhocSeat *seat = PHOC_SEAT (l->data);
+
+    if (seat->cursor)
+      phoc_cursor_flush_motion (seat->cursor);
+  }
+
+  /* Sample animations at the time the frame will be shown */
+  now = g_get_monotonic_time ();
+  phoc_frame_clock_set_refresh_rate (priv->frame_clock, self->wlr_output->refresh);
+  frame_time = phoc_frame_clock_get_frame_time (priv->frame_clock, now);
+
+  /* Render as late as possible so the frame includes late client commits */
+  if (config->render_deadline && phoc_frame_clock_is_synced (priv->frame_clock) &&
+      phoc_render_scheduler_get_start_time (priv->render_scheduler,
+                                            now,
+                                            frame_time,
+                                            phoc_frame_clock_get_refresh_interval (priv->frame_clock),
+                                            &start_us)) {
+    priv->deferred_frame_time = frame_time;
+    phoc_render_scheduler_defer (priv->render_scheduler, start_us);
+    return;
+  }
+
+  priv->commit_deadline_us = 0;
+  phoc_output_frame (self, frame_time);
+}
+
+
 static void
 phoc_output_handle_needs_frame (struct wl_listener *listener, void *user_data)
 {
@@ -753,13 +1369,27 @@ phoc_output_handle_commit (struct wl_listener *listener, void *data)
     wlr_output_schedule_frame (self->wlr_output);
   }
 
+  if (event->state->committed & (WLR_OUTPUT_STATE_ENABLED |
+                                 WLR_OUTPUT_STATE_MODE |
+                                 WLR_OUTPUT_STATE_SCALE |
+                                 WLR_OUTPUT_STATE_TRANSFORM)) {
+    /* The backend might decide differently on planes now */
+    priv->n_tested_planes = 0;
+  }
+
+  if (event->state->committed & WLR_OUTPUT_STATE_ENABLED) {
+    /* Render times and presentation timings recorded before don't apply anymore */
+    phoc_render_scheduler_reset (priv->render_scheduler);
+    phoc_frame_clock_reset (priv->frame_clock);
+  }
+
   if (event->state->committed & WLR_OUTPUT_STATE_ENABLED && self->wlr_output->enabled) {
     priv->gamma_lut_changed = TRUE;
     wlr_output_schedule_frame (self->wlr_output);
   }
 
   if (event->state->committed & WLR_OUTPUT_STATE_SCALE)
-    phoc_output_for_each_surface (self, update_output_scale_iterator, NULL, FALSE);
+    phoc_output_for_each_surface (self, update_output_scale_iterator, NULL);
 }
 
 
@@ -986,6 +1616,28 @@ phoc_output_set_layout_pos (PhocOutput *self, PhocOutputConfig *output_config)
 }
 
 
+/*
+ * Find the lowest bit not yet used by any of the desktop's outputs so
+ * views can track on which outputs they're visible.
+ */
+static guint32
+find_free_mask (PhocDesktop *desktop)
+{
+  PhocOutput *output;
+  guint32 used = 0;
+
+  wl_list_for_each (output, &desktop->outputs, link)
+    used |= phoc_output_get_mask (output);
+
+  if (used == G_MAXUINT32) {
+    g_warning ("Too many outputs, can't track view visibility on new output");
+    return 0;
+  }
+
+  return 1u << g_bit_nth_lsf (~used, -1);
+}
+
+
 static gboolean
 phoc_output_initable_init (GInitable    *initable,
                            GCancellable *cancellable,
@@ -1003,6 +1655,7 @@ phoc_output_initable_init (GInitable    *initable,
   int width, height;
 
   self->wlr_output->data = self;
+  priv->mask = find_free_mask (self->desktop);
   wl_list_insert (&self->desktop->outputs, &self->link);
 
   if (!wlr_output_init_render (self->wlr_output,
@@ -1031,6 +1684,9 @@ phoc_output_initable_init (GInitable    *initable,
   priv->needs_frame.notify = phoc_output_handle_needs_frame;
   wl_signal_add (&self->wlr_output->events.needs_frame, &priv->needs_frame);
 
+  priv->present.notify = phoc_output_handle_present;
+  wl_signal_add (&self->wlr_output->events.present, &priv->present);
+
   priv->request_state.notify = handle_request_state;
   wl_signal_add (&self->wlr_output->events.request_state, &priv->request_state);
 
@@ -1112,6 +1768,21 @@ phoc_output_finalize (GObject *object)
   /* Remove all frame callbacks, this will also free associated user data */
   g_clear_slist (&priv->frame_callbacks,
                  (GDestroyNotify)phoc_output_frame_callback_info_free);
+  g_clear_pointer (&priv->frame_done_surfaces, g_hash_table_destroy);
+  g_clear_object (&priv->layer_index);
+  g_clear_object (&priv->frame_stats);
+  g_clear_object (&priv->frame_clock);
+  g_clear_object (&priv->render_scheduler);
+  g_clear_pointer (&priv->plane_surfaces, g_ptr_array_unref);
+  g_clear_pointer (&priv->plane_candidates, g_ptr_array_unref);
+  for (guint i = 0; i < priv->scanout_feedback_surfaces->len; i++) {
+    PhocSurface *surface = g_ptr_array_index (priv->scanout_feedback_surfaces, i);
+    struct wlr_surface *wlr_surface = phoc_surface_get_wlr_surface (surface);
+
+    if (wlr_surface && !is_scanout_feedback_claimed (self, surface))
+      phoc_server_set_linux_dmabuf_surface_feedback (phoc_server_get_default (), wlr_surface, NULL);
+  }
+  g_clear_pointer (&priv->scanout_feedback_surfaces, g_ptr_array_unref);
 
   wl_list_init (&self->layer_surfaces);
   for (int i = 0; i < G_N_ELEMENTS (priv->layer_surfaces); i++)
@@ -1541,7 +2212,6 @@ phoc_output_drag_icons_for_each_surface (PhocOutput          *self,
 
 struct for_each_surface_data {
   PhocOutput          *output;
-  gboolean             visible_only;
   PhocSurfaceIterator  iterator;
   gpointer             user_data;
 };
@@ -1551,8 +2221,7 @@ for_each_surface_iter (PhocDesktop *desktop, PhocView *view, gpointer user_data)
 {
   struct for_each_surface_data *data = user_data;
 
-  if (!data->visible_only || phoc_desktop_view_check_visibility (desktop, view))
-    phoc_output_view_for_each_surface (data->output, view, data->iterator, data->user_data);
+  phoc_output_view_for_each_surface (data->output, view, data->iterator, data->user_data);
 
   return TRUE;
 }
@@ -1562,15 +2231,13 @@ for_each_surface_iter (PhocDesktop *desktop, PhocView *view, gpointer user_data)
  * @self: the output
  * @iterator: (scope call): The iterator
  * @user_data: Callback user data
- * @visible_only: Whether to only iterate over visible surfaces
  *
  * Iterate over surfaces on the output.
  */
 static void
 phoc_output_for_each_surface (PhocOutput          *self,
                               PhocSurfaceIterator  iterator,
-                              void                *user_data,
-                              gboolean             visible_only)
+                              void                *user_data)
 {
   PhocInput *input = phoc_server_get_input (phoc_server_get_default ());
   PhocDesktop *desktop = self->desktop;
@@ -1594,7 +2261,6 @@ phoc_output_for_each_surface (PhocOutput          *self,
                                   .output = self,
                                   .iterator = iterator,
                                   .user_data = user_data,
-                                  .visible_only = visible_only,
                                 });
   }
 
@@ -1623,7 +2289,7 @@ phoc_view_accept_damage (PhocOutput *self, PhocView  *view)
 {
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
 
-  if (!phoc_desktop_view_check_visibility (desktop, view))
+  if (!phoc_desktop_view_is_visible_on_output (desktop, view, self))
     return false;
 
   if (self->fullscreen_view == NULL)
@@ -1681,6 +2347,25 @@ damage_surface_iterator (PhocOutput *self, struct wlr_surface *wlr_surface, stru
 }
 
 
+/*
+ * Saved buffers are shown instead of the surface so its damage isn't
+ * used. The saved element damages what's needed when it's dropped.
+ */
+static void
+saved_surface_iterator (PhocOutput         *self,
+                        struct wlr_surface *wlr_surface,
+                        struct wlr_box     *box,
+                        float               scale,
+                        void               *data)
+{
+  PhocSurface *surface = wlr_surface->data;
+
+  phoc_surface_clear_damage (surface);
+  if (!wl_list_empty (&wlr_surface->current.frame_callback_list))
+    wlr_output_schedule_frame (self->wlr_output);
+}
+
+
 static void
 damage_view_blings (PhocOutput *self, PhocView  *view)
 {
@@ -1719,10 +2404,17 @@ damage_view_blings (PhocOutput *self, PhocView  *view)
 void
 phoc_output_damage_from_view (PhocOutput *self, PhocView *view, bool whole)
 {
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
   if (!phoc_view_accept_damage (self, view)) {
     return;
   }
 
+  if (phoc_renderer_is_element_saved (priv->renderer, view)) {
+    phoc_output_view_for_each_surface (self, view, saved_surface_iterator, NULL);
+    return;
+  }
+
   if (whole)
     damage_view_blings (self, view);
 
@@ -1744,6 +2436,13 @@ phoc_output_damage_from_layer_surface (PhocOutput       *self,
                                        PhocLayerSurface *layer_surface,
                                        gboolean          whole)
 {
+  PhocOutputPrivate *priv = phoc_output_get_instance_private (self);
+
+  if (phoc_renderer_is_element_saved (priv->renderer, layer_surface)) {
+    phoc_output_layer_surface_for_each_surface (self, layer_surface, saved_surface_iterator, NULL);
+    return;
+  }
+
   phoc_output_layer_surface_for_each_surface (self, layer_surface, damage_surface_iterator, &whole);
 }
 
@@ -2118,7 +2817,6 @@ phoc_output_add_frame_callback  (PhocOutput        *self,
   };
 
   if (priv->frame_callbacks == NULL) {
-    priv->last_frame_us = g_get_monotonic_time ();
     /* No other frame callbacks so need to schedule a frame to keep
      * frame clock ticking */
     wlr_output_schedule_frame (self->wlr_output);
@@ -2522,3 +3220,146 @@ phoc_output_get_debug_damage (PhocOutput *self)
 
   return priv->debug_damage;
 }
+
+/**
+ * phoc_output_get_mask:
+ * @self: The output
+ *
+ * Get the output's bit in a view's visible outputs mask. See
+ * [method@View.get_visible_outputs].
+ *
+ * Returns: The output's mask or `0` if there are too many outputs to
+ *   track visibility for this output.
+ */
+guint32
+phoc_output_get_mask (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  return priv->mask;
+}
+
+/**
+ * phoc_output_add_frame_done_surface:
+ * @self: The output
+ * @surface: The surface with pending frame callbacks
+ *
+ * Adds the surface to the output's index of surfaces waiting for
+ * frame done. The index is processed after the output was drawn and
+ * surfaces get sent frame done events once they're visible on the
+ * output.
+ */
+void
+phoc_output_add_frame_done_surface (PhocOutput *self, PhocSurface *surface)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  g_assert (PHOC_IS_SURFACE (surface));
+  priv = phoc_output_get_instance_private (self);
+
+  g_hash_table_add (priv->frame_done_surfaces, g_object_ref (surface));
+}
+
+/**
+ * phoc_output_get_frame_done_surfaces:
+ * @self: The output
+ *
+ * Get the surfaces waiting for frame done on this output. This
+ * includes surfaces that currently aren't visible.
+ *
+ * Returns: (transfer container)(element-type PhocSurface): The surfaces
+ */
+GList *
+phoc_output_get_frame_done_surfaces (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  return g_hash_table_get_keys (priv->frame_done_surfaces);
+}
+
+/**
+ * phoc_output_update_layer_surface_bounds:
+ * @self: The output
+ * @layer_surface: The layer surface on this output
+ *
+ * Updates the layer surface's input bounds in the output's index used
+ * for hit testing. This needs to be invoked whenever the layer
+ * surface or one of its popups or subsurfaces changes position or size.
+ */
+void
+phoc_output_update_layer_surface_bounds (PhocOutput *self, PhocLayerSurface *layer_surface)
+{
+  PhocOutputPrivate *priv;
+  struct wlr_box bounds;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  phoc_layer_surface_get_input_bounds (layer_surface, &bounds);
+  phoc_spatial_index_update (priv->layer_index, layer_surface, &bounds);
+}
+
+/**
+ * phoc_output_remove_layer_surface_bounds:
+ * @self: The output
+ * @layer_surface: The layer surface to remove
+ *
+ * Removes the layer surface from the output's index used for hit testing.
+ */
+void
+phoc_output_remove_layer_surface_bounds (PhocOutput *self, PhocLayerSurface *layer_surface)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  phoc_spatial_index_remove (priv->layer_index, layer_surface);
+}
+
+/**
+ * phoc_output_query_layer_surfaces:
+ * @self: The output
+ * @ox: x coordinate in output local coordinates
+ * @oy: y coordinate in output local coordinates
+ * @results: (element-type PhocLayerSurface): Array the found layer surfaces are appended to
+ *
+ * Looks up the layer surfaces that might accept input at the given
+ * position. The result isn't ordered by layer or stacking.
+ */
+void
+phoc_output_query_layer_surfaces (PhocOutput *self, double ox, double oy, GPtrArray *results)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  phoc_spatial_index_query (priv->layer_index, ox, oy, results);
+}
+
+/**
+ * phoc_output_get_frame_stats:
+ * @self: The output
+ *
+ * Gets the output's frame timing statistics.
+ *
+ * Returns:(transfer none): The frame stats
+ */
+PhocFrameStats *
+phoc_output_get_frame_stats (PhocOutput *self)
+{
+  PhocOutputPrivate *priv;
+
+  g_assert (PHOC_IS_OUTPUT (self));
+  priv = phoc_output_get_instance_private (self);
+
+  return priv->frame_stats;
+}
@@ -2,8 +2,10 @@
 
 #include "animatable.h"
 #include "drag-icon.h"
+#include "frame-stats.h"
 #include "phoc-animation.h"
 #include "render.h"
+#include "surface.h"
 #include "view.h"
 
 #include <gio/gio.h>
@@ -187,6 +189,19 @@ const char *phoc_output_get_identifier       (PhocOutput *self);
 void       phoc_output_transform_damage      (PhocOutput *self, pixman_region32_t *damage);
 void       phoc_output_transform_box         (PhocOutput *self, struct wlr_box *box);
 GSList    *phoc_output_get_debug_damage      (PhocOutput *self);
+guint32    phoc_output_get_mask              (PhocOutput *self);
+void       phoc_output_add_frame_done_surface (PhocOutput  *self,
+                                               PhocSurface *surface);
+GList     *phoc_output_get_frame_done_surfaces (PhocOutput *self);
+void       phoc_output_update_layer_surface_bounds (PhocOutput       *self,
+                                                    PhocLayerSurface *layer_surface);
+void       phoc_output_remove_layer_surface_bounds (PhocOutput       *self,
+                                                    PhocLayerSurface *layer_surface);
+void       phoc_output_query_layer_surfaces  (PhocOutput *self,
+                                              double      ox,
+                                              double      oy,
+                                              GPtrArray  *results);
+PhocFrameStats *phoc_output_get_frame_stats  (PhocOutput *self);
 
 enum wlr_scale_filter_mode
            phoc_output_get_texture_filter_mode (PhocOutput *self);
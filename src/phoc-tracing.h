@@ -15,6 +15,14 @@
 
 # include <sys/sdt.h>
 
+# define PHOC_DTRACE_PROBE(...)  DTRACE_PROBE (__VA_ARGS__)
+# define PHOC_DTRACE_PROBE1(...) DTRACE_PROBE1 (__VA_ARGS__)
+# define PHOC_DTRACE_PROBE2(...) DTRACE_PROBE2 (__VA_ARGS__)
+# define PHOC_DTRACE_PROBE3(...) DTRACE_PROBE3 (__VA_ARGS__)
+# define PHOC_DTRACE_PROBE4(...) DTRACE_PROBE4 (__VA_ARGS__)
+# define PHOC_DTRACE_PROBE5(...) DTRACE_PROBE5 (__VA_ARGS__)
+# define PHOC_DTRACE_PROBE6(...) DTRACE_PROBE6 (__VA_ARGS__)
+
 /**
  * PHOC_TRACE_NO_INLINE:
  *
@@ -16,12 +16,14 @@
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/config.h>
+#include <wlr/render/allocator.h>
 #include <wlr/render/wlr_texture.h>
 #include <phosh-private-protocol.h>
 #include <wlr-screencopy-unstable-v1-protocol.h>
 #include "server.h"
 #include "desktop.h"
 #include "render.h"
+#include "render-private.h"
 #include "utils.h"
 
 #include <drm_fourcc.h>
@@ -46,6 +48,8 @@ struct _PhocPhoshPrivate {
   struct wl_resource* resource;
   struct wl_global *global;
   GList *keyboard_events;
+  /* combo key -> PhocPhoshPrivateKeyboardEventData */
+  GHashTable *accelerators;
   guint last_action_id;
   GList *startup_trackers;
   PhocPhoshPrivateShellState state;
@@ -68,6 +72,9 @@ typedef struct {
   uint32_t stride;
 
   struct wlr_buffer *buffer;
+  gboolean with_damage;
+  gboolean waiting_for_damage;
+  guint render_id;
 
   PhocView *view;
 } PhocPhoshPrivateScreencopyFrame;
@@ -132,12 +139,17 @@ static void
 phoc_phosh_private_keyboard_event_destroy (PhocPhoshPrivateKeyboardEventData *kbevent)
 {
   PhocPhoshPrivate *phosh;
+  GHashTableIter iter;
+  gpointer key;
 
   if (kbevent == NULL)
     return;
 
   g_debug ("Destroying private_keyboard_event %p (res %p)", kbevent, kbevent->resource);
   phosh = kbevent->phosh;
+  g_hash_table_iter_init (&iter, kbevent->subscribed_accelerators);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    g_hash_table_remove (phosh->accelerators, key);
   g_hash_table_remove_all (kbevent->subscribed_accelerators);
   g_hash_table_unref (kbevent->subscribed_accelerators);
   wl_resource_set_user_data (kbevent->resource, NULL);
@@ -153,31 +165,14 @@ phoc_phosh_private_keyboard_event_handle_resource_destroy (struct wl_resource *r
   phoc_phosh_private_keyboard_event_destroy (kbevent);
 }
 
-static bool
-phoc_phosh_private_keyboard_event_accelerator_is_registered (PhocKeyCombo                      *combo,
-                                                             PhocPhoshPrivateKeyboardEventData *kbevent)
-{
-  gint64 key = ((gint64) combo->modifiers << 32) | combo->keysym;
-  gpointer ret = g_hash_table_lookup (kbevent->subscribed_accelerators, &key);
-  g_debug ("Accelerator is registered: Lookup -> %p", ret);
-  return (ret != NULL);
-}
-
 static bool
 phoc_phosh_private_accelerator_already_subscribed (PhocKeyCombo *combo)
 {
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
   PhocPhoshPrivate *phosh = phoc_desktop_get_phosh_private (desktop);
-  GList *l;
-  PhocPhoshPrivateKeyboardEventData *kbevent;
+  gint64 key = phoc_key_combo_get_key (combo);
 
-  for (l = phosh->keyboard_events; l != NULL; l = l->next) {
-    kbevent = (PhocPhoshPrivateKeyboardEventData *)l->data;
-    if (phoc_phosh_private_keyboard_event_accelerator_is_registered (combo, kbevent))
-      return true;
-  }
-
-  return false;
+  return g_hash_table_contains (phosh->accelerators, &key);
 }
 
 
@@ -266,11 +261,14 @@ phoc_phosh_private_keyboard_event_grab_accelerator_request (struct wl_client   *
   }
 
   new_key = (gint64 *) g_malloc (sizeof (gint64));
-  *new_key = ((gint64) combo->modifiers << 32) | combo->keysym;
+  *new_key = phoc_key_combo_get_key (combo);
 
   /* subscribed accelerators of kbevent */
   g_hash_table_insert (kbevent->subscribed_accelerators,
                        new_key, GUINT_TO_POINTER (new_action_id));
+  /* accelerators of all clients for dispatch */
+  g_hash_table_insert (kbevent->phosh->accelerators,
+                       g_memdup2 (new_key, sizeof (gint64)), kbevent);
 
   phosh_private_keyboard_event_send_grab_success_event (resource,
                                                         accelerator,
@@ -301,7 +299,8 @@ phoc_phosh_private_keyboard_event_ungrab_accelerator_request (struct wl_client *
   }
 
   if (found) {
-    g_hash_table_remove (kbevent->subscribed_accelerators, key);
+    g_hash_table_remove (kbevent->phosh->accelerators, found);
+    g_hash_table_remove (kbevent->subscribed_accelerators, found);
     phosh_private_keyboard_event_send_ungrab_success_event (resource,
                                                             action_id);
 
@@ -378,9 +377,15 @@ phosh_private_screencopy_frame_handle_resource_destroy (struct wl_resource *reso
   PhocPhoshPrivateScreencopyFrame *frame = phoc_phosh_private_screencopy_frame_from_resource (resource);
 
   g_debug ("Destroying private_screencopy_frame %p (res %p)", frame, frame->resource);
+  g_clear_handle_id (&frame->render_id, g_source_remove);
   if (frame->view)
     g_signal_handlers_disconnect_by_data (frame->view, frame);
 
+  if (frame->waiting_for_damage) {
+    phoc_view_release_content_damage (frame->view);
+    wlr_buffer_unlock (frame->buffer);
+  }
+
   free (frame);
 }
 
@@ -391,19 +396,120 @@ on_surface_destroy (PhocView *view, PhocPhoshPrivateScreencopyFrame *frame)
   g_assert (PHOC_IS_VIEW (view));
 
   g_signal_handlers_disconnect_by_data (frame->view, frame);
+
+  if (frame->waiting_for_damage) {
+    g_clear_handle_id (&frame->render_id, g_source_remove);
+    phoc_view_release_content_damage (frame->view);
+    frame->waiting_for_damage = FALSE;
+    zwlr_screencopy_frame_v1_send_failed (frame->resource);
+    wlr_buffer_unlock (frame->buffer);
+  }
   frame->view = NULL;
 }
 
 
 static void
-thumbnail_frame_handle_copy (struct wl_client   *wl_client,
-                             struct wl_resource *frame_resource,
-                             struct wl_resource *buffer_resource)
+thumbnail_frame_send_damage (PhocPhoshPrivateScreencopyFrame *frame, pixman_region32_t *damage)
+{
+  const pixman_box32_t *rects;
+  int n_rects;
+
+  if (wl_resource_get_version (frame->resource) < ZWLR_SCREENCOPY_FRAME_V1_DAMAGE_SINCE_VERSION)
+    return;
+
+  rects = pixman_region32_rectangles (damage, &n_rects);
+  for (int i = 0; i < n_rects; i++) {
+    zwlr_screencopy_frame_v1_send_damage (frame->resource,
+                                          rects[i].x1,
+                                          rects[i].y1,
+                                          rects[i].x2 - rects[i].x1,
+                                          rects[i].y2 - rects[i].y1);
+  }
+}
+
+
+static void
+thumbnail_frame_render (PhocPhoshPrivateScreencopyFrame *frame)
+{
+  PhocServer *server = phoc_server_get_default ();
+  PhocRenderer *renderer = phoc_server_get_renderer (server);
+  PhocView *view = frame->view;
+  pixman_region32_t damage;
+
+  g_signal_handlers_disconnect_by_data (frame->view, frame);
+  frame->view = NULL;
+  if (frame->waiting_for_damage) {
+    phoc_view_release_content_damage (view);
+    frame->waiting_for_damage = FALSE;
+  }
+
+  pixman_region32_init (&damage);
+  if (!phoc_renderer_render_view_to_buffer (renderer, view, frame->buffer, &damage)) {
+    zwlr_screencopy_frame_v1_send_failed (frame->resource);
+    goto out;
+  }
+
+  zwlr_screencopy_frame_v1_send_flags (frame->resource, 0);
+
+  if (frame->with_damage)
+    thumbnail_frame_send_damage (frame, &damage);
+
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  uint32_t tv_sec_hi = (sizeof(now.tv_sec) > 4) ? now.tv_sec >> 32 : 0;
+  uint32_t tv_sec_lo = now.tv_sec & 0xFFFFFFFF;
+  zwlr_screencopy_frame_v1_send_ready (frame->resource, tv_sec_hi, tv_sec_lo, now.tv_nsec);
+
+out:
+  pixman_region32_fini (&damage);
+  wlr_buffer_unlock (frame->buffer);
+}
+
+
+static void
+on_render_idle (gpointer data)
+{
+  PhocPhoshPrivateScreencopyFrame *frame = data;
+
+  frame->render_id = 0;
+  thumbnail_frame_render (frame);
+}
+
+
+static void
+on_content_damaged (PhocView *view, PhocPhoshPrivateScreencopyFrame *frame)
+{
+  g_assert (PHOC_IS_VIEW (view));
+
+  /* Render once for all the commits that happen until we're idle */
+  if (frame->render_id)
+    return;
+
+  frame->render_id = g_idle_add_once (on_render_idle, frame);
+  g_source_set_name_by_id (frame->render_id, "[phoc] thumbnail render");
+}
+
+
+static gboolean
+thumbnail_supports_dmabuf (PhocRenderer *renderer)
+{
+  struct wlr_allocator *allocator = phoc_renderer_get_wlr_allocator (renderer);
+
+  /* E.g. the pixman renderer can only handle SHM buffers */
+  return !!(allocator->buffer_caps & WLR_BUFFER_CAP_DMABUF);
+}
+
+
+static void
+thumbnail_frame_copy (struct wl_resource *frame_resource,
+                      struct wl_resource *buffer_resource,
+                      gboolean            with_damage)
 {
   PhocServer *server = phoc_server_get_default ();
-  PhocRenderer *self = phoc_server_get_renderer (server);
+  PhocRenderer *renderer = phoc_server_get_renderer (server);
   PhocPhoshPrivateScreencopyFrame *frame;
   struct wlr_shm_attributes attribs;
+  struct wlr_dmabuf_attributes dmabuf;
 
   frame = phoc_phosh_private_screencopy_frame_from_resource (frame_resource);
   g_return_if_fail (frame);
@@ -428,51 +534,64 @@ thumbnail_frame_handle_copy (struct wl_client   *wl_client,
     return;
   }
 
-  if (!wlr_buffer_get_shm (frame->buffer, &attribs)) {
+  if (wlr_buffer_get_shm (frame->buffer, &attribs)) {
+    if (attribs.format != DRM_FORMAT_ARGB8888 || attribs.width != frame->width ||
+        attribs.height != frame->height || attribs.stride != frame->stride) {
+      wl_resource_post_error (frame->resource,
+                              ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
+                              "invalid buffer attributes");
+      goto unlock_buffer;
+    }
+  } else if (thumbnail_supports_dmabuf (renderer) &&
+             wlr_buffer_get_dmabuf (frame->buffer, &dmabuf)) {
+    if (dmabuf.format != DRM_FORMAT_ARGB8888 || dmabuf.width != frame->width ||
+        dmabuf.height != frame->height) {
+      wl_resource_post_error (frame->resource,
+                              ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
+                              "invalid buffer attributes");
+      goto unlock_buffer;
+    }
+  } else {
     wl_resource_post_error (frame->resource,
                             ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
                             "unsupported buffer type");
     goto unlock_buffer;
   }
 
-  if (attribs.format != DRM_FORMAT_ARGB8888 || attribs.width != frame->width ||
-      attribs.height != frame->height || attribs.stride != frame->stride) {
-    wl_resource_post_error (frame->resource,
-                            ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
-                            "invalid buffer attributes");
-    goto unlock_buffer;
-  }
-
-  PhocView *view = frame->view;
-  g_signal_handlers_disconnect_by_data (frame->view, frame);
-  frame->view = NULL;
+  frame->with_damage = with_damage;
 
-  if (!phoc_renderer_render_view_to_buffer (self, view, frame->buffer)) {
-    zwlr_screencopy_frame_v1_send_failed (frame->resource);
-    goto unlock_buffer;
+  /* Nothing changed since the last thumbnail, wait for damage */
+  if (with_damage &&
+      phoc_renderer_is_view_thumbnail_current (renderer, frame->view, frame->width, frame->height)) {
+    g_signal_connect (frame->view, "content-damaged", G_CALLBACK (on_content_damaged), frame);
+    phoc_view_hold_content_damage (frame->view);
+    frame->waiting_for_damage = TRUE;
+    return;
   }
 
-  zwlr_screencopy_frame_v1_send_flags (frame->resource, 0);
-
-  struct timespec now;
-  clock_gettime (CLOCK_MONOTONIC, &now);
-  uint32_t tv_sec_hi = (sizeof(now.tv_sec) > 4) ? now.tv_sec >> 32 : 0;
-  uint32_t tv_sec_lo = now.tv_sec & 0xFFFFFFFF;
-  zwlr_screencopy_frame_v1_send_ready (frame->resource, tv_sec_hi, tv_sec_lo, now.tv_nsec);
+  thumbnail_frame_render (frame);
+  return;
 
 unlock_buffer:
   wlr_buffer_unlock (frame->buffer);
 }
 
+
+static void
+thumbnail_frame_handle_copy (struct wl_client   *wl_client,
+                             struct wl_resource *frame_resource,
+                             struct wl_resource *buffer_resource)
+{
+  thumbnail_frame_copy (frame_resource, buffer_resource, FALSE);
+}
+
+
 static void
 thumbnail_frame_handle_copy_with_damage (struct wl_client   *wl_client,
                                          struct wl_resource *frame_resource,
                                          struct wl_resource *buffer_resource)
 {
-  // XXX: unimplemented
-  (void)wl_client;
-  (void)buffer_resource;
-  zwlr_screencopy_frame_v1_send_failed (frame_resource);
+  thumbnail_frame_copy (frame_resource, buffer_resource, TRUE);
 }
 
 static void
@@ -562,6 +681,17 @@ handle_get_thumbnail (struct wl_client *client,
 
   zwlr_screencopy_frame_v1_send_buffer (frame->resource, frame->format,
                                         frame->width, frame->height, frame->stride);
+
+  if (version < ZWLR_SCREENCOPY_FRAME_V1_LINUX_DMABUF_SINCE_VERSION)
+    return;
+
+  PhocRenderer *renderer = phoc_server_get_renderer (phoc_server_get_default ());
+  if (thumbnail_supports_dmabuf (renderer)) {
+    zwlr_screencopy_frame_v1_send_linux_dmabuf (frame->resource, DRM_FORMAT_ARGB8888,
+                                                frame->width, frame->height);
+  }
+
+  zwlr_screencopy_frame_v1_send_buffer_done (frame->resource);
 }
 
 
@@ -760,6 +890,7 @@ phoc_phosh_private_finalize (GObject *object)
   PhocPhoshPrivate *self = PHOC_PHOSH_PRIVATE (object);
 
   wl_global_destroy (self->global);
+  g_clear_pointer (&self->accelerators, g_hash_table_destroy);
 
   G_OBJECT_CLASS (phoc_phosh_private_parent_class)->finalize (object);
 }
@@ -795,6 +926,7 @@ static void
 phoc_phosh_private_init (PhocPhoshPrivate *self)
 {
   self->last_action_id = 1;
+  self->accelerators = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
 }
 
 
@@ -812,34 +944,33 @@ phoc_phosh_private_forward_keysym (PhocKeyCombo *combo,
 {
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
   PhocPhoshPrivate *phosh = phoc_desktop_get_phosh_private (desktop);
-  GList *l;
-  bool forwarded = false;
-
-  for (l = phosh->keyboard_events; l != NULL; l = l->next) {
-    PhocPhoshPrivateKeyboardEventData *kbevent = l->data;
-    uint32_t version = wl_resource_get_version (kbevent->resource);
-
-    g_debug("addr of kbevent and res kbev %p res %p", kbevent, kbevent->resource);
-    /*  forward the keysym if it is has been subscribed to */
-    if (phoc_phosh_private_keyboard_event_accelerator_is_registered (combo, kbevent)) {
-      gint64 key = ((gint64)combo->modifiers << 32) | combo->keysym;
-      guint action_id = GPOINTER_TO_UINT (g_hash_table_lookup (kbevent->subscribed_accelerators, &key));
-
-      if (pressed) {
-        phosh_private_keyboard_event_send_accelerator_activated_event (kbevent->resource,
-                                                                       action_id,
-                                                                       timestamp);
-        forwarded = true;
-      } else if (version >= PHOSH_PRIVATE_KEYBOARD_EVENT_ACCELERATOR_RELEASED_EVENT_SINCE_VERSION) {
-        phosh_private_keyboard_event_send_accelerator_released_event (kbevent->resource,
-                                                                      action_id,
-                                                                      timestamp);
-        forwarded = true;
-      }
-    }
+  PhocPhoshPrivateKeyboardEventData *kbevent;
+  gint64 key = phoc_key_combo_get_key (combo);
+  uint32_t version;
+  guint action_id;
+
+  /* An accelerator can only be subscribed by a single client */
+  kbevent = g_hash_table_lookup (phosh->accelerators, &key);
+  if (kbevent == NULL)
+    return false;
+
+  g_debug ("Forwarding keysym to kbevent %p res %p", kbevent, kbevent->resource);
+  version = wl_resource_get_version (kbevent->resource);
+  action_id = GPOINTER_TO_UINT (g_hash_table_lookup (kbevent->subscribed_accelerators, &key));
+
+  if (pressed) {
+    phosh_private_keyboard_event_send_accelerator_activated_event (kbevent->resource,
+                                                                   action_id,
+                                                                   timestamp);
+    return true;
+  } else if (version >= PHOSH_PRIVATE_KEYBOARD_EVENT_ACCELERATOR_RELEASED_EVENT_SINCE_VERSION) {
+    phosh_private_keyboard_event_send_accelerator_released_event (kbevent->resource,
+                                                                  action_id,
+                                                                  timestamp);
+    return true;
   }
 
-  return forwarded;
+  return false;
 }
 
 void
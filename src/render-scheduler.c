@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-render-scheduler"
+
+#include "phoc-config.h"
+
+#include "render-scheduler.h"
+
+/* Number of most recent render times the estimate is based on */
+#define PHOC_RENDER_SCHEDULER_N_SAMPLES 16
+/* Samples needed before the estimate is considered reliable */
+#define PHOC_RENDER_SCHEDULER_MIN_SAMPLES 8
+/* Safety margin between finishing rendering and the vblank */
+#define PHOC_RENDER_SCHEDULER_MARGIN_US 1500
+/* Don't bother deferring for less than this */
+#define PHOC_RENDER_SCHEDULER_MIN_DEFER_US 1000
+
+/**
+ * PhocRenderScheduler:
+ *
+ * Decides when to render an output's frame.
+ *
+ * Rendering right when the backend signals that a new frame can be
+ * submitted means that client commits arriving shortly afterwards
+ * miss the frame although it's only presented at the next
+ * vblank. The scheduler keeps the composition times of the recent
+ * frames and defers rendering to the latest point in time that still
+ * meets the vblank deadline so the frame picks up as many client
+ * updates as possible.
+ *
+ * As long as there aren't enough samples or the composition time
+ * doesn't leave room to defer rendering, frames are rendered
+ * immediately. A missed deadline drops the samples so the scheduler
+ * only resumes deferring once it has a fresh estimate.
+ *
+ * All timestamps are in µs using the same clock as
+ * `g_get_monotonic_time()`.
+ */
+
+enum {
+  RENDER,
+  N_SIGNALS
+};
+static guint signals[N_SIGNALS];
+
+struct _PhocRenderScheduler {
+  GObject  parent;
+
+  gint64   samples[PHOC_RENDER_SCHEDULER_N_SAMPLES];
+  guint    head;
+  guint    len;
+
+  GSource *deadline_source;
+};
+G_DEFINE_TYPE (PhocRenderScheduler, phoc_render_scheduler, G_TYPE_OBJECT)
+
+
+static gboolean
+deadline_source_dispatch (GSource *source, GSourceFunc callback, gpointer user_data)
+{
+  /* One shot until deferred again */
+  g_source_set_ready_time (source, -1);
+
+  return callback (user_data);
+}
+
+static GSourceFuncs deadline_source_funcs = {
+  .dispatch = deadline_source_dispatch,
+};
+
+
+static gboolean
+on_deadline (gpointer data)
+{
+  PhocRenderScheduler *self = PHOC_RENDER_SCHEDULER (data);
+
+  g_signal_emit (self, signals[RENDER], 0);
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+static void
+phoc_render_scheduler_finalize (GObject *object)
+{
+  PhocRenderScheduler *self = PHOC_RENDER_SCHEDULER (object);
+
+  g_source_destroy (self->deadline_source);
+  g_clear_pointer (&self->deadline_source, g_source_unref);
+
+  G_OBJECT_CLASS (phoc_render_scheduler_parent_class)->finalize (object);
+}
+
+
+static void
+phoc_render_scheduler_class_init (PhocRenderSchedulerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phoc_render_scheduler_finalize;
+
+  /**
+   * PhocRenderScheduler::render:
+   * @self: The render scheduler
+   *
+   * Emitted when it's time to render the deferred frame.
+   */
+  signals[RENDER] = g_signal_new ("render",
+                                  G_TYPE_FROM_CLASS (klass),
+                                  G_SIGNAL_RUN_LAST,
+                                  0,
+                                  NULL, NULL, NULL,
+                                  G_TYPE_NONE, 0);
+}
+
+
+static void
+phoc_render_scheduler_init (PhocRenderScheduler *self)
+{
+  self->deadline_source = g_source_new (&deadline_source_funcs, sizeof (GSource));
+  g_source_set_name (self->deadline_source, "[phoc] render deadline");
+  /* Render before handling any further client requests */
+  g_source_set_priority (self->deadline_source, G_PRIORITY_HIGH);
+  g_source_set_callback (self->deadline_source, on_deadline, self, NULL);
+  g_source_attach (self->deadline_source, NULL);
+}
+
+
+PhocRenderScheduler *
+phoc_render_scheduler_new (void)
+{
+  return g_object_new (PHOC_TYPE_RENDER_SCHEDULER, NULL);
+}
+
+/**
+ * phoc_render_scheduler_add_render_time:
+ * @self: The render scheduler
+ * @render_us: How long it took to compose and commit a frame
+ *
+ * Records the composition time of a frame.
+ */
+void
+phoc_render_scheduler_add_render_time (PhocRenderScheduler *self, gint64 render_us)
+{
+  g_assert (PHOC_IS_RENDER_SCHEDULER (self));
+
+  self->samples[self->head] = MAX (render_us, 0);
+  self->head = (self->head + 1) % PHOC_RENDER_SCHEDULER_N_SAMPLES;
+  self->len = MIN (self->len + 1, PHOC_RENDER_SCHEDULER_N_SAMPLES);
+}
+
+/**
+ * phoc_render_scheduler_add_missed:
+ * @self: The render scheduler
+ *
+ * Records that a deferred frame missed its vblank. This drops the
+ * estimate so frames are rendered immediately until enough new
+ * samples got recorded.
+ */
+void
+phoc_render_scheduler_add_missed (PhocRenderScheduler *self)
+{
+  g_assert (PHOC_IS_RENDER_SCHEDULER (self));
+
+  g_debug ("Missed render deadline, rendering immediately");
+  self->head = 0;
+  self->len = 0;
+}
+
+/**
+ * phoc_render_scheduler_get_estimate:
+ * @self: The render scheduler
+ *
+ * Gets the expected composition time. To cope with jitter this is
+ * the longest of the recent composition times.
+ *
+ * Returns: The expected composition time in µs or `0` if there
+ *   aren't enough samples for a reliable estimate
+ */
+gint64
+phoc_render_scheduler_get_estimate (PhocRenderScheduler *self)
+{
+  gint64 estimate = 0;
+
+  g_assert (PHOC_IS_RENDER_SCHEDULER (self));
+
+  if (self->len < PHOC_RENDER_SCHEDULER_MIN_SAMPLES)
+    return 0;
+
+  for (guint i = 0; i < self->len; i++)
+    estimate = MAX (estimate, self->samples[i]);
+
+  return MAX (estimate, 1);
+}
+
+/**
+ * phoc_render_scheduler_get_start_time:
+ * @self: The render scheduler
+ * @now_us: The current time
+ * @frame_time_us: The vblank the frame should be presented at
+ * @refresh_us: The refresh interval
+ * @start_us: (out): When to start rendering
+ *
+ * Calculates the latest time rendering can start and still meet the
+ * vblank at @frame_time_us.
+ *
+ * Returns: %TRUE if rendering should be deferred to @start_us, %FALSE
+ *   if the frame should be rendered immediately
+ */
+gboolean
+phoc_render_scheduler_get_start_time (PhocRenderScheduler *self,
+                                      gint64               now_us,
+                                      gint64               frame_time_us,
+                                      gint64               refresh_us,
+                                      gint64              *start_us)
+{
+  gint64 estimate, budget, start;
+
+  g_assert (PHOC_IS_RENDER_SCHEDULER (self));
+  g_assert (start_us);
+
+  estimate = phoc_render_scheduler_get_estimate (self);
+  if (estimate == 0 || refresh_us <= 0)
+    return FALSE;
+
+  /* Composition takes most of the refresh cycle anyway */
+  budget = estimate + PHOC_RENDER_SCHEDULER_MARGIN_US;
+  if (budget > refresh_us * 3 / 4)
+    return FALSE;
+
+  start = frame_time_us - budget;
+  if (start - now_us < PHOC_RENDER_SCHEDULER_MIN_DEFER_US)
+    return FALSE;
+
+  /* Don't trust predictions too far in the future */
+  if (frame_time_us - now_us > 2 * refresh_us)
+    return FALSE;
+
+  *start_us = start;
+  return TRUE;
+}
+
+/**
+ * phoc_render_scheduler_defer:
+ * @self: The render scheduler
+ * @start_us: When to render
+ *
+ * Emits [signal@RenderScheduler::render] at @start_us.
+ */
+void
+phoc_render_scheduler_defer (PhocRenderScheduler *self, gint64 start_us)
+{
+  g_assert (PHOC_IS_RENDER_SCHEDULER (self));
+
+  g_source_set_ready_time (self->deadline_source, MAX (start_us, 0));
+}
+
+/**
+ * phoc_render_scheduler_is_deferred:
+ * @self: The render scheduler
+ *
+ * Returns: %TRUE if a frame is waiting to be rendered
+ */
+gboolean
+phoc_render_scheduler_is_deferred (PhocRenderScheduler *self)
+{
+  g_assert (PHOC_IS_RENDER_SCHEDULER (self));
+
+  return g_source_get_ready_time (self->deadline_source) != -1;
+}
+
+/**
+ * phoc_render_scheduler_reset:
+ * @self: The render scheduler
+ *
+ * Cancels a deferred frame and drops the recorded composition times,
+ * e.g. when the output got disabled.
+ */
+void
+phoc_render_scheduler_reset (PhocRenderScheduler *self)
+{
+  g_assert (PHOC_IS_RENDER_SCHEDULER (self));
+
+  g_source_set_ready_time (self->deadline_source, -1);
+  self->head = 0;
+  self->len = 0;
+}
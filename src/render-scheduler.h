@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PHOC_TYPE_RENDER_SCHEDULER (phoc_render_scheduler_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocRenderScheduler, phoc_render_scheduler, PHOC, RENDER_SCHEDULER, GObject)
+
+PhocRenderScheduler *phoc_render_scheduler_new              (void);
+void                 phoc_render_scheduler_add_render_time  (PhocRenderScheduler *self,
+                                                             gint64               render_us);
+void                 phoc_render_scheduler_add_missed       (PhocRenderScheduler *self);
+gint64               phoc_render_scheduler_get_estimate     (PhocRenderScheduler *self);
+gboolean             phoc_render_scheduler_get_start_time   (PhocRenderScheduler *self,
+                                                             gint64               now_us,
+                                                             gint64               frame_time_us,
+                                                             gint64               refresh_us,
+                                                             gint64              *start_us);
+void                 phoc_render_scheduler_defer            (PhocRenderScheduler *self,
+                                                             gint64               start_us);
+gboolean             phoc_render_scheduler_is_deferred      (PhocRenderScheduler *self);
+void                 phoc_render_scheduler_reset            (PhocRenderScheduler *self);
+
+G_END_DECLS
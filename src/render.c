@@ -18,6 +18,7 @@
 #include "cursor.h"
 #include "input.h"
 #include "layer-shell.h"
+#include "layer-surface.h"
 #include "seat.h"
 #include "server.h"
 #include "render.h"
@@ -31,6 +32,7 @@
 #include <fcntl.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <wlr/backend.h>
 #include <wlr/config.h>
@@ -42,6 +44,7 @@
 #include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_linux_dmabuf_v1.h>
+#include <wlr/types/wlr_output_layer.h>
 #include <wlr/util/region.h>
 #include <wlr/util/transform.h>
 #include <wlr/render/allocator.h>
@@ -76,6 +79,22 @@ struct _PhocRenderer {
   struct wlr_backend   *wlr_backend;
   struct wlr_renderer  *wlr_renderer;
   struct wlr_allocator *wlr_allocator;
+
+  GArray               *render_elements; /* RenderElement */
+  /* The output the render elements were collected for */
+  PhocOutput           *elements_output;
+
+  /* Thumbnails */
+  struct wlr_drm_format_set thumbnail_formats;
+  GHashTable           *thumbnails; /* PhocView -> PhocThumbnail */
+  GQueue                thumbnail_pool; /* struct wlr_buffer */
+  guint                 thumbnail_expire_id;
+
+  /* Scaled down copies of surfaces of views that are scaled to fit */
+  GHashTable           *prescaled_surfaces; /* PhocSurface -> PhocPrescaledSurface */
+
+  /* Elements that are part of a layout transaction */
+  GHashTable           *saved_elements; /* PhocView or PhocLayerSurface -> PhocSavedElement */
 };
 
 static void phoc_renderer_initable_iface_init (GInitableIface *iface);
@@ -89,9 +108,117 @@ struct render_view_data {
   int width;
   int height;
   struct wlr_render_pass *render_pass;
+  const pixman_region32_t *clip;
+};
+
+/* Max number of unused render targets kept around for thumbnails */
+#define PHOC_THUMBNAIL_POOL_SIZE 4
+/* Drop thumbnails that weren't requested for that long */
+#define PHOC_THUMBNAIL_EXPIRE_S 5
+
+/*
+ * The last thumbnail delivered for a view. As long as the view's
+ * contents don't change it can be served again without rendering.
+ */
+typedef struct {
+  PhocRenderer      *renderer;
+  PhocView          *view;
+
+  gboolean           valid;
+  guint              commit_seq;
+  gint64             last_used_us;
+  float              alpha;
+  struct wlr_box     geo;
+  int                width;
+  int                height;
+
+  struct wlr_buffer *buffer; /* The render target for SHM thumbnails */
+  guint8            *pixels; /* ARGB8888, stride is width * 4, NULL if not cached */
+} PhocThumbnail;
+
+
+/* Drop prescaled surfaces that weren't shown for that long */
+#define PHOC_PRESCALED_EXPIRE_US (5 * G_USEC_PER_SEC)
+
+/*
+ * A surface's contents scaled down to the size it's shown at so it
+ * doesn't need to be resampled on every frame.
+ */
+typedef struct {
+  PhocSurface        *surface;
+  guint               commit_seq;
+  struct wlr_buffer  *buffer;
+  struct wlr_texture *texture;
+  gint64              last_used_us;
+} PhocPrescaledSurface;
+
+
+typedef enum {
+  RENDER_ELEMENT_VIEW,
+  RENDER_ELEMENT_XWAYLAND_CHILDREN,
+  RENDER_ELEMENT_LAYER_SURFACE,
+  RENDER_ELEMENT_DRAG_ICONS,
+} RenderElementType;
+
+/*
+ * Something we draw in one go. Elements are collected in back to front
+ * order so they can be culled front to back before drawing.
+ */
+typedef struct _PhocSavedElement PhocSavedElement;
+
+typedef struct {
+  RenderElementType  type;
+  gpointer           data;
+  gboolean           culled;
+  /* Saved buffers shown instead of the element's current ones */
+  PhocSavedElement  *saved;
+  /* The part of the damage not occluded by elements above */
+  pixman_region32_t  damage;
+} RenderElement;
+
+
+typedef struct {
+  float              alpha;
+  pixman_region32_t *opaque;
+  pixman_region32_t *bounds;
+} OcclusionData;
+
+typedef struct {
+  guint               n_surfaces;
+  struct wlr_surface *surface;
+  struct wlr_box      dst_box;
+} PlaneCandidate;
+
+
+/* A surface's buffer as it was when its element got saved */
+typedef struct {
+  struct wlr_buffer        *buffer;
+  struct wlr_texture       *texture; /* Owned by the buffer */
+  struct wlr_fbox           src_box;
+  struct wlr_box            box; /* Layout coordinates */
+  enum wl_output_transform  transform;
+  float                     alpha; /* From the alpha modifier */
+} PhocSavedSurface;
+
+/*
+ * The buffers of a view or layer surface as they were before a layout
+ * change. They're shown instead of the element's current buffers
+ * until the layout transaction is done.
+ */
+struct _PhocSavedElement {
+  GArray         *surfaces; /* PhocSavedSurface, back to front */
+  struct wlr_box  bounds; /* Layout coordinates */
 };
 
 
+typedef struct {
+  PhocSavedElement  *saved;
+  pixman_region32_t  bounds;
+  double             lx, ly;
+  float              scale;
+} SaveElementData;
+
+
 static void
 phoc_renderer_set_property (GObject      *object,
                             guint         property_id,
@@ -167,6 +294,214 @@ render_texture (PhocOutput               *output,
 }
 
 
+static void
+phoc_prescaled_surface_free (PhocPrescaledSurface *prescaled)
+{
+  g_clear_pointer (&prescaled->texture, wlr_texture_destroy);
+  g_clear_pointer (&prescaled->buffer, wlr_buffer_drop);
+  g_object_unref (prescaled->surface);
+  g_free (prescaled);
+}
+
+/*
+ * Get the prescaled copy of a surface if it's current and matches the
+ * size the surface is shown at.
+ */
+static PhocPrescaledSurface *
+get_prescaled_surface (PhocRenderer *self, struct wlr_surface *wlr_surface, struct wlr_box *box)
+{
+  PhocPrescaledSurface *prescaled;
+  PhocSurface *surface = wlr_surface->data;
+
+  if (!surface || g_hash_table_size (self->prescaled_surfaces) == 0)
+    return NULL;
+
+  prescaled = g_hash_table_lookup (self->prescaled_surfaces, surface);
+  if (!prescaled || !prescaled->texture)
+    return NULL;
+
+  if (prescaled->commit_seq != phoc_surface_get_commit_seq (surface) ||
+      prescaled->buffer->width != box->width ||
+      prescaled->buffer->height != box->height) {
+    return NULL;
+  }
+
+  return prescaled;
+}
+
+
+static gboolean
+prescaled_surface_update (PhocRenderer         *self,
+                          PhocPrescaledSurface *prescaled,
+                          struct wlr_surface   *wlr_surface,
+                          int                   width,
+                          int                   height)
+{
+  struct wlr_texture *texture = wlr_surface_get_texture (wlr_surface);
+  struct wlr_render_pass *render_pass;
+  struct wlr_fbox src_box;
+
+  if (!prescaled->buffer ||
+      prescaled->buffer->width != width ||
+      prescaled->buffer->height != height) {
+    const struct wlr_drm_format *fmt;
+
+    g_clear_pointer (&prescaled->texture, wlr_texture_destroy);
+    g_clear_pointer (&prescaled->buffer, wlr_buffer_drop);
+
+    fmt = wlr_drm_format_set_get (&self->thumbnail_formats, DRM_FORMAT_ARGB8888);
+    prescaled->buffer = wlr_allocator_create_buffer (self->wlr_allocator, width, height, fmt);
+    if (!prescaled->buffer)
+      return FALSE;
+  }
+
+  /* Recreated after rendering so it picks up the new contents */
+  g_clear_pointer (&prescaled->texture, wlr_texture_destroy);
+
+  render_pass = wlr_renderer_begin_buffer_pass (self->wlr_renderer, prescaled->buffer, NULL);
+  if (!render_pass)
+    return FALSE;
+
+  wlr_surface_get_buffer_source_box (wlr_surface, &src_box);
+  wlr_render_pass_add_rect (render_pass, &(struct wlr_render_rect_options){
+      .color = { 0, 0, 0, 0 },
+      .blend_mode = WLR_RENDER_BLEND_MODE_NONE,
+    });
+  wlr_render_pass_add_texture (render_pass, &(struct wlr_render_texture_options) {
+      .texture = texture,
+      .src_box = src_box,
+      .dst_box = { .width = width, .height = height },
+      .transform = wlr_surface->current.transform,
+      .filter_mode = WLR_SCALE_FILTER_BILINEAR,
+    });
+
+  if (!wlr_render_pass_submit (render_pass))
+    return FALSE;
+
+  prescaled->texture = wlr_texture_from_buffer (self->wlr_renderer, prescaled->buffer);
+  return !!prescaled->texture;
+}
+
+
+typedef struct {
+  PhocRenderer *renderer;
+  gint64        now_us;
+} PrescaleData;
+
+
+static void
+prescale_surface_iterator (PhocOutput         *output,
+                           struct wlr_surface *wlr_surface,
+                           struct wlr_box     *box,
+                           float               scale,
+                           void               *user_data)
+{
+  PrescaleData *data = user_data;
+  PhocRenderer *self = data->renderer;
+  PhocSurface *surface = wlr_surface->data;
+  PhocPrescaledSurface *prescaled;
+  struct wlr_box dst_box = *box;
+  struct wlr_fbox src_box;
+
+  if (!surface || !wlr_surface_get_texture (wlr_surface))
+    return;
+
+  phoc_utils_scale_box (&dst_box, scale);
+  phoc_utils_scale_box (&dst_box, output->wlr_output->scale);
+  if (dst_box.width <= 0 || dst_box.height <= 0)
+    return;
+
+  /* The client renders at the size it's shown at already */
+  wlr_surface_get_buffer_source_box (wlr_surface, &src_box);
+  if (src_box.width * src_box.height <= (dst_box.width + 1) * (dst_box.height + 1)) {
+    g_hash_table_remove (self->prescaled_surfaces, surface);
+    return;
+  }
+
+  prescaled = g_hash_table_lookup (self->prescaled_surfaces, surface);
+  if (!prescaled) {
+    prescaled = g_new0 (PhocPrescaledSurface, 1);
+    prescaled->surface = g_object_ref (surface);
+    g_hash_table_insert (self->prescaled_surfaces, surface, prescaled);
+  }
+  prescaled->last_used_us = data->now_us;
+
+  if (get_prescaled_surface (self, wlr_surface, &dst_box))
+    return;
+
+  if (!prescaled_surface_update (self, prescaled, wlr_surface, dst_box.width, dst_box.height)) {
+    g_warning_once ("Failed to prescale surface %p", wlr_surface);
+    g_hash_table_remove (self->prescaled_surfaces, surface);
+    return;
+  }
+
+  prescaled->commit_seq = phoc_surface_get_commit_seq (surface);
+}
+
+/**
+ * phoc_renderer_prepare_output:
+ * @self: The renderer
+ * @output: The output that is about to be rendered
+ *
+ * Collects what needs to be drawn on the output in this frame so
+ * [method@Renderer.assign_planes] and [method@Renderer.render_output]
+ * can use it, hence it must be invoked before them.
+ *
+ * Also brings the prescaled copies of the surfaces of views that are
+ * scaled to fit the output up to date. This renders to offscreen
+ * buffers, hence it must be invoked before the output's render pass
+ * begins. Surfaces only get scaled down again when they got
+ * committed, otherwise the copy is reused.
+ */
+void
+phoc_renderer_prepare_output (PhocRenderer *self, PhocOutput *output)
+{
+  PhocConfig *config = phoc_server_get_config (phoc_server_get_default ());
+  PhocDesktop *desktop = PHOC_DESKTOP (output->desktop);
+  PrescaleData data = { .renderer = self, .now_us = g_get_monotonic_time () };
+  GHashTableIter iter;
+  PhocPrescaledSurface *prescaled;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  /* Start over in case the last frame didn't get rendered */
+  clear_render_elements (self);
+  collect_render_elements (self, output);
+
+  if (!config->scale_to_fit_prescale) {
+    g_hash_table_remove_all (self->prescaled_surfaces);
+    return;
+  }
+
+  if (output->fullscreen_view)
+    return;
+
+  for (GList *l = phoc_desktop_get_views (desktop)->head; l; l = l->next) {
+    PhocView *view = PHOC_VIEW (l->data);
+
+    if (phoc_view_get_scale (view) >= 1.0)
+      continue;
+
+    /* Saved buffers are drawn as is */
+    if (g_hash_table_contains (self->saved_elements, view))
+      continue;
+
+    if (!phoc_desktop_view_is_visible_on_output (desktop, view, output))
+      continue;
+
+    phoc_output_view_for_each_surface (output, view, prescale_surface_iterator, &data);
+  }
+
+  g_hash_table_iter_init (&iter, self->prescaled_surfaces);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&prescaled)) {
+    if (phoc_surface_get_wlr_surface (prescaled->surface) == NULL ||
+        data.now_us - prescaled->last_used_us > PHOC_PRESCALED_EXPIRE_US) {
+      g_hash_table_iter_remove (&iter);
+    }
+  }
+}
+
+
 static void
 render_surface_iterator (PhocOutput         *output,
                          struct wlr_surface *surface,
@@ -183,14 +518,31 @@ render_surface_iterator (PhocOutput         *output,
   if (!texture)
     return;
 
+  /* Displayed on an overlay plane */
+  if (ctx->plane_surfaces && g_ptr_array_find (ctx->plane_surfaces, surface, NULL))
+    return;
+
   struct wlr_fbox src_box;
   wlr_surface_get_buffer_source_box (surface, &src_box);
+  enum wl_output_transform transform = surface->current.transform;
 
   struct wlr_box dst_box = *box;
   struct wlr_box clip_box = *box;
 
   phoc_utils_scale_box (&dst_box, scale);
   phoc_utils_scale_box (&dst_box, wlr_output->scale);
+
+  if (scale < 1.0) {
+    PhocRenderer *renderer = phoc_server_get_renderer (phoc_server_get_default ());
+    PhocPrescaledSurface *prescaled = get_prescaled_surface (renderer, surface, &dst_box);
+
+    if (prescaled) {
+      texture = prescaled->texture;
+      src_box = (struct wlr_fbox) { 0, 0, texture->width, texture->height };
+      transform = WL_OUTPUT_TRANSFORM_NORMAL;
+    }
+  }
+
   phoc_output_transform_box (output, &dst_box);
 
   phoc_utils_scale_box (&clip_box, scale);
@@ -206,7 +558,7 @@ render_surface_iterator (PhocOutput         *output,
                   &src_box,
                   &dst_box,
                   &clip_box,
-                  surface->current.transform,
+                  transform,
                   alpha,
                   ctx);
 
@@ -237,10 +589,6 @@ render_blings (PhocOutput *output, PhocView *view, PhocRenderContext *ctx)
 static void
 render_view (PhocOutput *output, PhocView *view, PhocRenderContext *ctx)
 {
-  /*  Do not render views fullscreened on other outputs */
-  if (phoc_view_is_fullscreen (view) && phoc_view_get_fullscreen_output (view) != output)
-    return;
-
   ctx->alpha = phoc_view_get_alpha (view);
 
   if (!phoc_view_is_fullscreen (view))
@@ -250,23 +598,6 @@ render_view (PhocOutput *output, PhocView *view, PhocRenderContext *ctx)
 }
 
 
-static void
-render_layer (enum zwlr_layer_shell_v1_layer layer, PhocRenderContext *ctx)
-{
-  GQueue *layer_surfaces = phoc_output_get_layer_surfaces_for_layer (ctx->output, layer);
-
-  for (GList *l = layer_surfaces->head; l; l = l->next) {
-    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (l->data);
-
-    ctx->alpha = phoc_layer_surface_get_alpha (layer_surface);
-    phoc_output_layer_surface_for_each_surface (ctx->output,
-                                                layer_surface,
-                                                render_surface_iterator,
-                                                ctx);
-  }
-}
-
-
 static void
 render_drag_icons (PhocInput *input, PhocRenderContext *ctx)
 {
@@ -301,145 +632,1097 @@ render_touch_points (PhocRenderContext *ctx)
 
 
 static void
-view_render_to_buffer_iterator (struct wlr_surface *surface, int sx, int sy, void *_data)
+add_render_element (PhocRenderer *self, RenderElementType type, gpointer data)
 {
-  struct wlr_texture *texture;
-  struct render_view_data *data = _data;
-  struct wlr_box geo;
-  struct wlr_fbox src_box;
-  float alpha = phoc_view_get_alpha (data->view);
+  RenderElement elem = { .type = type, .data = data };
 
-  if (!wlr_surface_has_buffer (surface))
-    return;
+  if (type == RENDER_ELEMENT_VIEW || type == RENDER_ELEMENT_LAYER_SURFACE)
+    elem.saved = g_hash_table_lookup (self->saved_elements, data);
 
-  texture = wlr_surface_get_texture (surface);
-  phoc_view_get_geometry (data->view, &geo);
-  wlr_surface_get_buffer_source_box (surface, &src_box);
+  pixman_region32_init (&elem.damage);
+  g_array_append_val (self->render_elements, elem);
+}
 
-  struct wlr_box dst_box = {
-    .x = -geo.x + sx,
-    .y = -geo.y + sy,
-    .width = surface->current.width,
-    .height = surface->current.height,
-  };
 
-  float scale = fmin (data->width / (float)geo.width,
-                      data->height / (float)geo.height);
-  phoc_utils_scale_box (&dst_box, scale);
+static void
+add_render_layer (PhocRenderer *self, PhocOutput *output, enum zwlr_layer_shell_v1_layer layer)
+{
+  GQueue *layer_surfaces = phoc_output_get_layer_surfaces_for_layer (output, layer);
 
-  wlr_render_pass_add_texture (data->render_pass, &(struct wlr_render_texture_options) {
-      .texture = texture,
-      .src_box = src_box,
-      .dst_box = dst_box,
-      .transform = surface->current.transform,
-      .alpha = &alpha,
-    });
+  for (GList *l = layer_surfaces->head; l; l = l->next)
+    add_render_element (self, RENDER_ELEMENT_LAYER_SURFACE, l->data);
 }
 
-
-gboolean
-phoc_renderer_render_view_to_buffer (PhocRenderer      *self,
-                                     PhocView          *view,
-                                     struct wlr_buffer *shm_buffer)
+/*
+ * Collect everything that needs to be drawn in back to front order.
+ */
+static void
+collect_render_elements (PhocRenderer *self, PhocOutput *output)
 {
-  struct wlr_surface *surface = view->wlr_surface;
-  struct wlr_buffer *buffer;
-  void *data;
-  uint32_t format;
-  size_t stride;
-  int32_t width, height;
-  struct wlr_render_pass *render_pass;
-  const struct wlr_drm_format *fmt;
-  struct wlr_drm_format_set fmt_set = {};
-  bool success;
+  PhocDesktop *desktop = PHOC_DESKTOP (output->desktop);
 
-  g_return_val_if_fail (surface, false);
-  g_return_val_if_fail (self->wlr_allocator, false);
-  g_return_val_if_fail (shm_buffer, false);
+  /* If a view is fullscreen on this output, render it */
+  if (output->fullscreen_view != NULL) {
+    PhocView *view = output->fullscreen_view;
 
-  width = shm_buffer->width;
-  height = shm_buffer->height;
-  wlr_drm_format_set_add (&fmt_set, DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR);
-  fmt = wlr_drm_format_set_get (&fmt_set, DRM_FORMAT_ARGB8888);
+    add_render_element (self, RENDER_ELEMENT_VIEW, view);
 
-  buffer = wlr_allocator_create_buffer (self->wlr_allocator, width, height, fmt);
-  if (!buffer) {
-    wlr_drm_format_set_finish (&fmt_set);
-    g_warning ("Failed to allocate buffer");
-    return false;
-  }
+    /* During normal rendering the xwayland window tree isn't traversed
+     * because all windows are rendered. Here we only want to render
+     * the fullscreen window's children so we have to traverse the tree. */
+    if (PHOC_IS_XWAYLAND_SURFACE (view))
+      add_render_element (self, RENDER_ELEMENT_XWAYLAND_CHILDREN, view);
 
-  render_pass = wlr_renderer_begin_buffer_pass (self->wlr_renderer, buffer, NULL);
-  if (!render_pass) {
-    wlr_drm_format_set_finish (&fmt_set);
-    g_warning ("Failed to start render pass");
-    return false;
-  }
+    /* Render top layer above fullscreen view when requested */
+    if (phoc_output_has_shell_revealed (output))
+      add_render_layer (self, output, ZWLR_LAYER_SHELL_V1_LAYER_TOP);
+  } else {
+    /* Render background and bottom layers under views */
+    add_render_layer (self, output, ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND);
+    add_render_layer (self, output, ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM);
 
-  wlr_render_pass_add_rect (render_pass, &(struct wlr_render_rect_options){
-      .color = { 0, 0, 0, 0 },
-      .blend_mode = WLR_RENDER_BLEND_MODE_NONE,
-    });
+    /* Render all views */
+    for (GList *l = phoc_desktop_get_views (desktop)->tail; l; l = l->prev) {
+      PhocView *view = PHOC_VIEW (l->data);
 
-  struct render_view_data render_data = {
-    .view = view,
-    .width = width,
-    .height = height,
-    .render_pass = render_pass,
-  };
-  wlr_surface_for_each_surface (surface, view_render_to_buffer_iterator, &render_data);
-  wlr_render_pass_submit (render_pass);
+      if (!phoc_desktop_view_is_visible_on_output (desktop, view, output))
+        continue;
 
-  if (!wlr_buffer_begin_data_ptr_access (shm_buffer,
-                                         WLR_BUFFER_DATA_PTR_ACCESS_WRITE,
-                                         &data, &format, &stride)) {
-    return false;
+      add_render_element (self, RENDER_ELEMENT_VIEW, view);
+    }
+
+    /* Render top layer above views */
+    add_render_layer (self, output, ZWLR_LAYER_SHELL_V1_LAYER_TOP);
   }
 
-  struct wlr_texture *texture = wlr_texture_from_buffer (self->wlr_renderer, buffer);
-  success = wlr_texture_read_pixels (texture, &(struct wlr_texture_read_pixels_options) {
-      .data = data,
-      .format = format,
-      .stride = stride,
-      .src_box = (struct wlr_box) { .x = 0, .y = 0, .width = width, .height = height },
-    });
-  wlr_texture_destroy (texture);
+  add_render_element (self, RENDER_ELEMENT_DRAG_ICONS, NULL);
+  add_render_layer (self, output, ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY);
+  self->elements_output = output;
+}
 
-  wlr_buffer_drop (buffer);
-  wlr_drm_format_set_finish (&fmt_set);
 
-  wlr_buffer_end_data_ptr_access (shm_buffer);
+static void
+clear_render_elements (PhocRenderer *self)
+{
+  for (guint i = 0; i < self->render_elements->len; i++) {
+    RenderElement *elem = &g_array_index (self->render_elements, RenderElement, i);
 
-  return success;
-}
+    pixman_region32_fini (&elem->damage);
+  }
 
-#define DEBUG_DAMAGE_TIMEOUT_US (250.0 * 1000.0)
-#define DEBUG_DAMAGE_MAX_OPACITY 0.8
+  g_array_set_size (self->render_elements, 0);
+  self->elements_output = NULL;
+}
 
+/*
+ * The elements are collected once per frame when preparing the output
+ * and then used for plane assignment and rendering.
+ */
 static void
-render_damage (PhocRenderer *self, PhocRenderContext *ctx)
+ensure_render_elements (PhocRenderer *self, PhocOutput *output)
 {
-  gint64 now = g_get_monotonic_time ();
+  if (self->elements_output == output)
+    return;
 
-  for (GSList *l = phoc_output_get_debug_damage (ctx->output); l; l = l->next) {
-    PhocDebugDamageRegion *damage = l->data;
-    float elapsed = fmax (1.0 - (now - damage->when) / DEBUG_DAMAGE_TIMEOUT_US, 0.0);
-    float alpha = DEBUG_DAMAGE_MAX_OPACITY * elapsed;
-    struct pixman_region32 clip;
+  clear_render_elements (self);
+  collect_render_elements (self, output);
+}
 
-    pixman_region32_init (&clip);
-    pixman_region32_copy (&clip, &damage->region);
 
-    /* Using an empty box makes us clip the damage from the whole output buffer */
-    wlr_render_pass_add_rect (ctx->render_pass, &(struct wlr_render_rect_options){
-        .color = COLOR_MAGENTA_ALPHA (alpha),
-        .clip = &clip,
-      });
+static float
+render_element_get_alpha (RenderElement *elem)
+{
+  switch (elem->type) {
+  case RENDER_ELEMENT_VIEW:
+  case RENDER_ELEMENT_XWAYLAND_CHILDREN:
+    return phoc_view_get_alpha (PHOC_VIEW (elem->data));
+  case RENDER_ELEMENT_LAYER_SURFACE:
+    return phoc_layer_surface_get_alpha (PHOC_LAYER_SURFACE (elem->data));
+  case RENDER_ELEMENT_DRAG_ICONS:
+    return 1.0;
+  default:
+    g_assert_not_reached ();
+  }
+}
 
-    if (G_APPROX_VALUE (elapsed, 0.0, FLT_EPSILON))
-      damage->done = 1;
 
-    pixman_region32_fini (&clip);
+static void
+render_element_for_each_surface (PhocOutput          *output,
+                                 RenderElement       *elem,
+                                 PhocSurfaceIterator  iterator,
+                                 gpointer             user_data)
+{
+  switch (elem->type) {
+  case RENDER_ELEMENT_VIEW:
+    phoc_output_view_for_each_surface (output, PHOC_VIEW (elem->data), iterator, user_data);
+    break;
+  case RENDER_ELEMENT_XWAYLAND_CHILDREN:
+#ifdef PHOC_XWAYLAND
+    phoc_output_xwayland_children_for_each_surface (
+      output,
+      phoc_xwayland_surface_get_wlr_surface (PHOC_XWAYLAND_SURFACE (elem->data)),
+      iterator,
+      user_data);
+#endif
+    break;
+  case RENDER_ELEMENT_LAYER_SURFACE:
+    phoc_output_layer_surface_for_each_surface (output,
+                                                PHOC_LAYER_SURFACE (elem->data),
+                                                iterator,
+                                                user_data);
+    break;
+  case RENDER_ELEMENT_DRAG_ICONS:
+    phoc_output_drag_icons_for_each_surface (output,
+                                             phoc_server_get_input (phoc_server_get_default ()),
+                                             iterator,
+                                             user_data);
+    break;
+  default:
+    g_assert_not_reached ();
+  }
+}
+
+
+static gboolean
+render_element_has_blings (RenderElement *elem)
+{
+  if (elem->type != RENDER_ELEMENT_VIEW || phoc_view_is_fullscreen (elem->data))
+    return FALSE;
+
+  return !!phoc_view_get_blings (PHOC_VIEW (elem->data));
+}
+
+
+static void
+occlusion_surface_iterator (PhocOutput         *output,
+                            struct wlr_surface *surface,
+                            struct wlr_box     *box,
+                            float               scale,
+                            void               *user_data)
+{
+  OcclusionData *data = user_data;
+  struct wlr_output *wlr_output = output->wlr_output;
+  const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+  struct wlr_box dst_box = *box;
+  float alpha = data->alpha;
+  pixman_region32_t opaque;
+
+  if (!wlr_surface_get_texture (surface))
+    return;
+
+  phoc_utils_scale_box (&dst_box, scale);
+  phoc_utils_scale_box (&dst_box, wlr_output->scale);
+
+  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+  if (alpha_modifier_state)
+    alpha *= (float)alpha_modifier_state->multiplier;
+
+  pixman_region32_init (&opaque);
+  if (G_APPROX_VALUE (alpha, 1.0, FLT_EPSILON)) {
+    if (surface->buffer && wlr_buffer_is_opaque (&surface->buffer->base)) {
+      pixman_region32_union_rect (&opaque, &opaque,
+                                  dst_box.x, dst_box.y, dst_box.width, dst_box.height);
+    } else {
+      phoc_utils_scale_opaque_region (&opaque, &surface->opaque_region, box->x, box->y,
+                                      scale * wlr_output->scale);
+      pixman_region32_intersect_rect (&opaque, &opaque,
+                                      dst_box.x, dst_box.y, dst_box.width, dst_box.height);
+    }
+    phoc_output_transform_damage (output, &opaque);
+    pixman_region32_union (data->opaque, data->opaque, &opaque);
+  }
+  pixman_region32_fini (&opaque);
+
+  phoc_output_transform_box (output, &dst_box);
+  pixman_region32_union_rect (data->bounds, data->bounds,
+                              dst_box.x, dst_box.y, dst_box.width, dst_box.height);
+}
+
+/*
+ * Walk the elements front to back and shrink each element's damage
+ * by the opaque regions of the elements above it. Elements that end
+ * up without any damage are culled. Returns the number of culled
+ * elements, `occluded` is filled with the area covered by opaque
+ * surfaces.
+ */
+static guint
+cull_render_elements (PhocRenderer      *self,
+                      PhocOutput        *output,
+                      pixman_region32_t *damage,
+                      pixman_region32_t *occluded)
+{
+  guint n_culled = 0;
+  pixman_region32_t bounds;
+
+  pixman_region32_init (&bounds);
+
+  for (int i = self->render_elements->len - 1; i >= 0; i--) {
+    RenderElement *elem = &g_array_index (self->render_elements, RenderElement, i);
+    pixman_region32_t opaque;
+    OcclusionData data = {
+      .alpha = render_element_get_alpha (elem),
+      .opaque = &opaque,
+      .bounds = &bounds,
+    };
+
+    pixman_region32_subtract (&elem->damage, damage, occluded);
+    if (!pixman_region32_not_empty (&elem->damage)) {
+      elem->culled = TRUE;
+      n_culled++;
+      continue;
+    }
+
+    /* The current surfaces' regions don't match the saved buffers */
+    if (elem->saved)
+      continue;
+
+    pixman_region32_init (&opaque);
+    pixman_region32_clear (&bounds);
+    render_element_for_each_surface (output, elem, occlusion_surface_iterator, &data);
+
+    /* Blings can extend beyond the view's surfaces so we can't cull by bounds */
+    if (!render_element_has_blings (elem))
+      pixman_region32_intersect (&elem->damage, &elem->damage, &bounds);
+
+    if (!pixman_region32_not_empty (&elem->damage)) {
+      elem->culled = TRUE;
+      n_culled++;
+    }
+
+    pixman_region32_union (occluded, occluded, &opaque);
+    pixman_region32_fini (&opaque);
+  }
+
+  pixman_region32_fini (&bounds);
+
+  return n_culled;
+}
+
+
+static void
+plane_candidate_surface_iterator (PhocOutput         *output,
+                                  struct wlr_surface *surface,
+                                  struct wlr_box     *box,
+                                  float               scale,
+                                  void               *user_data)
+{
+  PlaneCandidate *candidate = user_data;
+  struct wlr_output *wlr_output = output->wlr_output;
+
+  candidate->n_surfaces++;
+  if (candidate->n_surfaces > 1)
+    return;
+
+  candidate->surface = surface;
+  candidate->dst_box = *box;
+  phoc_utils_scale_box (&candidate->dst_box, scale);
+  phoc_utils_scale_box (&candidate->dst_box, wlr_output->scale);
+  phoc_output_transform_box (output, &candidate->dst_box);
+}
+
+/*
+ * Check whether the element can be put on an overlay plane as is.
+ * This is the case for elements consisting of a single surface that
+ * doesn't need any blending or transformation by the renderer.
+ */
+static gboolean
+get_plane_candidate (PhocOutput *output, RenderElement *elem, PlaneCandidate *candidate)
+{
+  const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+  struct wlr_surface *surface;
+
+  if (elem->type != RENDER_ELEMENT_VIEW && elem->type != RENDER_ELEMENT_LAYER_SURFACE)
+    return FALSE;
+
+  if (elem->saved)
+    return FALSE;
+
+  if (!G_APPROX_VALUE (render_element_get_alpha (elem), 1.0, FLT_EPSILON))
+    return FALSE;
+
+  if (render_element_has_blings (elem))
+    return FALSE;
+
+  render_element_for_each_surface (output, elem, plane_candidate_surface_iterator, candidate);
+  if (candidate->n_surfaces != 1)
+    return FALSE;
+
+  surface = candidate->surface;
+  if (surface->buffer == NULL || wlr_box_empty (&candidate->dst_box))
+    return FALSE;
+
+  /* Output layers can't rotate or flip buffers */
+  if (surface->current.transform != output->wlr_output->transform)
+    return FALSE;
+
+  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+  if (alpha_modifier_state && !G_APPROX_VALUE (alpha_modifier_state->multiplier, 1.0, FLT_EPSILON))
+    return FALSE;
+
+  return TRUE;
+}
+
+
+static void
+save_surface_iterator (struct wlr_surface *surface, int sx, int sy, void *user_data)
+{
+  SaveElementData *data = user_data;
+  const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+  PhocSavedSurface saved = {
+    .box = {
+      .x = round (data->lx + sx * data->scale),
+      .y = round (data->ly + sy * data->scale),
+      .width = round (surface->current.width * data->scale),
+      .height = round (surface->current.height * data->scale),
+    },
+    .transform = surface->current.transform,
+    .alpha = 1.0,
+  };
+
+  if (!surface->buffer || !surface->buffer->texture)
+    return;
+
+  saved.buffer = wlr_buffer_lock (&surface->buffer->base);
+  saved.texture = surface->buffer->texture;
+  wlr_surface_get_buffer_source_box (surface, &saved.src_box);
+
+  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+  if (alpha_modifier_state)
+    saved.alpha = (float)alpha_modifier_state->multiplier;
+
+  g_array_append_val (data->saved->surfaces, saved);
+
+  pixman_region32_union_rect (&data->bounds, &data->bounds,
+                              saved.box.x, saved.box.y, saved.box.width, saved.box.height);
+}
+
+
+static void
+saved_surface_clear (PhocSavedSurface *saved)
+{
+  g_clear_pointer (&saved->buffer, wlr_buffer_unlock);
+}
+
+
+static void
+phoc_saved_element_free (PhocSavedElement *saved)
+{
+  g_array_unref (saved->surfaces);
+  g_free (saved);
+}
+
+
+static void
+render_saved_element (PhocOutput *output, PhocSavedElement *saved, PhocRenderContext *ctx)
+{
+  struct wlr_output *wlr_output = output->wlr_output;
+
+  for (guint i = 0; i < saved->surfaces->len; i++) {
+    PhocSavedSurface *surface = &g_array_index (saved->surfaces, PhocSavedSurface, i);
+    struct wlr_box dst_box = surface->box;
+
+    dst_box.x -= output->lx;
+    dst_box.y -= output->ly;
+    phoc_utils_scale_box (&dst_box, wlr_output->scale);
+    phoc_output_transform_box (output, &dst_box);
+
+    render_texture (output,
+                    surface->texture,
+                    &surface->src_box,
+                    &dst_box,
+                    &dst_box,
+                    surface->transform,
+                    ctx->alpha * surface->alpha,
+                    ctx);
+  }
+}
+
+
+static void
+render_element (PhocOutput *output, RenderElement *elem, PhocRenderContext *ctx)
+{
+  if (G_UNLIKELY (elem->saved)) {
+    ctx->alpha = render_element_get_alpha (elem);
+    if (render_element_has_blings (elem))
+      render_blings (output, PHOC_VIEW (elem->data), ctx);
+    render_saved_element (output, elem->saved, ctx);
+    return;
+  }
+
+  switch (elem->type) {
+  case RENDER_ELEMENT_VIEW:
+    render_view (output, PHOC_VIEW (elem->data), ctx);
+    break;
+  case RENDER_ELEMENT_DRAG_ICONS:
+    render_drag_icons (phoc_server_get_input (phoc_server_get_default ()), ctx);
+    break;
+  case RENDER_ELEMENT_XWAYLAND_CHILDREN:
+  case RENDER_ELEMENT_LAYER_SURFACE:
+    ctx->alpha = render_element_get_alpha (elem);
+    render_element_for_each_surface (output, elem, render_surface_iterator, ctx);
+    break;
+  default:
+    g_assert_not_reached ();
+  }
+}
+
+
+static void
+view_render_to_buffer_iterator (struct wlr_surface *surface, int sx, int sy, void *_data)
+{
+  struct wlr_texture *texture;
+  struct render_view_data *data = _data;
+  struct wlr_box geo;
+  struct wlr_fbox src_box;
+  float alpha = phoc_view_get_alpha (data->view);
+
+  if (!wlr_surface_has_buffer (surface))
+    return;
+
+  texture = wlr_surface_get_texture (surface);
+  phoc_view_get_geometry (data->view, &geo);
+  wlr_surface_get_buffer_source_box (surface, &src_box);
+
+  struct wlr_box dst_box = {
+    .x = -geo.x + sx,
+    .y = -geo.y + sy,
+    .width = surface->current.width,
+    .height = surface->current.height,
+  };
+
+  float scale = fmin (data->width / (float)geo.width,
+                      data->height / (float)geo.height);
+  phoc_utils_scale_box (&dst_box, scale);
+
+  wlr_render_pass_add_texture (data->render_pass, &(struct wlr_render_texture_options) {
+      .texture = texture,
+      .src_box = src_box,
+      .dst_box = dst_box,
+      .transform = surface->current.transform,
+      .alpha = &alpha,
+      .clip = data->clip,
+    });
+}
+
+
+static struct wlr_buffer *
+thumbnail_pool_acquire (PhocRenderer *self, int width, int height)
+{
+  const struct wlr_drm_format *fmt;
+
+  for (GList *l = self->thumbnail_pool.head; l; l = l->next) {
+    struct wlr_buffer *buffer = l->data;
+
+    if (buffer->width == width && buffer->height == height) {
+      g_queue_delete_link (&self->thumbnail_pool, l);
+      return buffer;
+    }
+  }
+
+  fmt = wlr_drm_format_set_get (&self->thumbnail_formats, DRM_FORMAT_ARGB8888);
+  return wlr_allocator_create_buffer (self->wlr_allocator, width, height, fmt);
+}
+
+
+static void
+thumbnail_pool_release (PhocRenderer *self, struct wlr_buffer *buffer)
+{
+  if (buffer == NULL)
+    return;
+
+  g_queue_push_head (&self->thumbnail_pool, buffer);
+
+  /* Drop the least recently used buffers */
+  while (g_queue_get_length (&self->thumbnail_pool) > PHOC_THUMBNAIL_POOL_SIZE)
+    wlr_buffer_drop (g_queue_pop_tail (&self->thumbnail_pool));
+}
+
+
+static void
+on_thumbnail_view_surface_destroy (PhocView *view, PhocRenderer *self)
+{
+  g_hash_table_remove (self->thumbnails, view);
+}
+
+
+static gboolean
+thumbnail_is_expired (gpointer key, gpointer value, gpointer user_data)
+{
+  PhocThumbnail *thumbnail = value;
+  gint64 now_us = *(gint64 *)user_data;
+
+  return now_us - thumbnail->last_used_us > PHOC_THUMBNAIL_EXPIRE_S * G_USEC_PER_SEC;
+}
+
+/*
+ * Drop thumbnails nobody asked for in a while so their views stop
+ * tracking content damage.
+ */
+static gboolean
+on_thumbnail_expire_timeout (gpointer user_data)
+{
+  PhocRenderer *self = PHOC_RENDERER (user_data);
+  gint64 now_us = g_get_monotonic_time ();
+
+  g_hash_table_foreach_remove (self->thumbnails, thumbnail_is_expired, &now_us);
+  if (g_hash_table_size (self->thumbnails))
+    return G_SOURCE_CONTINUE;
+
+  self->thumbnail_expire_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+phoc_thumbnail_free (PhocThumbnail *thumbnail)
+{
+  g_signal_handlers_disconnect_by_func (thumbnail->view,
+                                        on_thumbnail_view_surface_destroy,
+                                        thumbnail->renderer);
+  phoc_view_release_content_damage (thumbnail->view);
+  thumbnail_pool_release (thumbnail->renderer, thumbnail->buffer);
+  g_free (thumbnail->pixels);
+  g_free (thumbnail);
+}
+
+
+static PhocThumbnail *
+get_thumbnail (PhocRenderer *self, PhocView *view)
+{
+  PhocThumbnail *thumbnail = g_hash_table_lookup (self->thumbnails, view);
+
+  if (thumbnail)
+    return thumbnail;
+
+  thumbnail = g_new0 (PhocThumbnail, 1);
+  thumbnail->renderer = self;
+  thumbnail->view = view;
+  g_signal_connect (view, "surface-destroy",
+                    G_CALLBACK (on_thumbnail_view_surface_destroy),
+                    self);
+  phoc_view_hold_content_damage (view);
+  g_hash_table_insert (self->thumbnails, view, thumbnail);
+
+  if (!self->thumbnail_expire_id) {
+    self->thumbnail_expire_id = g_timeout_add_seconds (PHOC_THUMBNAIL_EXPIRE_S,
+                                                       on_thumbnail_expire_timeout,
+                                                       self);
+    g_source_set_name_by_id (self->thumbnail_expire_id, "[phoc] thumbnail expiry");
+  }
+
+  return thumbnail;
+}
+
+
+static gboolean
+thumbnail_is_compatible (PhocThumbnail *thumbnail, int width, int height)
+{
+  PhocView *view = thumbnail->view;
+  struct wlr_box geo;
+
+  phoc_view_get_geometry (view, &geo);
+
+  return thumbnail->valid &&
+    thumbnail->width == width &&
+    thumbnail->height == height &&
+    thumbnail->alpha == phoc_view_get_alpha (view) &&
+    wlr_box_equal (&thumbnail->geo, &geo);
+}
+
+/*
+ * Converts damage in view surface coordinates to thumbnail coordinates,
+ * see view_render_to_buffer_iterator ().
+ */
+static void
+thumbnail_damage_from_view_damage (PhocThumbnail     *thumbnail,
+                                   pixman_region32_t *damage,
+                                   pixman_region32_t *view_damage)
+{
+  float scale = fmin (thumbnail->width / (float)thumbnail->geo.width,
+                      thumbnail->height / (float)thumbnail->geo.height);
+
+  pixman_region32_copy (damage, view_damage);
+  pixman_region32_translate (damage, -thumbnail->geo.x, -thumbnail->geo.y);
+  wlr_region_scale (damage, damage, scale);
+  /* Account for filtering when scaling down */
+  wlr_region_expand (damage, damage, 1);
+  pixman_region32_intersect_rect (damage, damage, 0, 0, thumbnail->width, thumbnail->height);
+}
+
+/*
+ * Determines the area of the thumbnail that changed since the last
+ * delivered thumbnail and makes the thumbnail track the view's current
+ * state.
+ */
+static void
+thumbnail_update (PhocThumbnail *thumbnail, int width, int height, pixman_region32_t *damage)
+{
+  PhocView *view = thumbnail->view;
+  pixman_region32_t view_damage;
+  gboolean partial;
+
+  pixman_region32_init (&view_damage);
+  partial = phoc_view_take_content_damage (view, &view_damage);
+  partial = partial && thumbnail_is_compatible (thumbnail, width, height);
+
+  if (partial) {
+    thumbnail_damage_from_view_damage (thumbnail, damage, &view_damage);
+  } else {
+    pixman_region32_fini (damage);
+    pixman_region32_init_rect (damage, 0, 0, width, height);
+    g_clear_pointer (&thumbnail->pixels, g_free);
+  }
+  pixman_region32_fini (&view_damage);
+
+  thumbnail->valid = TRUE;
+  thumbnail->width = width;
+  thumbnail->height = height;
+  thumbnail->alpha = phoc_view_get_alpha (view);
+  phoc_view_get_geometry (view, &thumbnail->geo);
+  thumbnail->commit_seq = phoc_view_get_commit_seq (view);
+}
+
+
+static void
+thumbnail_invalidate (PhocThumbnail *thumbnail)
+{
+  thumbnail->valid = FALSE;
+  g_clear_pointer (&thumbnail->pixels, g_free);
+}
+
+
+static gboolean
+render_view_to_target (PhocRenderer            *self,
+                       PhocView                *view,
+                       struct wlr_buffer       *target,
+                       const pixman_region32_t *clip)
+{
+  struct wlr_render_pass *render_pass;
+
+  render_pass = wlr_renderer_begin_buffer_pass (self->wlr_renderer, target, NULL);
+  if (!render_pass) {
+    g_warning ("Failed to start render pass");
+    return FALSE;
+  }
+
+  wlr_render_pass_add_rect (render_pass, &(struct wlr_render_rect_options){
+      .color = { 0, 0, 0, 0 },
+      .blend_mode = WLR_RENDER_BLEND_MODE_NONE,
+      .clip = clip,
+    });
+
+  struct render_view_data render_data = {
+    .view = view,
+    .width = target->width,
+    .height = target->height,
+    .render_pass = render_pass,
+    .clip = clip,
+  };
+  wlr_surface_for_each_surface (view->wlr_surface, view_render_to_buffer_iterator, &render_data);
+
+  return wlr_render_pass_submit (render_pass);
+}
+
+
+static gboolean
+thumbnail_read_pixels (PhocRenderer *self, PhocThumbnail *thumbnail, pixman_region32_t *damage)
+{
+  struct wlr_texture *texture;
+  const pixman_box32_t *rects;
+  int n_rects;
+  gboolean success = TRUE;
+
+  texture = wlr_texture_from_buffer (self->wlr_renderer, thumbnail->buffer);
+  if (!texture)
+    return FALSE;
+
+  rects = pixman_region32_rectangles (damage, &n_rects);
+  for (int i = 0; i < n_rects && success; i++) {
+    struct wlr_box box = {
+      .x = rects[i].x1,
+      .y = rects[i].y1,
+      .width = rects[i].x2 - rects[i].x1,
+      .height = rects[i].y2 - rects[i].y1,
+    };
+
+    success = wlr_texture_read_pixels (texture, &(struct wlr_texture_read_pixels_options) {
+        .data = thumbnail->pixels,
+        .format = DRM_FORMAT_ARGB8888,
+        .stride = thumbnail->width * 4,
+        .dst_x = box.x,
+        .dst_y = box.y,
+        .src_box = box,
+      });
+  }
+  wlr_texture_destroy (texture);
+
+  return success;
+}
+
+/*
+ * Brings the cached pixels up to date by rendering and reading back
+ * the damaged parts. If there are no cached pixels yet the whole
+ * thumbnail is rendered.
+ */
+static gboolean
+thumbnail_update_pixels (PhocRenderer *self, PhocThumbnail *thumbnail, pixman_region32_t *damage)
+{
+  int width = thumbnail->width, height = thumbnail->height;
+  pixman_region32_t region;
+  gboolean success = FALSE;
+
+  pixman_region32_init (&region);
+  if (thumbnail->pixels)
+    pixman_region32_copy (&region, damage);
+  else
+    pixman_region32_union_rect (&region, &region, 0, 0, width, height);
+
+  if (!pixman_region32_not_empty (&region)) {
+    success = TRUE;
+    goto out;
+  }
+
+  if (thumbnail->buffer == NULL ||
+      thumbnail->buffer->width != width ||
+      thumbnail->buffer->height != height) {
+    thumbnail_pool_release (self, thumbnail->buffer);
+    thumbnail->buffer = thumbnail_pool_acquire (self, width, height);
+  }
+
+  if (!thumbnail->buffer) {
+    g_warning ("Failed to allocate buffer");
+    goto out;
+  }
+
+  if (!render_view_to_target (self, thumbnail->view, thumbnail->buffer, &region))
+    goto out;
+
+  if (thumbnail->pixels == NULL)
+    thumbnail->pixels = g_malloc (width * height * 4);
+
+  success = thumbnail_read_pixels (self, thumbnail, &region);
+
+ out:
+  pixman_region32_fini (&region);
+  return success;
+}
+
+
+static gboolean
+thumbnail_copy_to_shm (PhocThumbnail *thumbnail, struct wlr_buffer *shm_buffer)
+{
+  void *data;
+  uint32_t format;
+  size_t stride;
+
+  if (!wlr_buffer_begin_data_ptr_access (shm_buffer,
+                                         WLR_BUFFER_DATA_PTR_ACCESS_WRITE,
+                                         &data, &format, &stride)) {
+    return FALSE;
+  }
+
+  if (format != DRM_FORMAT_ARGB8888) {
+    wlr_buffer_end_data_ptr_access (shm_buffer);
+    return FALSE;
+  }
+
+  /* The client might use a different buffer each time so copy it all */
+  for (int y = 0; y < thumbnail->height; y++) {
+    memcpy ((guint8 *)data + y * stride,
+            thumbnail->pixels + y * thumbnail->width * 4,
+            thumbnail->width * 4);
+  }
+
+  wlr_buffer_end_data_ptr_access (shm_buffer);
+
+  return TRUE;
+}
+
+/**
+ * phoc_renderer_render_view_to_buffer:
+ * @self: The renderer
+ * @view: The view to render
+ * @buffer: The buffer to render into
+ * @damage:(nullable): Return location for the damaged area
+ *
+ * Renders a thumbnail of the view scaled to the size of `buffer`.
+ *
+ * DMA-BUF buffers are rendered into directly. For SHM buffers the
+ * last thumbnail of each view is cached so only the parts of the
+ * view that changed since the last thumbnail are rendered and read
+ * back. Render targets are taken from a pool so they don't need to be
+ * reallocated for each thumbnail.
+ *
+ * If `damage` is given it is set to the area of the thumbnail that
+ * changed since the last thumbnail of this view was rendered.
+ *
+ * Returns: `TRUE` on success, otherwise `FALSE`
+ */
+gboolean
+phoc_renderer_render_view_to_buffer (PhocRenderer      *self,
+                                     PhocView          *view,
+                                     struct wlr_buffer *buffer,
+                                     pixman_region32_t *damage)
+{
+  PhocThumbnail *thumbnail;
+  pixman_region32_t thumbnail_damage;
+  struct wlr_dmabuf_attributes dmabuf;
+  gboolean success;
+
+  g_return_val_if_fail (view->wlr_surface, false);
+  g_return_val_if_fail (self->wlr_allocator, false);
+  g_return_val_if_fail (buffer, false);
+
+  pixman_region32_init (&thumbnail_damage);
+  thumbnail = get_thumbnail (self, view);
+  thumbnail->last_used_us = g_get_monotonic_time ();
+  if (phoc_renderer_is_view_thumbnail_current (self, view, buffer->width, buffer->height))
+    g_debug ("Thumbnail for %p (%dx%d) is current", view, buffer->width, buffer->height);
+  else
+    thumbnail_update (thumbnail, buffer->width, buffer->height, &thumbnail_damage);
+
+  if (wlr_buffer_get_dmabuf (buffer, &dmabuf)) {
+    /* We don't know the buffer's contents so render it all */
+    success = render_view_to_target (self, view, buffer, NULL);
+    /* The cached pixels don't include the damage we just consumed */
+    if (pixman_region32_not_empty (&thumbnail_damage))
+      g_clear_pointer (&thumbnail->pixels, g_free);
+  } else {
+    success = thumbnail_update_pixels (self, thumbnail, &thumbnail_damage) &&
+      thumbnail_copy_to_shm (thumbnail, buffer);
+  }
+
+  if (!success)
+    thumbnail_invalidate (thumbnail);
+
+  if (damage)
+    pixman_region32_copy (damage, &thumbnail_damage);
+  pixman_region32_fini (&thumbnail_damage);
+
+  return success;
+}
+
+/**
+ * phoc_renderer_is_view_thumbnail_current:
+ * @self: The renderer
+ * @view: The view
+ * @width: The thumbnail's width
+ * @height: The thumbnail's height
+ *
+ * Checks whether the cached thumbnail of the given size is up to date
+ * with the view's contents.
+ *
+ * Returns: `TRUE` if the view didn't change since the last thumbnail
+ *   of the given size was rendered.
+ */
+gboolean
+phoc_renderer_is_view_thumbnail_current (PhocRenderer *self,
+                                         PhocView     *view,
+                                         int           width,
+                                         int           height)
+{
+  PhocThumbnail *thumbnail;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  thumbnail = g_hash_table_lookup (self->thumbnails, view);
+  if (thumbnail == NULL)
+    return FALSE;
+
+  return thumbnail_is_compatible (thumbnail, width, height) &&
+    thumbnail->commit_seq == phoc_view_get_commit_seq (view);
+}
+
+
+static void
+on_saved_element_finalized (gpointer data, GObject *where_the_object_was)
+{
+  PhocRenderer *self = PHOC_RENDERER (data);
+
+  g_hash_table_remove (self->saved_elements, where_the_object_was);
+}
+
+/*
+ * Damage where the saved buffers were shown and where the element's
+ * current buffers go.
+ */
+static void
+damage_saved_element (gpointer element, PhocSavedElement *saved)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output;
+
+  wl_list_for_each (output, &desktop->outputs, link) {
+    struct wlr_box box = saved->bounds;
+
+    box.x -= output->lx;
+    box.y -= output->ly;
+    phoc_utils_scale_box (&box, output->wlr_output->scale);
+    phoc_output_damage_box (output, &box);
+  }
+
+  if (PHOC_IS_VIEW (element)) {
+    if (phoc_view_is_mapped (PHOC_VIEW (element)))
+      phoc_view_damage_whole (PHOC_VIEW (element));
+  } else {
+    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (element);
+
+    output = phoc_layer_surface_get_output (layer_surface);
+    if (output)
+      phoc_output_damage_from_layer_surface (output, layer_surface, TRUE);
+  }
+}
+
+/**
+ * phoc_renderer_save_element:
+ * @self: The renderer
+ * @element: A view or layer surface
+ *
+ * Saves the buffers currently making up @element. Until the element
+ * is dropped via [method@Renderer.drop_saved_element] or
+ * [method@Renderer.drop_saved_elements] the saved buffers are shown
+ * instead of the element's current ones and damage from the element
+ * is ignored. Everything else keeps being rendered as usual. This is
+ * a noop if the element is saved already.
+ */
+void
+phoc_renderer_save_element (PhocRenderer *self, gpointer element)
+{
+  PhocSavedElement *saved;
+  SaveElementData data;
+  pixman_box32_t *extents;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  if (g_hash_table_contains (self->saved_elements, element))
+    return;
+
+  saved = g_new0 (PhocSavedElement, 1);
+  saved->surfaces = g_array_new (FALSE, FALSE, sizeof (PhocSavedSurface));
+  g_array_set_clear_func (saved->surfaces, (GDestroyNotify)saved_surface_clear);
+  data.saved = saved;
+  pixman_region32_init (&data.bounds);
+
+  if (PHOC_IS_VIEW (element)) {
+    PhocView *view = PHOC_VIEW (element);
+
+    data.lx = view->box.x;
+    data.ly = view->box.y;
+    data.scale = phoc_view_get_scale (view);
+    phoc_view_for_each_surface (view, save_surface_iterator, &data);
+  } else {
+    PhocLayerSurface *layer_surface = PHOC_LAYER_SURFACE (element);
+    PhocOutput *output = phoc_layer_surface_get_output (layer_surface);
+
+    if (output) {
+      data.lx = output->lx + layer_surface->geo.x;
+      data.ly = output->ly + layer_surface->geo.y;
+      data.scale = 1.0;
+      wlr_layer_surface_v1_for_each_surface (layer_surface->layer_surface,
+                                             save_surface_iterator,
+                                             &data);
+    }
+  }
+
+  extents = pixman_region32_extents (&data.bounds);
+  saved->bounds = (struct wlr_box) {
+    .x = extents->x1,
+    .y = extents->y1,
+    .width = extents->x2 - extents->x1,
+    .height = extents->y2 - extents->y1,
+  };
+  pixman_region32_fini (&data.bounds);
+
+  g_hash_table_insert (self->saved_elements, element, saved);
+  g_object_weak_ref (G_OBJECT (element), on_saved_element_finalized, self);
+}
+
+/**
+ * phoc_renderer_is_element_saved:
+ * @self: The renderer
+ * @element: A view or layer surface
+ *
+ * Returns: `TRUE` if saved buffers are shown instead of the @element's
+ *   current ones.
+ */
+gboolean
+phoc_renderer_is_element_saved (PhocRenderer *self, gpointer element)
+{
+  g_assert (PHOC_IS_RENDERER (self));
+
+  return g_hash_table_contains (self->saved_elements, element);
+}
+
+/**
+ * phoc_renderer_drop_saved_element:
+ * @self: The renderer
+ * @element: A view or layer surface
+ *
+ * Drops the buffers saved via [method@Renderer.save_element] and
+ * damages the area the saved and the current buffers cover so the
+ * @element's current state gets shown.
+ */
+void
+phoc_renderer_drop_saved_element (PhocRenderer *self, gpointer element)
+{
+  PhocSavedElement *saved;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  if (!g_hash_table_steal_extended (self->saved_elements, element, NULL, (gpointer *)&saved))
+    return;
+
+  g_object_weak_unref (G_OBJECT (element), on_saved_element_finalized, self);
+  damage_saved_element (element, saved);
+  phoc_saved_element_free (saved);
+}
+
+/**
+ * phoc_renderer_drop_saved_elements:
+ * @self: The renderer
+ *
+ * Drops all saved elements. See [method@Renderer.drop_saved_element].
+ */
+void
+phoc_renderer_drop_saved_elements (PhocRenderer *self)
+{
+  g_autoptr (GList) elements = NULL;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  elements = g_hash_table_get_keys (self->saved_elements);
+  for (GList *l = elements; l; l = l->next)
+    phoc_renderer_drop_saved_element (self, l->data);
+}
+
+
+#define DEBUG_DAMAGE_TIMEOUT_US (250.0 * 1000.0)
+#define DEBUG_DAMAGE_MAX_OPACITY 0.8
+
+static void
+render_damage (PhocRenderer *self, PhocRenderContext *ctx)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  for (GSList *l = phoc_output_get_debug_damage (ctx->output); l; l = l->next) {
+    PhocDebugDamageRegion *damage = l->data;
+    float elapsed = fmax (1.0 - (now - damage->when) / DEBUG_DAMAGE_TIMEOUT_US, 0.0);
+    float alpha = DEBUG_DAMAGE_MAX_OPACITY * elapsed;
+    struct pixman_region32 clip;
+
+    pixman_region32_init (&clip);
+    pixman_region32_copy (&clip, &damage->region);
+
+    /* Using an empty box makes us clip the damage from the whole output buffer */
+    wlr_render_pass_add_rect (ctx->render_pass, &(struct wlr_render_rect_options){
+        .color = COLOR_MAGENTA_ALPHA (alpha),
+        .clip = &clip,
+      });
+
+    if (G_APPROX_VALUE (elapsed, 0.0, FLT_EPSILON))
+      damage->done = 1;
+
+    pixman_region32_fini (&clip);
   }
 }
 
@@ -457,8 +1740,9 @@ phoc_renderer_render_output (PhocRenderer *self, PhocOutput *output, PhocRenderC
   gint64 begin_time_nsec G_GNUC_UNUSED = PHOC_TRACE_CURRENT_TIME;
   PhocServer *server = phoc_server_get_default ();
   struct wlr_output *wlr_output = output->wlr_output;
-  PhocDesktop *desktop = PHOC_DESKTOP (output->desktop);
   pixman_region32_t *damage = ctx->damage;
+  pixman_region32_t occluded, background;
+  guint n_culled G_GNUC_UNUSED = 0;
 
   g_assert (PHOC_IS_RENDERER (self));
 
@@ -467,57 +1751,41 @@ phoc_renderer_render_output (PhocRenderer *self, PhocOutput *output, PhocRenderC
     goto renderer_end;
   }
 
-  wlr_render_pass_add_rect (ctx->render_pass,
-                            &(struct wlr_render_rect_options){
-                              .box = { .width = wlr_output->width, .height = wlr_output->height },
-                              .color = COLOR_BLACK,
-                              .clip = damage,
-                            });
-
-  /* If a view is fullscreen on this output, render it */
-  if (output->fullscreen_view != NULL) {
-    PhocView *view = output->fullscreen_view;
-
-    render_view (output, view, ctx);
+  ensure_render_elements (self, output);
+
+  pixman_region32_init (&occluded);
+  n_culled = cull_render_elements (self, output, damage, &occluded);
+
+  /* Only clear what isn't covered by opaque surfaces anyway */
+  pixman_region32_init (&background);
+  pixman_region32_subtract (&background, damage, &occluded);
+  pixman_region32_fini (&occluded);
+  if (pixman_region32_not_empty (&background)) {
+    wlr_render_pass_add_rect (ctx->render_pass,
+                              &(struct wlr_render_rect_options){
+                                .box = { .width = wlr_output->width, .height = wlr_output->height },
+                                .color = COLOR_BLACK,
+                                .clip = &background,
+                              });
+  }
+  pixman_region32_fini (&background);
 
-    /* During normal rendering the xwayland window tree isn't traversed
-     * because all windows are rendered. Here we only want to render
-     * the fullscreen window's children so we have to traverse the tree. */
-#ifdef PHOC_XWAYLAND
-    if (PHOC_IS_XWAYLAND_SURFACE (view)) {
-      struct wlr_xwayland_surface *xsurface =
-        phoc_xwayland_surface_get_wlr_surface (PHOC_XWAYLAND_SURFACE (view));
-      phoc_output_xwayland_children_for_each_surface (output,
-                                                      xsurface,
-                                                      render_surface_iterator,
-                                                      ctx);
-    }
-#endif
+  for (guint i = 0; i < self->render_elements->len; i++) {
+    RenderElement *elem = &g_array_index (self->render_elements, RenderElement, i);
 
-    if (phoc_output_has_shell_revealed (output)) {
-      /* Render top layer above fullscreen view when requested */
-      render_layer (ZWLR_LAYER_SHELL_V1_LAYER_TOP, ctx);
-    }
-  } else {
-    /* Render background and bottom layers under views */
-    render_layer (ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND, ctx);
-    render_layer (ZWLR_LAYER_SHELL_V1_LAYER_BOTTOM, ctx);
+    if (elem->culled)
+      continue;
 
-    /* Render all views */
-    for (GList *l = phoc_desktop_get_views (desktop)->tail; l; l = l->prev) {
-      PhocView *view = PHOC_VIEW (l->data);
-
-      if (phoc_desktop_view_check_visibility (desktop, view))
-        render_view (output, view, ctx);
-    }
-    /* Render top layer above views */
-    render_layer (ZWLR_LAYER_SHELL_V1_LAYER_TOP, ctx);
+    ctx->damage = &elem->damage;
+    render_element (output, elem, ctx);
   }
-  render_drag_icons (phoc_server_get_input (server), ctx);
+  ctx->damage = damage;
 
-  render_layer (ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY, ctx);
+  PHOC_DTRACE_PROBE3 (phoc, render_culled, wlr_output->name, n_culled,
+                      self->render_elements->len);
 
  renderer_end:
+  clear_render_elements (self);
   wlr_output_add_software_cursors_to_render_pass (wlr_output, ctx->render_pass, damage);
 
   if (G_UNLIKELY (phoc_server_check_debug_flags (server, PHOC_SERVER_DEBUG_FLAG_TOUCH_POINTS)))
@@ -529,7 +1797,113 @@ phoc_renderer_render_output (PhocRenderer *self, PhocOutput *output, PhocRenderC
 
   phoc_trace_mark (begin_time_nsec, PHOC_TRACE_CURRENT_TIME - begin_time_nsec,
                    "phoc", __func__,
-                   "Render output %s", output->wlr_output->name);
+                   "Render output %s, culled %u elements", output->wlr_output->name, n_culled);
+}
+
+
+/**
+ * phoc_renderer_assign_planes:
+ * @self: The renderer
+ * @output: The output to assign planes for
+ * @states: (array length=n_states): The layer states to fill in
+ * @surfaces: (array length=n_states): Filled with the surface of each used state
+ * @n_states: The number of available layer states
+ *
+ * Finds surfaces that can be displayed on the output's overlay planes
+ * instead of being composited. Output layers are stacked above the
+ * composited content so a surface is only eligible if nothing
+ * composited above it overlaps it. The buffer and position of the
+ * eligible surfaces are filled into `states` in back to front order,
+ * the states' layers are left untouched.
+ *
+ * The caller is expected to validate the result with a test commit
+ * and pass the surfaces that ended up on planes to
+ * [method@Renderer.render_output] via the render context's
+ * `plane_surfaces`.
+ *
+ * Returns: The number of used layer states
+ */
+guint
+phoc_renderer_assign_planes (PhocRenderer                  *self,
+                             PhocOutput                    *output,
+                             struct wlr_output_layer_state *states,
+                             struct wlr_surface           **surfaces,
+                             guint                          n_states)
+{
+  struct wlr_output *wlr_output = output->wlr_output;
+  PlaneCandidate *candidates;
+  pixman_region32_t above, opaque;
+  guint n = 0;
+
+  g_assert (PHOC_IS_RENDERER (self));
+
+  if (n_states == 0)
+    return 0;
+
+  candidates = g_newa (PlaneCandidate, n_states);
+  ensure_render_elements (self, output);
+
+  /* The bounds of everything composited above the current element */
+  pixman_region32_init (&above);
+  pixman_region32_init (&opaque);
+
+  for (int i = self->render_elements->len - 1; i >= 0 && n < n_states; i--) {
+    RenderElement *elem = &g_array_index (self->render_elements, RenderElement, i);
+    PlaneCandidate *candidate = &candidates[n];
+    OcclusionData data = {
+      .alpha = render_element_get_alpha (elem),
+      .opaque = &opaque,
+      .bounds = &above,
+    };
+
+    *candidate = (PlaneCandidate) { 0 };
+    if (get_plane_candidate (output, elem, candidate)) {
+      pixman_box32_t box = {
+        .x1 = candidate->dst_box.x,
+        .y1 = candidate->dst_box.y,
+        .x2 = candidate->dst_box.x + candidate->dst_box.width,
+        .y2 = candidate->dst_box.y + candidate->dst_box.height,
+      };
+
+      if (pixman_region32_contains_rectangle (&above, &box) == PIXMAN_REGION_OUT) {
+        /*
+         * The backend might reject this candidate so it can end up
+         * composited. Keep overlapping elements below it off planes
+         * so they can't end up above it.
+         */
+        pixman_region32_union_rect (&above, &above, box.x1, box.y1,
+                                    candidate->dst_box.width, candidate->dst_box.height);
+        n++;
+        continue;
+      }
+    }
+
+    /* Blings aren't confined to the view's surfaces */
+    if (render_element_has_blings (elem)) {
+      pixman_region32_union_rect (&above, &above, 0, 0, wlr_output->width, wlr_output->height);
+      continue;
+    }
+
+    render_element_for_each_surface (output, elem, occlusion_surface_iterator, &data);
+  }
+
+  pixman_region32_fini (&opaque);
+  pixman_region32_fini (&above);
+
+  /* Candidates were found front to back but layers are stacked back to front */
+  for (guint i = 0; i < n; i++) {
+    PlaneCandidate *candidate = &candidates[n - i - 1];
+    struct wlr_output_layer_state *state = &states[i];
+
+    state->buffer = &candidate->surface->buffer->base;
+    wlr_surface_get_buffer_source_box (candidate->surface, &state->src_box);
+    state->dst_box = candidate->dst_box;
+    state->damage = NULL;
+    state->accepted = false;
+    surfaces[i] = candidate->surface;
+  }
+
+  return n;
 }
 
 
@@ -557,6 +1931,8 @@ phoc_renderer_initable_init (GInitable    *initable,
     return FALSE;
   }
 
+  wlr_drm_format_set_add (&self->thumbnail_formats, DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR);
+
   return TRUE;
 }
 
@@ -565,7 +1941,20 @@ static void
 phoc_renderer_finalize (GObject *object)
 {
   PhocRenderer *self = PHOC_RENDERER (object);
-
+  GHashTableIter iter;
+  gpointer element;
+
+  g_hash_table_iter_init (&iter, self->saved_elements);
+  while (g_hash_table_iter_next (&iter, &element, NULL))
+    g_object_weak_unref (G_OBJECT (element), on_saved_element_finalized, self);
+  g_clear_pointer (&self->saved_elements, g_hash_table_destroy);
+
+  g_clear_pointer (&self->render_elements, g_array_unref);
+  g_clear_handle_id (&self->thumbnail_expire_id, g_source_remove);
+  g_clear_pointer (&self->thumbnails, g_hash_table_destroy);
+  g_clear_pointer (&self->prescaled_surfaces, g_hash_table_destroy);
+  g_queue_clear_full (&self->thumbnail_pool, (GDestroyNotify)wlr_buffer_drop);
+  wlr_drm_format_set_finish (&self->thumbnail_formats);
   g_clear_pointer (&self->wlr_allocator, wlr_allocator_destroy);
   g_clear_pointer (&self->wlr_renderer, wlr_renderer_destroy);
 
@@ -622,6 +2011,14 @@ phoc_renderer_class_init (PhocRendererClass *klass)
 static void
 phoc_renderer_init (PhocRenderer *self)
 {
+  self->render_elements = g_array_new (FALSE, FALSE, sizeof (RenderElement));
+  self->thumbnails = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                            (GDestroyNotify)phoc_thumbnail_free);
+  g_queue_init (&self->thumbnail_pool);
+  self->prescaled_surfaces = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                    (GDestroyNotify)phoc_prescaled_surface_free);
+  self->saved_elements = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                (GDestroyNotify)phoc_saved_element_free);
 }
 
 
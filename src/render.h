@@ -8,6 +8,7 @@
 #include <glib-object.h>
 
 #include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_output_layer.h>
 
 G_BEGIN_DECLS
 
@@ -25,16 +26,34 @@ typedef struct _PhocRenderContext {
   float                       alpha;
   struct wlr_render_pass     *render_pass;
   enum wlr_scale_filter_mode  tex_filter;
+  /* Surfaces displayed on overlay planes, these aren't composited */
+  GPtrArray                  *plane_surfaces;
 } PhocRenderContext;
 
 
 PhocRenderer *phoc_renderer_new (struct wlr_backend *wlr_backend, GError **error);
 
+void          phoc_renderer_prepare_output (PhocRenderer *self,
+                                            PhocOutput   *output);
 void          phoc_renderer_render_output (PhocRenderer      *self,
                                            PhocOutput        *output,
                                            PhocRenderContext *context);
+guint         phoc_renderer_assign_planes (PhocRenderer                  *self,
+                                           PhocOutput                    *output,
+                                           struct wlr_output_layer_state *states,
+                                           struct wlr_surface           **surfaces,
+                                           guint                          n_states);
 gboolean      phoc_renderer_render_view_to_buffer (PhocRenderer           *self,
                                                    PhocView               *view,
-                                                   struct wlr_buffer      *data);
+                                                   struct wlr_buffer      *data,
+                                                   pixman_region32_t      *damage);
+void          phoc_renderer_save_element (PhocRenderer *self, gpointer element);
+gboolean      phoc_renderer_is_element_saved (PhocRenderer *self, gpointer element);
+void          phoc_renderer_drop_saved_element (PhocRenderer *self, gpointer element);
+void          phoc_renderer_drop_saved_elements (PhocRenderer *self);
+gboolean      phoc_renderer_is_view_thumbnail_current (PhocRenderer *self,
+                                                       PhocView     *view,
+                                                       int           width,
+                                                       int           height);
 
 G_END_DECLS
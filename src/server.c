@@ -855,33 +855,43 @@ phoc_server_get_session (PhocServer *self)
 }
 
 
+/**
+ * phoc_server_set_linux_dmabuf_surface_feedback:
+ * @self: The server
+ * @wlr_surface: The surface to send feedback to
+ * @output: (nullable): The output to add scanout tranches for
+ *
+ * Sends dmabuf feedback with scanout tranches for @output to
+ * @wlr_surface so the client can allocate buffers suitable for direct
+ * scanout. If @output is %NULL the surface gets the default feedback
+ * again.
+ */
 void
-phoc_server_set_linux_dmabuf_surface_feedback (PhocServer *self,
-                                               PhocView   *view,
-                                               PhocOutput *output,
-                                               bool        enable)
+phoc_server_set_linux_dmabuf_surface_feedback (PhocServer         *self,
+                                               struct wlr_surface *wlr_surface,
+                                               PhocOutput         *output)
 {
   g_assert (PHOC_IS_SERVER (self));
 
-  if (!self->linux_dmabuf_v1 || !view->wlr_surface)
+  if (!self->linux_dmabuf_v1 || !wlr_surface)
     return;
 
-  g_assert ((enable && output && output->wlr_output) || (!enable && !output));
-
-  if (enable) {
+  if (output) {
     struct wlr_linux_dmabuf_feedback_v1 feedback = { 0 };
     const struct wlr_linux_dmabuf_feedback_v1_init_options options = {
       .main_renderer = phoc_renderer_get_wlr_renderer (self->renderer),
       .scanout_primary_output = output->wlr_output,
     };
 
+    g_assert (output->wlr_output);
+
     if (!wlr_linux_dmabuf_feedback_v1_init_with_options (&feedback, &options))
       return;
 
-    wlr_linux_dmabuf_v1_set_surface_feedback (self->linux_dmabuf_v1, view->wlr_surface, &feedback);
+    wlr_linux_dmabuf_v1_set_surface_feedback (self->linux_dmabuf_v1, wlr_surface, &feedback);
     wlr_linux_dmabuf_feedback_v1_finish (&feedback);
   } else {
-    wlr_linux_dmabuf_v1_set_surface_feedback (self->linux_dmabuf_v1, view->wlr_surface, NULL);
+    wlr_linux_dmabuf_v1_set_surface_feedback (self->linux_dmabuf_v1, wlr_surface, NULL);
   }
 }
 
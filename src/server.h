@@ -79,10 +79,9 @@ struct wlr_session    *phoc_server_get_session             (PhocServer *self);
 struct wlr_backend    *phoc_server_get_backend             (PhocServer *self);
 struct wlr_compositor *phoc_server_get_compositor          (PhocServer *self);
 struct wl_display     *phoc_server_get_wl_display          (PhocServer *self);
-void                   phoc_server_set_linux_dmabuf_surface_feedback (PhocServer *self,
-                                                                      PhocView   *view,
-                                                                      PhocOutput *output,
-                                                                      bool        enable);
+void                   phoc_server_set_linux_dmabuf_surface_feedback (PhocServer         *self,
+                                                                      struct wlr_surface *wlr_surface,
+                                                                      PhocOutput         *output);
 gboolean               phoc_server_get_allow_input         (PhocServer *self);
 
 G_END_DECLS
@@ -162,6 +162,20 @@ config_ini_handler (PhocConfig *config, const char *section, const char *name, c
       } else {
         g_critical ("got unknown xwayland value: %s", value);
       }
+    } else if (strcmp (name, "max-damage-rects") == 0) {
+      config->max_damage_rects = strtoul (value, NULL, 10);
+    } else if (strcmp (name, "damage-overdraw") == 0) {
+      config->damage_overdraw = CLAMP (strtof (value, NULL), 0.0, 1.0);
+    } else if (strcmp (name, "coalesce-motion") == 0) {
+      config->coalesce_motion = parse_boolean (value, config->coalesce_motion);
+    } else if (strcmp (name, "render-deadline") == 0) {
+      config->render_deadline = parse_boolean (value, config->render_deadline);
+    } else if (strcmp (name, "hidden-frame-rate") == 0) {
+      config->hidden_frame_rate = MIN (strtoul (value, NULL, 10), 1000);
+    } else if (strcmp (name, "freeze-suspended") == 0) {
+      config->freeze_suspended = parse_boolean (value, config->freeze_suspended);
+    } else if (strcmp (name, "scale-to-fit-prescale") == 0) {
+      config->scale_to_fit_prescale = parse_boolean (value, config->scale_to_fit_prescale);
     } else {
       g_critical ("got unknown core config: %s", name);
     }
@@ -269,6 +283,10 @@ phoc_config_new_from_keyfile (GKeyFile *keyfile)
 
   config->xwayland = true;
   config->xwayland_lazy = true;
+  config->max_damage_rects = PHOC_CONFIG_DEFAULT_MAX_DAMAGE_RECTS;
+  config->damage_overdraw = PHOC_CONFIG_DEFAULT_DAMAGE_OVERDRAW;
+  config->hidden_frame_rate = PHOC_CONFIG_DEFAULT_HIDDEN_FRAME_RATE;
+  config->freeze_suspended = true;
   config->keybindings = phoc_keybindings_new ();
 
   sections = g_key_file_get_groups (keyfile, NULL);
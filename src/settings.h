@@ -10,6 +10,9 @@
 G_BEGIN_DECLS
 
 #define PHOC_CONFIG_DEFAULT_SEAT_NAME "seat0"
+#define PHOC_CONFIG_DEFAULT_MAX_DAMAGE_RECTS 32
+#define PHOC_CONFIG_DEFAULT_DAMAGE_OVERDRAW 0.25
+#define PHOC_CONFIG_DEFAULT_HIDDEN_FRAME_RATE 1
 
 typedef struct _PhocOutputModeConfig {
   drmModeModeInfo info;
@@ -44,6 +47,17 @@ typedef struct _PhocConfig {
   bool             xwayland;
   bool             xwayland_lazy;
 
+  guint            max_damage_rects;
+  float            damage_overdraw;
+
+  bool             coalesce_motion;
+  bool             render_deadline;
+
+  guint            hidden_frame_rate;
+  bool             freeze_suspended;
+
+  bool             scale_to_fit_prescale;
+
   PhocKeybindings *keybindings;
 
   GSList          *outputs;
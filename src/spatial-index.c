@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phoc-spatial-index"
+
+#include "phoc-config.h"
+
+#include "spatial-index.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define PHOC_SPATIAL_INDEX_CELL_SIZE 256
+/* Items covering more cells are kept out of the grid */
+#define PHOC_SPATIAL_INDEX_MAX_CELLS 1024
+
+/**
+ * PhocSpatialIndex:
+ *
+ * An index of boxes in layout (or output) coordinates that allows to
+ * quickly look up the items at a given position.
+ *
+ * Items are sorted into a grid of fixed size cells so a lookup only
+ * needs to look at the items overlapping the cell the position is
+ * in. Items too large for the grid are checked on every lookup.
+ * Each item has an order (e.g. its position in the stack), lookups
+ * return the items sorted by descending order.
+ */
+
+typedef struct {
+  gpointer       item;
+  struct wlr_box box;
+  guint          order;
+  gboolean       large;
+} PhocSpatialIndexEntry;
+
+struct _PhocSpatialIndex {
+  GObject     parent;
+
+  GHashTable *entries; /* item -> PhocSpatialIndexEntry */
+  GHashTable *cells;   /* gint64 cell key -> GPtrArray of PhocSpatialIndexEntry */
+  GPtrArray  *large;   /* PhocSpatialIndexEntry */
+};
+G_DEFINE_TYPE (PhocSpatialIndex, phoc_spatial_index, G_TYPE_OBJECT)
+
+
+static int
+cell_coord (int v)
+{
+  /* Round towards negative infinity so negative coordinates work too */
+  if (v >= 0)
+    return v / PHOC_SPATIAL_INDEX_CELL_SIZE;
+
+  return -((-v - 1) / PHOC_SPATIAL_INDEX_CELL_SIZE) - 1;
+}
+
+
+static gint64
+cell_key (int cx, int cy)
+{
+  /* Shift as unsigned, cells left of or above the origin are negative */
+  return (gint64)(((guint64)(guint32)cx << 32) | (guint32)cy);
+}
+
+
+static void
+entry_get_cells (PhocSpatialIndexEntry *entry, int *x1, int *y1, int *x2, int *y2)
+{
+  *x1 = cell_coord (entry->box.x);
+  *y1 = cell_coord (entry->box.y);
+  *x2 = cell_coord (entry->box.x + entry->box.width - 1);
+  *y2 = cell_coord (entry->box.y + entry->box.height - 1);
+}
+
+
+static void
+insert_entry (PhocSpatialIndex *self, PhocSpatialIndexEntry *entry)
+{
+  int x1, y1, x2, y2;
+  gint64 n_cells;
+
+  entry_get_cells (entry, &x1, &y1, &x2, &y2);
+
+  n_cells = (gint64)(x2 - x1 + 1) * (y2 - y1 + 1);
+  entry->large = n_cells > PHOC_SPATIAL_INDEX_MAX_CELLS;
+  if (entry->large) {
+    g_ptr_array_add (self->large, entry);
+    return;
+  }
+
+  for (int cx = x1; cx <= x2; cx++) {
+    for (int cy = y1; cy <= y2; cy++) {
+      gint64 key = cell_key (cx, cy);
+      GPtrArray *cell = g_hash_table_lookup (self->cells, &key);
+
+      if (cell == NULL) {
+        cell = g_ptr_array_new ();
+        g_hash_table_insert (self->cells, g_memdup2 (&key, sizeof (key)), cell);
+      }
+      g_ptr_array_add (cell, entry);
+    }
+  }
+}
+
+
+static void
+remove_entry (PhocSpatialIndex *self, PhocSpatialIndexEntry *entry)
+{
+  int x1, y1, x2, y2;
+
+  if (entry->large) {
+    g_ptr_array_remove_fast (self->large, entry);
+    return;
+  }
+
+  entry_get_cells (entry, &x1, &y1, &x2, &y2);
+
+  for (int cx = x1; cx <= x2; cx++) {
+    for (int cy = y1; cy <= y2; cy++) {
+      gint64 key = cell_key (cx, cy);
+      GPtrArray *cell = g_hash_table_lookup (self->cells, &key);
+
+      g_assert (cell);
+      g_ptr_array_remove_fast (cell, entry);
+      if (cell->len == 0)
+        g_hash_table_remove (self->cells, &key);
+    }
+  }
+}
+
+
+static void
+phoc_spatial_index_finalize (GObject *object)
+{
+  PhocSpatialIndex *self = PHOC_SPATIAL_INDEX (object);
+
+  g_clear_pointer (&self->cells, g_hash_table_destroy);
+  g_clear_pointer (&self->large, g_ptr_array_unref);
+  g_clear_pointer (&self->entries, g_hash_table_destroy);
+
+  G_OBJECT_CLASS (phoc_spatial_index_parent_class)->finalize (object);
+}
+
+
+static void
+phoc_spatial_index_class_init (PhocSpatialIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phoc_spatial_index_finalize;
+}
+
+
+static void
+phoc_spatial_index_init (PhocSpatialIndex *self)
+{
+  self->entries = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+  self->cells = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                       g_free, (GDestroyNotify)g_ptr_array_unref);
+  self->large = g_ptr_array_new ();
+}
+
+
+PhocSpatialIndex *
+phoc_spatial_index_new (void)
+{
+  return g_object_new (PHOC_TYPE_SPATIAL_INDEX, NULL);
+}
+
+/**
+ * phoc_spatial_index_update:
+ * @self: The spatial index
+ * @item: The item to add or update
+ * @box: The item's bounding box
+ *
+ * Adds the item to the index or updates its bounding box if it's
+ * already in the index. Items with an empty box are removed.
+ *
+ * Returns: `TRUE` if the item's box changed
+ */
+gboolean
+phoc_spatial_index_update (PhocSpatialIndex *self, gpointer item, const struct wlr_box *box)
+{
+  PhocSpatialIndexEntry *entry;
+
+  g_assert (PHOC_IS_SPATIAL_INDEX (self));
+  g_assert (item);
+
+  if (wlr_box_empty (box))
+    return phoc_spatial_index_remove (self, item);
+
+  entry = g_hash_table_lookup (self->entries, item);
+  if (entry) {
+    if (wlr_box_equal (&entry->box, box))
+      return FALSE;
+
+    remove_entry (self, entry);
+  } else {
+    entry = g_new0 (PhocSpatialIndexEntry, 1);
+    entry->item = item;
+    g_hash_table_insert (self->entries, item, entry);
+  }
+
+  entry->box = *box;
+  insert_entry (self, entry);
+  return TRUE;
+}
+
+/**
+ * phoc_spatial_index_remove:
+ * @self: The spatial index
+ * @item: The item to remove
+ *
+ * Removes the item from the index. Removing an item that isn't in
+ * the index is a noop.
+ *
+ * Returns: `TRUE` if the item was in the index
+ */
+gboolean
+phoc_spatial_index_remove (PhocSpatialIndex *self, gpointer item)
+{
+  PhocSpatialIndexEntry *entry;
+
+  g_assert (PHOC_IS_SPATIAL_INDEX (self));
+
+  entry = g_hash_table_lookup (self->entries, item);
+  if (entry == NULL)
+    return FALSE;
+
+  remove_entry (self, entry);
+  g_hash_table_remove (self->entries, item);
+  return TRUE;
+}
+
+/**
+ * phoc_spatial_index_set_order:
+ * @self: The spatial index
+ * @item: The item
+ * @order: The item's order
+ *
+ * Sets the order of an item in the index. Lookups return items with
+ * a higher order first.
+ */
+void
+phoc_spatial_index_set_order (PhocSpatialIndex *self, gpointer item, guint order)
+{
+  PhocSpatialIndexEntry *entry;
+
+  g_assert (PHOC_IS_SPATIAL_INDEX (self));
+
+  entry = g_hash_table_lookup (self->entries, item);
+  if (entry == NULL)
+    return;
+
+  entry->order = order;
+}
+
+
+static int
+compare_entries_by_order (gconstpointer a, gconstpointer b)
+{
+  const PhocSpatialIndexEntry *entry_a = *(PhocSpatialIndexEntry **)a;
+  const PhocSpatialIndexEntry *entry_b = *(PhocSpatialIndexEntry **)b;
+
+  if (entry_a->order == entry_b->order)
+    return 0;
+
+  return entry_a->order > entry_b->order ? -1 : 1;
+}
+
+/**
+ * phoc_spatial_index_query:
+ * @self: The spatial index
+ * @x: The x coordinate
+ * @y: The y coordinate
+ * @results: (element-type gpointer): Array the found items are appended to
+ *
+ * Looks up the items whose bounding box contains the given position
+ * and appends them to `results` ordered by descending order.
+ */
+void
+phoc_spatial_index_query (PhocSpatialIndex *self, double x, double y, GPtrArray *results)
+{
+  gint64 key;
+  GPtrArray *cell;
+  guint first;
+
+  g_assert (PHOC_IS_SPATIAL_INDEX (self));
+  g_assert (results);
+
+  first = results->len;
+  key = cell_key (cell_coord (floor (x)), cell_coord (floor (y)));
+  cell = g_hash_table_lookup (self->cells, &key);
+
+  for (guint i = 0; cell && i < cell->len; i++) {
+    PhocSpatialIndexEntry *entry = g_ptr_array_index (cell, i);
+
+    if (wlr_box_contains_point (&entry->box, x, y))
+      g_ptr_array_add (results, entry);
+  }
+
+  for (guint i = 0; i < self->large->len; i++) {
+    PhocSpatialIndexEntry *entry = g_ptr_array_index (self->large, i);
+
+    if (wlr_box_contains_point (&entry->box, x, y))
+      g_ptr_array_add (results, entry);
+  }
+
+  if (results->len - first > 1) {
+    /* Only sort the newly added entries */
+    qsort (&results->pdata[first], results->len - first, sizeof (gpointer),
+           compare_entries_by_order);
+  }
+
+  for (guint i = first; i < results->len; i++) {
+    PhocSpatialIndexEntry *entry = g_ptr_array_index (results, i);
+
+    results->pdata[i] = entry->item;
+  }
+}
+
+/**
+ * phoc_spatial_index_get_n_items:
+ * @self: The spatial index
+ *
+ * Gets the number of items in the index.
+ *
+ * Returns: The number of items
+ */
+guint
+phoc_spatial_index_get_n_items (PhocSpatialIndex *self)
+{
+  g_assert (PHOC_IS_SPATIAL_INDEX (self));
+
+  return g_hash_table_size (self->entries);
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <wlr/util/box.h>
+
+G_BEGIN_DECLS
+
+#define PHOC_TYPE_SPATIAL_INDEX (phoc_spatial_index_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhocSpatialIndex, phoc_spatial_index, PHOC, SPATIAL_INDEX, GObject)
+
+PhocSpatialIndex   *phoc_spatial_index_new         (void);
+gboolean            phoc_spatial_index_update      (PhocSpatialIndex     *self,
+                                                    gpointer              item,
+                                                    const struct wlr_box *box);
+gboolean            phoc_spatial_index_remove      (PhocSpatialIndex     *self,
+                                                    gpointer              item);
+void                phoc_spatial_index_set_order   (PhocSpatialIndex     *self,
+                                                    gpointer              item,
+                                                    guint                 order);
+void                phoc_spatial_index_query       (PhocSpatialIndex     *self,
+                                                    double                x,
+                                                    double                y,
+                                                    GPtrArray            *results);
+guint               phoc_spatial_index_get_n_items (PhocSpatialIndex     *self);
+
+G_END_DECLS
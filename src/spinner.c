@@ -20,6 +20,7 @@
 #include "render-private.h"
 
 #include <cairo.h>
+#include <math.h>
 
 enum {
   PROP_0,
@@ -50,11 +51,24 @@ static GParamSpec *props[PROP_LAST_PROP];
  * (IDLE_DISTANCE + EXTEND_DISTANCE + CONTRACT_DISTANCE - OVERLAP_DISTANCE) * k,
  * where k is an integer */
 #define N_CYCLES 53
+/* The arc's start and length are quantized to this many steps per full
+ * turn so each state can be drawn once into a sprite atlas. Must be a
+ * multiple of 4 as the atlas only holds a quarter turn of start positions,
+ * the others are reached by transforming the sprite. */
+#define SPRITE_STEPS 48
+#define SPRITE_ANGLE_STEP (2.0 * G_PI / SPRITE_STEPS)
+#define SPRITE_COLS (SPRITE_STEPS / 4)
+/* Enough to hold arcs up to MAX_ARC_LENGTH */
+#define SPRITE_ROWS 23
 
 /**
  * PhocSpinner:
  *
  * An animated spinner, used to represent indeterminate progress. It is rendered as a [type@Bling].
+ *
+ * All states of the spinner are drawn once into a sprite atlas when it
+ * is first mapped so animating it only picks the matching sprite
+ * rather than rasterizing and uploading the arc on every frame.
  */
 struct _PhocSpinner {
   GObject             parent;
@@ -66,8 +80,12 @@ struct _PhocSpinner {
   PhocTimedAnimation *animation;
   PhocPropertyEaser  *easer;
   float               angle;
-  PhocCairoTexture   *texture;
-  gboolean            redraw_spinner; /* set whenever angle changes */
+  gboolean            mapped;
+  PhocCairoTexture   *sprites;
+  int                 sprite_size;
+  /* The sprite matching the current angle */
+  int                 sprite_start;
+  int                 sprite_length;
 };
 
 static void bling_interface_init (PhocBlingInterface *iface);
@@ -157,10 +175,24 @@ get_arc_end (double angle)
 
 
 static void
-draw_spinner (cairo_t *cr, double base_angle, double size)
+get_sprite (double base_angle, int *start, int *length)
+{
+  double start_angle, end_angle, arc_length;
+
+  start_angle = normalize_angle (base_angle + get_arc_start (base_angle) + START_ANGLE);
+  end_angle = normalize_angle (base_angle + get_arc_end (base_angle) + START_ANGLE);
+  /* The arc is drawn in negative direction from start to end */
+  arc_length = normalize_angle (start_angle - end_angle);
+
+  *start = (int)round (start_angle / SPRITE_ANGLE_STEP) % SPRITE_STEPS;
+  *length = CLAMP ((int)round (arc_length / SPRITE_ANGLE_STEP), 0, SPRITE_ROWS - 1);
+}
+
+
+static void
+draw_spinner (cairo_t *cr, double start_angle, double end_angle, double size)
 {
   double radius, line_width;
-  double start_angle, end_angle;
 
   cairo_save (cr);
   cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
@@ -184,12 +216,6 @@ draw_spinner (cairo_t *cr, double base_angle, double size)
   cairo_stroke (cr);
 
   /* animated arc */
-  start_angle = base_angle + get_arc_start (base_angle) + START_ANGLE;
-  end_angle = base_angle + get_arc_end (base_angle) + START_ANGLE;
-
-  start_angle = normalize_angle (start_angle);
-  end_angle = normalize_angle (end_angle);
-
   cairo_set_source_rgba (cr, 1.0, 1.0, 1.0, .55);
   cairo_arc_negative (cr, 0, 0, radius - line_width / 2, start_angle, end_angle);
   cairo_stroke (cr);
@@ -198,6 +224,15 @@ draw_spinner (cairo_t *cr, double base_angle, double size)
 }
 
 
+/* Transforms rotating a sprite by a multiple of a quarter turn clockwise */
+static const enum wl_output_transform quadrant_transforms[] = {
+  WL_OUTPUT_TRANSFORM_NORMAL,
+  WL_OUTPUT_TRANSFORM_270,
+  WL_OUTPUT_TRANSFORM_180,
+  WL_OUTPUT_TRANSFORM_90,
+};
+
+
 static void
 bling_render (PhocBling *bling, PhocRenderContext *ctx)
 {
@@ -205,8 +240,13 @@ bling_render (PhocBling *bling, PhocRenderContext *ctx)
   struct wlr_render_texture_options options;
   struct wlr_box box = bling_get_box (bling);
   pixman_region32_t damage;
-  struct wlr_texture *texture = phoc_cairo_texture_get_texture (self->texture);
+  struct wlr_texture *texture;
+  int col, quadrant, size = self->sprite_size;
 
+  if (!self->mapped)
+    return;
+
+  texture = phoc_cairo_texture_get_texture (self->sprites);
   if (!texture)
     return;
 
@@ -220,20 +260,52 @@ bling_render (PhocBling *bling, PhocRenderContext *ctx)
     return;
   }
 
-  /* only redraw spinner if needed (angle property was changed since last render) */
-  if (self->redraw_spinner) {
-    draw_spinner (phoc_cairo_texture_get_context (self->texture), self->angle, box.width);
-    phoc_cairo_texture_update (self->texture);
-    self->redraw_spinner = false;
-  }
+  col = self->sprite_start % SPRITE_COLS;
+  quadrant = self->sprite_start / SPRITE_COLS;
 
   options = (struct wlr_render_texture_options) {
-    .texture = texture,
-    .dst_box = box,
-    .clip    = &damage,
+    .texture   = texture,
+    .src_box   = { col * size, self->sprite_length * size, size, size },
+    .dst_box   = box,
+    .transform = quadrant_transforms[quadrant],
+    .clip      = &damage,
   };
 
   wlr_render_pass_add_texture (ctx->render_pass, &options);
+  pixman_region32_fini (&damage);
+}
+
+
+static gboolean
+draw_sprites (PhocSpinner *self)
+{
+  cairo_t *cr = phoc_cairo_texture_get_context (self->sprites);
+  int size = self->sprite_size;
+
+  if (!cr) {
+    g_warning ("No Cairo context, cannot render spinner\n");
+    return FALSE;
+  }
+
+  cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
+
+  for (int row = 0; row < SPRITE_ROWS; row++) {
+    for (int col = 0; col < SPRITE_COLS; col++) {
+      double start_angle = col * SPRITE_ANGLE_STEP;
+      double length = MAX (row * SPRITE_ANGLE_STEP, MIN_ARC_LENGTH);
+
+      cairo_save (cr);
+      cairo_translate (cr, col * size, row * size);
+      cairo_rectangle (cr, 0, 0, size, size);
+      cairo_clip (cr);
+      draw_spinner (cr, start_angle, start_angle - length, size);
+      cairo_restore (cr);
+    }
+  }
+
+  phoc_cairo_texture_update (self->sprites);
+  return TRUE;
 }
 
 
@@ -249,22 +321,23 @@ bling_map (PhocBling *bling)
   if (output)
     size = size * phoc_output_get_scale (output);
 
-  cairo_t *cr;
-
-  if (self->texture)
+  if (self->mapped)
     return;
 
-  self->texture = phoc_cairo_texture_new (size, size);
-  cr = phoc_cairo_texture_get_context (self->texture);
-
-  if (!cr) {
-    g_warning ("No Cairo context, cannot render spinner\n");
-    return;
+  /* Sprites are kept across unmaps unless the output scale changed */
+  if (self->sprites && self->sprite_size != size)
+    g_clear_object (&self->sprites);
+
+  if (!self->sprites) {
+    self->sprite_size = size;
+    self->sprites = phoc_cairo_texture_new (SPRITE_COLS * size, SPRITE_ROWS * size);
+    if (!draw_sprites (self)) {
+      g_clear_object (&self->sprites);
+      return;
+    }
   }
 
-  cairo_set_antialias (cr, CAIRO_ANTIALIAS_FAST);
-  cairo_set_line_cap (cr, CAIRO_LINE_CAP_ROUND);
-
+  self->mapped = TRUE;
   phoc_bling_damage_box (PHOC_BLING (self));
   phoc_timed_animation_play (self->animation);
 }
@@ -275,10 +348,10 @@ bling_unmap (PhocBling *bling)
 {
   PhocSpinner *self = PHOC_SPINNER (bling);
 
-  if (!self->texture)
+  if (!self->mapped)
     return;
 
-  g_clear_object (&self->texture);
+  self->mapped = FALSE;
 
   phoc_bling_damage_box (PHOC_BLING (self));
   phoc_timed_animation_reset (self->animation);
@@ -290,7 +363,7 @@ bling_is_mapped (PhocBling *bling)
 {
   PhocSpinner *self = PHOC_SPINNER (bling);
 
-  return self->texture != NULL;
+  return self->mapped;
 }
 
 
@@ -305,6 +378,28 @@ bling_interface_init (PhocBlingInterface *iface)
 }
 
 
+static void
+set_angle (PhocSpinner *self, float angle)
+{
+  int start, length;
+
+  if (G_APPROX_VALUE (self->angle, angle, FLT_EPSILON))
+    return;
+
+  self->angle = angle;
+
+  /* Only damage if a different sprite needs to be shown */
+  get_sprite (angle, &start, &length);
+  if (start != self->sprite_start || length != self->sprite_length) {
+    self->sprite_start = start;
+    self->sprite_length = length;
+    phoc_bling_damage_box (PHOC_BLING (self));
+  }
+
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ANGLE]);
+}
+
+
 static void
 phoc_spinner_set_property (GObject      *object,
                            guint         property_id,
@@ -331,9 +426,7 @@ phoc_spinner_set_property (GObject      *object,
     self->animatable = g_value_get_object (value);
     break;
   case PROP_ANGLE:
-    self->angle = g_value_get_float (value);
-    phoc_bling_damage_box (PHOC_BLING (self));
-    self->redraw_spinner = true;
+    set_angle (self, g_value_get_float (value));
     break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -379,6 +472,7 @@ phoc_spinner_finalize (GObject *object)
   PhocSpinner *self = PHOC_SPINNER (object);
 
   phoc_bling_unmap (PHOC_BLING (self));
+  g_clear_object (&self->sprites);
   g_clear_object (&self->easer);
   g_clear_object (&self->animation);
 
@@ -454,7 +548,7 @@ phoc_spinner_class_init (PhocSpinnerClass *klass)
                         0,
                         N_CYCLES * G_PI * 2,
                         0.0f,
-                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+                        G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
 
   /**
    * PhocSpinner:size:
@@ -469,6 +563,8 @@ phoc_spinner_class_init (PhocSpinnerClass *klass)
                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
 
   g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+  /* Eased on every frame while spinning */
+  phoc_property_easer_install_setter (props[PROP_ANGLE], (PhocPropertyEaserSetter)set_angle);
 }
 
 
@@ -482,6 +578,7 @@ phoc_spinner_init (PhocSpinner *self)
   phoc_property_easer_set_props (self->easer,
                                  "angle", 0.0, N_CYCLES * G_PI * 2,
                                  NULL);
+  get_sprite (self->angle, &self->sprite_start, &self->sprite_length);
 }
 
 
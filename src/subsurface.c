@@ -10,6 +10,7 @@
 
 #include "phoc-config.h"
 
+#include "cursor.h"
 #include "subsurface.h"
 #include "surface.h"
 
@@ -111,6 +112,8 @@ handle_parent_commit (struct wl_listener *listener, void *data)
   phoc_view_child_get_pos (PHOC_VIEW_CHILD (self), &sx, &sy);
 
   moved = (self->previous.x != sx || self->previous.y != sy);
+  if (moved)
+    phoc_touch_point_invalidate_transforms ();
 
   reordered = (self->previous.prev != wlr_subsurface->current.link.prev ||
                self->previous.next != wlr_subsurface->current.link.next);
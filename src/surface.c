@@ -10,6 +10,8 @@
 
 #include "phoc-config.h"
 
+#include "output.h"
+#include "server.h"
 #include "surface.h"
 
 /**
@@ -30,6 +32,8 @@ struct _PhocSurface {
 
   struct wlr_surface *wlr_surface;
   pixman_region32_t   damage;
+  guint               commit_seq;
+  PhocView           *view; /* unowned, set while mapped as a view */
 
   struct wl_listener  commit;
   struct wl_listener  destroy;
@@ -43,6 +47,17 @@ handle_commit (struct wl_listener *listener, void *data)
   PhocSurface *self = wl_container_of (listener, self, commit);
   struct wlr_surface *wlr_surface = self->wlr_surface;
 
+  self->commit_seq++;
+
+  if (!wl_list_empty (&wlr_surface->current.frame_callback_list)) {
+    PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+    PhocOutput *output;
+
+    /* Each output decides whether the surface is visible on it */
+    wl_list_for_each (output, &desktop->outputs, link)
+      phoc_output_add_frame_done_surface (output, self);
+  }
+
   if (wlr_surface->WLR_PRIVATE.previous.width == wlr_surface->current.width &&
       wlr_surface->WLR_PRIVATE.previous.height == wlr_surface->current.height &&
       wlr_surface->current.dx == 0 && wlr_surface->current.dy ==  0)
@@ -65,6 +80,11 @@ handle_destroy (struct wl_listener *listener, void *data)
 
   g_debug ("Surface %p destroyed", self->wlr_surface);
 
+  /* Outputs might still hold a ref until the next frame */
+  wl_list_remove (&self->commit.link);
+  wl_list_remove (&self->destroy.link);
+  self->wlr_surface = NULL;
+
   g_object_unref (self);
 }
 
@@ -131,10 +151,11 @@ phoc_surface_finalize (GObject *object)
 
   pixman_region32_fini (&self->damage);
 
-  wl_list_remove (&self->commit.link);
-  wl_list_remove (&self->destroy.link);
-
-  self->wlr_surface = NULL;
+  if (self->wlr_surface) {
+    wl_list_remove (&self->commit.link);
+    wl_list_remove (&self->destroy.link);
+    self->wlr_surface = NULL;
+  }
 
   G_OBJECT_CLASS (phoc_surface_parent_class)->finalize (object);
 }
@@ -171,6 +192,24 @@ phoc_surface_new (struct wlr_surface *surface)
 }
 
 
+/**
+ * phoc_surface_get_wlr_surface:
+ * @self: The surface
+ *
+ * Get the underlying `wlr_surface`.
+ *
+ * Returns: (transfer none)(nullable): The wlr_surface or `NULL` if it
+ *   was already destroyed.
+ */
+struct wlr_surface *
+phoc_surface_get_wlr_surface (PhocSurface *self)
+{
+  g_assert (PHOC_IS_SURFACE (self));
+
+  return self->wlr_surface;
+}
+
+
 const pixman_region32_t *
 phoc_surface_get_damage (PhocSurface *self)
 {
@@ -188,6 +227,24 @@ phoc_surface_clear_damage (PhocSurface *self)
   pixman_region32_clear (&self->damage);
 }
 
+/**
+ * phoc_surface_get_commit_seq:
+ * @self: The surface
+ *
+ * Gets a sequence number that changes with every commit. This allows
+ * to check whether anything derived from the surface's contents is
+ * still current.
+ *
+ * Returns: The commit sequence number
+ */
+guint
+phoc_surface_get_commit_seq (PhocSurface *self)
+{
+  g_assert (PHOC_IS_SURFACE (self));
+
+  return self->commit_seq;
+}
+
 /**
  * phoc_surface_add_damage:
  * @self: The to be damaged surface
@@ -227,3 +284,38 @@ phoc_surface_add_damage_box (PhocSurface *self, struct wlr_box *box)
   phoc_surface_add_damage (self, &damage);
   pixman_region32_fini (&damage);
 }
+
+
+/**
+ * phoc_surface_set_view:
+ * @self: The surface
+ * @view: (nullable): The view
+ *
+ * Sets the view that uses this surface as its root surface. This
+ * allows to look up the view of a surface without walking the view
+ * stack. Views set this on map and unset it on unmap.
+ */
+void
+phoc_surface_set_view (PhocSurface *self, PhocView *view)
+{
+  g_assert (PHOC_IS_SURFACE (self));
+
+  self->view = view;
+}
+
+/**
+ * phoc_surface_get_view:
+ * @self: The surface
+ *
+ * Gets the view that uses this surface as its root surface.
+ *
+ * Returns: (transfer none)(nullable): The view or %NULL if the surface
+ *   isn't the root surface of a mapped view.
+ */
+PhocView *
+phoc_surface_get_view (PhocSurface *self)
+{
+  g_assert (PHOC_IS_SURFACE (self));
+
+  return self->view;
+}
@@ -16,10 +16,16 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (PhocSurface, phoc_surface, PHOC, SURFACE, GObject)
 
+typedef struct _PhocView PhocView;
+
 PhocSurface             *phoc_surface_new (struct wlr_surface *self);
+struct wlr_surface      *phoc_surface_get_wlr_surface (PhocSurface *self);
 const pixman_region32_t *phoc_surface_get_damage (PhocSurface *self);
 void                     phoc_surface_add_damage (PhocSurface *self, pixman_region32_t *damage);
 void                     phoc_surface_add_damage_box (PhocSurface *self, struct wlr_box *box);
 void                     phoc_surface_clear_damage (PhocSurface *self);
+guint                    phoc_surface_get_commit_seq (PhocSurface *self);
+void                     phoc_surface_set_view (PhocSurface *self, PhocView *view);
+PhocView                *phoc_surface_get_view (PhocSurface *self);
 
 G_END_DECLS
@@ -25,6 +25,9 @@
 G_DEFINE_BOXED_TYPE (PhocTouchPoint, phoc_touch_point, phoc_touch_point_copy,
                      phoc_touch_point_destroy)
 
+/* Bumped whenever surfaces might have moved in the layout */
+static guint transform_serial = 1;
+
 static void
 color_hsv_to_rgb (struct wlr_render_color *color)
 {
@@ -128,7 +131,10 @@ phoc_touch_point_destroy (PhocTouchPoint *self)
 PhocTouchPoint *
 phoc_touch_point_copy (PhocTouchPoint *self)
 {
-  return phoc_touch_point_new (self->touch_id, self->lx, self->ly);
+  PhocTouchPoint *copy = phoc_touch_point_new (self->touch_id, self->lx, self->ly);
+
+  copy->transform = self->transform;
+  return copy;
 }
 
 
@@ -146,6 +152,86 @@ phoc_touch_point_update (PhocTouchPoint *self, double lx, double ly)
 }
 
 
+/**
+ * phoc_touch_point_set_transform:
+ * @self: The touch point
+ * @surface: The surface the touch point interacts with
+ * @scale: The scale of the surface in the layout
+ * @x: The surface's x position in layout coordinates divided by @scale
+ * @y: The surface's y position in layout coordinates divided by @scale
+ *
+ * Caches the transformation of layout coordinates into @surface local
+ * coordinates so subsequent motion doesn't need to figure out where
+ * @surface is. The cache stays valid until
+ * [func@TouchPoint.invalidate_transforms] is invoked.
+ */
+void
+phoc_touch_point_set_transform (PhocTouchPoint     *self,
+                                struct wlr_surface *surface,
+                                double              scale,
+                                double              x,
+                                double              y)
+{
+  g_assert (self);
+  g_assert (scale > 0.0);
+
+  self->transform.surface = surface;
+  self->transform.scale = scale;
+  self->transform.x = x;
+  self->transform.y = y;
+  self->transform.serial = transform_serial;
+}
+
+/**
+ * phoc_touch_point_get_surface_coords:
+ * @self: The touch point
+ * @surface: The surface to get the coordinates for
+ * @sx: (out): The surface local x coordinate
+ * @sy: (out): The surface local y coordinate
+ *
+ * Transforms the touch point's position into @surface local
+ * coordinates using the cached transform.
+ *
+ * Returns: %TRUE if the cached transform is valid for @surface,
+ *   otherwise %FALSE and the out parameters are left untouched.
+ */
+gboolean
+phoc_touch_point_get_surface_coords (PhocTouchPoint     *self,
+                                     struct wlr_surface *surface,
+                                     double             *sx,
+                                     double             *sy)
+{
+  g_assert (self);
+
+  if (self->transform.surface == NULL || self->transform.surface != surface)
+    return FALSE;
+
+  if (self->transform.serial != transform_serial)
+    return FALSE;
+
+  *sx = self->lx / self->transform.scale - self->transform.x;
+  *sy = self->ly / self->transform.scale - self->transform.y;
+  return TRUE;
+}
+
+/**
+ * phoc_touch_point_invalidate_transforms:
+ *
+ * Invalidates the cached transforms of all touch points. Invoke this
+ * whenever a surface moves in the layout, e.g. when a view is moved,
+ * layer surfaces are arranged or a subsurface's position got
+ * committed.
+ */
+void
+phoc_touch_point_invalidate_transforms (void)
+{
+  transform_serial++;
+  /* Skip 0 so zeroed touch points are never valid */
+  if (G_UNLIKELY (transform_serial == 0))
+    transform_serial = 1;
+}
+
+
 void
 phoc_touch_point_render (PhocTouchPoint *self, PhocRenderContext *ctx)
 {
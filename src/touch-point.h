@@ -12,11 +12,21 @@ G_BEGIN_DECLS
 
 #define PHOC_TYPE_TOUCH_POINT (phoc_touch_point_get_type ())
 
+struct wlr_surface;
+
 typedef struct PhocTouchPoint {
   int    touch_id;
 
   double lx;
   double ly;
+
+  /* Layout to surface local coordinates of the touched surface */
+  struct {
+    struct wlr_surface *surface;
+    double              scale;
+    double              x, y;
+    guint               serial;
+  } transform;
 } PhocTouchPoint;
 
 GType           phoc_touch_point_get_type (void);
@@ -27,6 +37,17 @@ void            phoc_touch_point_destroy (PhocTouchPoint *self);
 
 void            phoc_touch_point_update (PhocTouchPoint *self, double lx, double ly);
 
+void            phoc_touch_point_set_transform (PhocTouchPoint     *self,
+                                                struct wlr_surface *surface,
+                                                double              scale,
+                                                double              x,
+                                                double              y);
+gboolean        phoc_touch_point_get_surface_coords (PhocTouchPoint     *self,
+                                                     struct wlr_surface *surface,
+                                                     double             *sx,
+                                                     double             *sy);
+void            phoc_touch_point_invalidate_transforms (void);
+
 void            phoc_touch_point_render (PhocTouchPoint    *self,
                                          PhocRenderContext *ctx);
 void            phoc_touch_point_damage (PhocTouchPoint *self);
@@ -12,7 +12,9 @@
 #define G_LOG_DOMAIN "phoc-utils"
 
 #include "output.h"
+#include "server.h"
 #include "utils.h"
+#include "view.h"
 
 #include <wlr/types/wlr_fractional_scale_v1.h>
 
@@ -139,6 +141,42 @@ phoc_utils_scale_box (struct wlr_box *box, float scale)
   box->y = round (box->y * scale);
 }
 
+/**
+ * phoc_utils_scale_opaque_region:
+ * @dst: (inout): The region to add the scaled region to
+ * @opaque: The opaque region to scale
+ * @x: x offset to apply before scaling
+ * @y: y offset to apply before scaling
+ * @scale: The scale to apply
+ *
+ * Translates the opaque region by `x,y`, scales it and adds the result
+ * to `dst`. In contrast to `wlr_region_scale` we round inwards so
+ * partially covered pixels aren't considered opaque.
+ */
+void
+phoc_utils_scale_opaque_region (pixman_region32_t       *dst,
+                                const pixman_region32_t *opaque,
+                                int                      x,
+                                int                      y,
+                                float                    scale)
+{
+  const pixman_box32_t *rects;
+  int n_rects;
+
+  rects = pixman_region32_rectangles ((pixman_region32_t *)opaque, &n_rects);
+  for (int i = 0; i < n_rects; i++) {
+    int x1 = ceil ((x + rects[i].x1) * scale);
+    int y1 = ceil ((y + rects[i].y1) * scale);
+    int x2 = floor ((x + rects[i].x2) * scale);
+    int y2 = floor ((y + rects[i].y2) * scale);
+
+    if (x2 <= x1 || y2 <= y1)
+      continue;
+
+    pixman_region32_union_rect (dst, dst, x1, y1, x2 - x1, y2 - y1);
+  }
+}
+
 /**
  * phoc_util_is_box_damaged:
  * @box: The box to check
@@ -175,6 +213,154 @@ phoc_utils_is_damaged (const struct wlr_box    *box,
   return !pixman_region32_empty (out_damage);
 }
 
+/* How many of the most recently merged boxes a rectangle is checked against */
+#define SIMPLIFY_MERGE_WINDOW 8
+/* Overdraw tolerance (relative to the covered area) at which we stop
+ * merging and use the bounding box */
+#define SIMPLIFY_MAX_TOLERANCE 64.0
+
+static guint64
+box_area (const pixman_box32_t *box)
+{
+  return (guint64)(box->x2 - box->x1) * (box->y2 - box->y1);
+}
+
+
+static int
+merge_rects (const pixman_box32_t *rects,
+             int                   n_rects,
+             pixman_box32_t       *merged,
+             guint64              *covered,
+             float                 max_overdraw)
+{
+  int n_merged = 0;
+
+  for (int i = 0; i < n_rects; i++) {
+    guint64 area = box_area (&rects[i]);
+    guint64 best_overdraw = G_MAXUINT64;
+    pixman_box32_t best_box;
+    int best = -1;
+
+    /* Rectangles are sorted in bands so nearby boxes are usually merged last */
+    for (int j = MAX (n_merged - SIMPLIFY_MERGE_WINDOW, 0); j < n_merged; j++) {
+      pixman_box32_t box = {
+        .x1 = MIN (merged[j].x1, rects[i].x1),
+        .y1 = MIN (merged[j].y1, rects[i].y1),
+        .x2 = MAX (merged[j].x2, rects[i].x2),
+        .y2 = MAX (merged[j].y2, rects[i].y2),
+      };
+      guint64 used = covered[j] + area;
+      guint64 overdraw = box_area (&box) > used ? box_area (&box) - used : 0;
+
+      if (overdraw <= max_overdraw * used && overdraw < best_overdraw) {
+        best = j;
+        best_box = box;
+        best_overdraw = overdraw;
+      }
+    }
+
+    if (best >= 0) {
+      merged[best] = best_box;
+      covered[best] += area;
+    } else {
+      merged[n_merged] = rects[i];
+      covered[n_merged] = area;
+      n_merged++;
+    }
+  }
+
+  return n_merged;
+}
+
+/**
+ * phoc_utils_simplify_region:
+ * @region: The region to simplify
+ * @max_rects: The maximum number of rectangles or `0` for no limit
+ * @max_overdraw: The acceptable overdraw relative to the region's area
+ *
+ * Reduces the number of rectangles in @region so that clipping
+ * against it stays cheap. If the bounding box adds no more than
+ * @max_overdraw of the region's area the region is replaced by it.
+ * Otherwise, if there are more than @max_rects rectangles,
+ * neighbouring rectangles are merged into their bounding boxes with
+ * increasing overdraw until the budget is met. The result always
+ * covers the original region.
+ *
+ * Returns: `TRUE` if the region was simplified
+ */
+gboolean
+phoc_utils_simplify_region (pixman_region32_t *region, guint max_rects, float max_overdraw)
+{
+  g_autofree pixman_box32_t *merged = NULL;
+  g_autofree guint64 *covered = NULL;
+  const pixman_box32_t *rects;
+  pixman_box32_t extents;
+  int n_rects, n_merged;
+  guint64 area = 0;
+  float tolerance;
+
+  rects = pixman_region32_rectangles (region, &n_rects);
+  if (n_rects <= 1)
+    return FALSE;
+
+  for (int i = 0; i < n_rects; i++)
+    area += box_area (&rects[i]);
+
+  extents = *pixman_region32_extents (region);
+  if (box_area (&extents) - area <= max_overdraw * area) {
+    pixman_region32_reset (region, &extents);
+    return TRUE;
+  }
+
+  if (max_rects == 0 || (guint)n_rects <= max_rects)
+    return FALSE;
+
+  merged = g_new (pixman_box32_t, n_rects);
+  covered = g_new (guint64, n_rects);
+  tolerance = MAX (max_overdraw, 0.125);
+  do {
+    n_merged = merge_rects (rects, n_rects, merged, covered, tolerance);
+    tolerance *= 2;
+  } while ((guint)n_merged > max_rects && tolerance <= SIMPLIFY_MAX_TOLERANCE);
+
+  if ((guint)n_merged <= max_rects) {
+    pixman_region32_t simplified;
+
+    /* Merged boxes can overlap which splits them up again */
+    pixman_region32_init_rects (&simplified, merged, n_merged);
+    if (pixman_region32_n_rects (&simplified) <= max_rects) {
+      pixman_region32_copy (region, &simplified);
+      pixman_region32_fini (&simplified);
+      return TRUE;
+    }
+    pixman_region32_fini (&simplified);
+  }
+
+  pixman_region32_reset (region, &extents);
+  return TRUE;
+}
+
+
+/*
+ * Views scaled to fit the output can render at the scaled size right
+ * away rather than having the compositor scale them down.
+ */
+static float
+get_surface_scale_factor (struct wlr_surface *surface)
+{
+  PhocConfig *config = phoc_server_get_config (phoc_server_get_default ());
+  PhocView *view;
+
+  if (!config->scale_to_fit_prescale)
+    return 1.0;
+
+  view = phoc_view_from_wlr_surface (wlr_surface_get_root_surface (surface));
+  if (!view)
+    return 1.0;
+
+  return phoc_view_get_scale (view);
+}
+
 
 void
 phoc_utils_wlr_surface_update_scales (struct wlr_surface *surface)
@@ -187,6 +373,8 @@ phoc_utils_wlr_surface_update_scales (struct wlr_surface *surface)
       scale = surface_output->output->scale;
   }
 
+  scale *= get_surface_scale_factor (surface);
+
   wlr_fractional_scale_v1_notify_scale (surface, scale);
   wlr_surface_set_preferred_buffer_scale (surface, ceil (scale));
 }
@@ -39,10 +39,18 @@ void       phoc_utils_fix_transform         (enum wl_output_transform *transform
 float      phoc_utils_compute_scale         (int32_t phys_width, int32_t phys_height,
                                              int32_t width, int32_t height);
 void       phoc_utils_scale_box             (struct wlr_box *box, float scale);
+void       phoc_utils_scale_opaque_region   (pixman_region32_t       *dst,
+                                             const pixman_region32_t *opaque,
+                                             int                      x,
+                                             int                      y,
+                                             float                    scale);
 gboolean   phoc_utils_is_damaged            (const struct wlr_box    *box,
                                              const pixman_region32_t *damage,
                                              const struct wlr_box    *clip_box,
                                              pixman_region32_t       *out_damage);
+gboolean   phoc_utils_simplify_region       (pixman_region32_t       *region,
+                                             guint                    max_rects,
+                                             float                    max_overdraw);
 
 void       phoc_utils_wlr_surface_update_scales (struct wlr_surface *surface);
 void       phoc_utils_wlr_surface_enter_output  (struct wlr_surface *wlr_surface,
@@ -5,8 +5,12 @@
 #ifndef _POSIX_C_SOURCE
 #define _POSIX_C_SOURCE 200809L
 #endif
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <wlr/types/wlr_alpha_modifier_v1.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_subcompositor.h>
 #include <wlr/types/wlr_output_layout.h>
 
@@ -20,6 +24,7 @@
 #include "seat.h"
 #include "server.h"
 #include "subsurface.h"
+#include "surface.h"
 #include "utils.h"
 #include "timed-animation.h"
 #include "view-child-private.h"
@@ -45,6 +50,7 @@ static GParamSpec *props[PROP_LAST_PROP];
 
 enum {
   SURFACE_DESTROY,
+  CONTENT_DAMAGED,
   N_SIGNALS
 };
 static guint signals[N_SIGNALS] = { 0 };
@@ -62,8 +68,16 @@ typedef struct _PhocViewPrivate {
   PhocViewState  state;
   PhocViewTileDirection tile_direction;
   gboolean       always_on_top;
-  gboolean       visibility;
+  guint32        visible_outputs;
+  GArray        *opacity; /* SurfaceOpacity, see check_opacity() */
   guint          suspend_timer_id;
+  guint          hidden_frame_timer_id;
+  guint          commit_seq;
+  /* Content damage not yet consumed, in root surface coordinates */
+  pixman_region32_t content_damage;
+  gboolean       content_damage_whole;
+  /* Content damage is only tracked while someone consumes it */
+  guint          content_consumers;
 
   PhocOutput    *fullscreen_output;
 
@@ -472,6 +486,67 @@ phoc_view_get_deco_part (PhocView *self, double sx, double sy)
 }
 
 
+typedef struct {
+  int x1, y1, x2, y2;
+} ViewBoundsData;
+
+
+static void
+view_bounds_iterator (struct wlr_surface *wlr_surface, int sx, int sy, void *user_data)
+{
+  ViewBoundsData *data = user_data;
+
+  data->x1 = MIN (data->x1, sx);
+  data->y1 = MIN (data->y1, sy);
+  data->x2 = MAX (data->x2, sx + wlr_surface->current.width);
+  data->y2 = MAX (data->y2, sy + wlr_surface->current.height);
+}
+
+/**
+ * phoc_view_get_input_bounds:
+ * @self: The view
+ * @bounds: (out): The bounds
+ *
+ * Gets a box in layout coordinates that contains all the positions
+ * where the view can receive input. This includes the view's popups,
+ * subsurfaces and server side decorations.
+ */
+void
+phoc_view_get_input_bounds (PhocView *self, struct wlr_box *bounds)
+{
+  PhocViewPrivate *priv;
+  ViewBoundsData data = { G_MAXINT, G_MAXINT, G_MININT, G_MININT };
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  *bounds = (struct wlr_box){ 0 };
+  if (!phoc_view_is_mapped (self))
+    return;
+
+  phoc_view_for_each_surface (self, view_bounds_iterator, &data);
+  if (data.x1 > data.x2 || data.y1 > data.y2)
+    return;
+
+  if (priv->deco) {
+    PhocBox deco_box = phoc_bling_get_box (PHOC_BLING (priv->deco));
+    struct wlr_box box;
+
+    phoc_view_get_box (self, &box);
+    data.x1 -= box.x - deco_box.x;
+    data.y1 -= box.y - deco_box.y;
+    data.x2 += (deco_box.x + deco_box.width) - (box.x + box.width);
+    data.y2 += (deco_box.y + deco_box.height) - (box.y + box.height);
+  }
+
+  /* Same transform as in hit testing: sx = lx / scale - box.x */
+  bounds->x = floor ((self->box.x + data.x1) * priv->scale);
+  bounds->y = floor ((self->box.y + data.y1) * priv->scale);
+  bounds->width = ceil ((self->box.x + data.x2) * priv->scale) - bounds->x + 1;
+  bounds->height = ceil ((self->box.y + data.y2) * priv->scale) - bounds->y + 1;
+}
+
+
 static void
 surface_send_enter_iterator (struct wlr_surface *wlr_surface, int x, int y, void *data)
 {
@@ -499,6 +574,8 @@ view_update_output (PhocView *view, const struct wlr_box *before)
   if (!phoc_view_is_mapped (view))
     return;
 
+  phoc_desktop_update_view_bounds (desktop, view);
+
   struct wlr_box box;
   phoc_view_get_box (view, &box);
 
@@ -552,17 +629,74 @@ phoc_view_move_default (PhocView *view, double x, double y)
 }
 
 
+static void
+send_frame_done_iterator (struct wlr_surface *wlr_surface, int sx, int sy, void *user_data)
+{
+  struct timespec *when = user_data;
+
+  if (!wl_list_empty (&wlr_surface->current.frame_callback_list))
+    wlr_surface_send_frame_done (wlr_surface, when);
+}
+
+
+static gboolean
+on_hidden_frame_timer (gpointer user_data)
+{
+  PhocView *self = user_data;
+  PhocViewPrivate *priv;
+  struct timespec now;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  if (!phoc_view_is_mapped (self)) {
+    priv->hidden_frame_timer_id = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  phoc_view_for_each_surface (self, send_frame_done_iterator, &now);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/*
+ * Hidden views don't get frame callbacks from the outputs. Let them
+ * advance at a low rate so they make progress without drawing at
+ * full rate.
+ */
+static void
+start_hidden_frame_timer (PhocView *self)
+{
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+  PhocConfig *config = phoc_server_get_config (phoc_server_get_default ());
+
+  if (priv->hidden_frame_timer_id || config->hidden_frame_rate == 0)
+    return;
+
+  priv->hidden_frame_timer_id = g_timeout_add (1000 / config->hidden_frame_rate,
+                                               on_hidden_frame_timer,
+                                               self);
+  g_source_set_name_by_id (priv->hidden_frame_timer_id, "[phoc] hidden view frame timer");
+}
+
+
 static void
 on_suspend_timer_expired (gpointer user_data)
 {
   PhocView *self = user_data;
   PhocViewPrivate *priv;
+  PhocConfig *config = phoc_server_get_config (phoc_server_get_default ());
 
   g_assert (PHOC_IS_VIEW (self));
   priv = phoc_view_get_instance_private (self);
 
   priv->suspend_timer_id = 0;
 
+  /* Fully frozen until visible again */
+  if (config->freeze_suspended)
+    g_clear_handle_id (&priv->hidden_frame_timer_id, g_source_remove);
+
   PHOC_VIEW_GET_CLASS (self)->set_suspended (self, TRUE);
 }
 
@@ -580,9 +714,11 @@ phoc_view_set_suspended (PhocView *self, bool suspended)
                                                            on_suspend_timer_expired,
                                                            self);
       g_source_set_name_by_id (priv->suspend_timer_id, "[phoc] surface suspend timer");
+      start_hidden_frame_timer (self);
     }
   } else {
     g_clear_handle_id (&priv->suspend_timer_id, g_source_remove);
+    g_clear_handle_id (&priv->hidden_frame_timer_id, g_source_remove);
     PHOC_VIEW_GET_CLASS (self)->set_suspended (self, FALSE);
   }
 }
@@ -829,6 +965,7 @@ phoc_view_maximize (PhocView *self, PhocOutput *output)
   view_save (self);
 
   priv->state = PHOC_VIEW_STATE_MAXIMIZED;
+  phoc_desktop_invalidate_visibility (phoc_server_get_desktop (phoc_server_get_default ()));
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_STATE]);
 
   view_arrange_maximized (self, output);
@@ -872,6 +1009,7 @@ phoc_view_restore (PhocView *self)
   phoc_view_get_geometry (self, &geom);
 
   priv->state = PHOC_VIEW_STATE_FLOATING;
+  phoc_desktop_invalidate_visibility (phoc_server_get_desktop (phoc_server_get_default ()));
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_STATE]);
 
   if (!wlr_box_empty (&self->saved)) {
@@ -948,12 +1086,15 @@ phoc_view_set_fullscreen (PhocView *view, bool fullscreen, PhocOutput *output)
     phoc_output_force_shell_reveal (output, false);
     priv->fullscreen_output = output;
     phoc_output_damage_whole (output);
+    phoc_desktop_invalidate_visibility (desktop);
   }
 
   if (was_fullscreen && !fullscreen) {
+    PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
     PhocOutput *phoc_output = priv->fullscreen_output;
     priv->fullscreen_output->fullscreen_view = NULL;
     priv->fullscreen_output = NULL;
+    phoc_desktop_invalidate_visibility (desktop);
 
     phoc_output_damage_whole (phoc_output);
 
@@ -974,9 +1115,6 @@ phoc_view_set_fullscreen (PhocView *view, bool fullscreen, PhocOutput *output)
 
     phoc_view_auto_maximize (view);
   }
-
-  phoc_server_set_linux_dmabuf_surface_feedback (phoc_server_get_default (),
-                                                 view, priv->fullscreen_output, fullscreen);
 }
 
 
@@ -1093,6 +1231,7 @@ phoc_view_tile (PhocView *self, PhocViewTileDirection direction, PhocOutput *out
   view_save (self);
 
   priv->state = PHOC_VIEW_STATE_TILED;
+  phoc_desktop_invalidate_visibility (phoc_server_get_desktop (phoc_server_get_default ()));
   priv->tile_direction = direction;
 
   PHOC_VIEW_GET_CLASS (self)->set_maximized (self, false);
@@ -1209,6 +1348,13 @@ munge_app_id (const gchar *app_id)
   return id;
 }
 
+static void
+update_scales_iterator (struct wlr_surface *wlr_surface, int sx, int sy, void *user_data)
+{
+  phoc_utils_wlr_surface_update_scales (wlr_surface);
+}
+
+
 static void
 view_update_scale (PhocView *view)
 {
@@ -1244,8 +1390,14 @@ view_update_scale (PhocView *view)
     priv->scale = 1.0;
   }
 
-  if (priv->scale != oldscale)
+  if (priv->scale != oldscale) {
+    phoc_touch_point_invalidate_transforms ();
     phoc_view_arrange (view, NULL, TRUE);
+    phoc_desktop_update_view_bounds (desktop, view);
+    /* The preferred scale depends on the view's scale too */
+    if (phoc_view_is_mapped (view))
+      phoc_view_for_each_surface (view, update_scales_iterator, NULL);
+  }
 }
 
 
@@ -1265,6 +1417,8 @@ phoc_view_map (PhocView *self, struct wlr_surface *surface)
 
   g_assert (self->wlr_surface == NULL);
   self->wlr_surface = surface;
+  if (surface->data)
+    phoc_surface_set_view (PHOC_SURFACE (surface->data), self);
 
   phoc_view_init_subsurfaces (self);
   priv->surface_new_subsurface.notify = phoc_view_handle_surface_new_subsurface;
@@ -1350,6 +1504,8 @@ phoc_view_unmap (PhocView *view)
 
   bool was_visible = phoc_desktop_view_check_visibility (desktop, view);
 
+  /* Nothing to show anymore, the layout transaction doesn't apply */
+  phoc_renderer_drop_saved_element (phoc_server_get_renderer (phoc_server_get_default ()), view);
   phoc_view_damage_whole (view);
 
   wl_list_remove (&priv->surface_new_subsurface.link);
@@ -1372,6 +1528,8 @@ phoc_view_unmap (PhocView *view)
     }
   }
 
+  if (view->wlr_surface->data)
+    phoc_surface_set_view (PHOC_SURFACE (view->wlr_surface->data), NULL);
   view->wlr_surface = NULL;
   view->box.width = view->box.height = 0;
 
@@ -1425,6 +1583,144 @@ phoc_view_setup (PhocView *view)
   wlr_foreign_toplevel_handle_v1_set_parent (priv->toplevel_handle, toplevel_handle);
 }
 
+/* Bound the number of rectangles we accumulate between thumbnails */
+#define PHOC_VIEW_CONTENT_DAMAGE_MAX_RECTS 32
+
+static void
+content_damage_iterator (struct wlr_surface *wlr_surface, int sx, int sy, void *data)
+{
+  pixman_region32_t *content_damage = data;
+  PhocSurface *surface = wlr_surface->data;
+  pixman_region32_t damage;
+
+  pixman_region32_init (&damage);
+  wlr_surface_get_effective_damage (wlr_surface, &damage);
+  if (surface)
+    pixman_region32_union (&damage, &damage, phoc_surface_get_damage (surface));
+
+  pixman_region32_translate (&damage, sx, sy);
+  pixman_region32_union (content_damage, content_damage, &damage);
+  pixman_region32_fini (&damage);
+}
+
+
+static void
+add_content_damage (PhocView *self, gboolean whole)
+{
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+
+  if (!priv->content_consumers)
+    return;
+
+  priv->commit_seq++;
+
+  if (whole || self->wlr_surface == NULL) {
+    priv->content_damage_whole = TRUE;
+    pixman_region32_clear (&priv->content_damage);
+  } else if (!priv->content_damage_whole) {
+    /* Must happen before the outputs consume the surface damage */
+    wlr_surface_for_each_surface (self->wlr_surface, content_damage_iterator,
+                                  &priv->content_damage);
+
+    if (pixman_region32_n_rects (&priv->content_damage) > PHOC_VIEW_CONTENT_DAMAGE_MAX_RECTS) {
+      pixman_box32_t *extents = pixman_region32_extents (&priv->content_damage);
+
+      pixman_region32_reset (&priv->content_damage, extents);
+    }
+  }
+
+  g_signal_emit (self, signals[CONTENT_DAMAGED], 0);
+}
+
+/* What a surface contributes to its view's opaque region */
+typedef struct {
+  struct wlr_surface *surface;
+  int                 sx, sy;
+  gboolean            opaque_buffer;
+  double              alpha;
+  pixman_region32_t   opaque_region;
+} SurfaceOpacity;
+
+
+typedef struct {
+  GArray   *opacity;
+  guint     n_surfaces;
+  gboolean  changed;
+} CheckOpacityData;
+
+
+static void
+surface_opacity_clear (SurfaceOpacity *opacity)
+{
+  pixman_region32_fini (&opacity->opaque_region);
+}
+
+
+static void
+check_opacity_iterator (struct wlr_surface *surface, int sx, int sy, void *user_data)
+{
+  CheckOpacityData *data = user_data;
+  const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state;
+  SurfaceOpacity *opacity;
+  gboolean opaque_buffer;
+  double alpha = 1.0;
+
+  opaque_buffer = surface->buffer && wlr_buffer_is_opaque (&surface->buffer->base);
+  alpha_modifier_state = wlr_alpha_modifier_v1_get_surface_state (surface);
+  if (alpha_modifier_state)
+    alpha = alpha_modifier_state->multiplier;
+
+  if (data->n_surfaces == data->opacity->len) {
+    SurfaceOpacity new_opacity = { .surface = NULL };
+
+    pixman_region32_init (&new_opacity.opaque_region);
+    g_array_append_val (data->opacity, new_opacity);
+  }
+  opacity = &g_array_index (data->opacity, SurfaceOpacity, data->n_surfaces++);
+
+  if (opacity->surface == surface &&
+      opacity->sx == sx &&
+      opacity->sy == sy &&
+      opacity->opaque_buffer == opaque_buffer &&
+      opacity->alpha == alpha &&
+      pixman_region32_equal (&opacity->opaque_region, &surface->opaque_region)) {
+    return;
+  }
+
+  opacity->surface = surface;
+  opacity->sx = sx;
+  opacity->sy = sy;
+  opacity->opaque_buffer = opaque_buffer;
+  opacity->alpha = alpha;
+  pixman_region32_copy (&opacity->opaque_region, &surface->opaque_region);
+  data->changed = TRUE;
+}
+
+/*
+ * Views below might have become visible or got covered. The view's
+ * opaque region is built from all its surfaces' buffers, opaque
+ * regions and alpha modifiers so check all of them.
+ */
+static void
+check_opacity (PhocView *self)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocViewPrivate *priv = phoc_view_get_instance_private (self);
+  CheckOpacityData data = { .opacity = priv->opacity };
+
+  if (self->wlr_surface == NULL)
+    return;
+
+  phoc_view_for_each_surface (self, check_opacity_iterator, &data);
+  if (data.n_surfaces < priv->opacity->len) {
+    g_array_set_size (priv->opacity, data.n_surfaces);
+    data.changed = TRUE;
+  }
+
+  if (data.changed)
+    phoc_desktop_invalidate_visibility (desktop);
+}
+
 /**
  * phoc_view_apply_damage:
  * @view: A view
@@ -1438,8 +1734,14 @@ phoc_view_apply_damage (PhocView *view)
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
   PhocOutput *output;
 
+  add_content_damage (view, FALSE);
+  check_opacity (view);
+
   wl_list_for_each (output, &desktop->outputs, link)
     phoc_output_damage_from_view (output, view, false);
+
+  /* Popups and subsurfaces might have moved */
+  phoc_desktop_update_view_bounds (desktop, view);
 }
 
 /**
@@ -1457,8 +1759,14 @@ phoc_view_damage_whole (PhocView *view)
   PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
   PhocOutput *output;
 
+  add_content_damage (view, TRUE);
+  /* Moves, resizes and state changes go through here */
+  phoc_desktop_invalidate_visibility (desktop);
+
   wl_list_for_each (output, &desktop->outputs, link)
     phoc_output_damage_from_view (output, view, true);
+
+  phoc_desktop_update_view_bounds (desktop, view);
 }
 
 
@@ -1473,6 +1781,7 @@ view_update_position (PhocView *view, int x, int y)
   phoc_view_damage_whole (view);
   view->box.x = x;
   view->box.y = y;
+  phoc_touch_point_invalidate_transforms ();
   view_update_output (view, &before);
   phoc_view_damage_whole (view);
 }
@@ -1685,6 +1994,7 @@ phoc_view_finalize (GObject *object)
   PhocViewPrivate *priv = phoc_view_get_instance_private (self);
 
   g_clear_handle_id (&priv->suspend_timer_id, g_source_remove);
+  g_clear_handle_id (&priv->hidden_frame_timer_id, g_source_remove);
 
   /* Unlink from our parent */
   if (self->parent) {
@@ -1715,6 +2025,8 @@ phoc_view_finalize (GObject *object)
   g_clear_pointer (&priv->activation_token, g_free);
   g_clear_object (&priv->deco);
   g_clear_object (&priv->settings);
+  pixman_region32_fini (&priv->content_damage);
+  g_clear_pointer (&priv->opacity, g_array_unref);
 
   G_OBJECT_CLASS (phoc_view_parent_class)->finalize (object);
 }
@@ -1910,6 +2222,7 @@ phoc_view_class_init (PhocViewClass *klass)
                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS | G_PARAM_EXPLICIT_NOTIFY);
 
   g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+  phoc_property_easer_install_setter (props[PROP_ALPHA], (PhocPropertyEaserSetter)phoc_view_set_alpha);
 
   /**
    * PhocView::surface-destroy:
@@ -1925,6 +2238,22 @@ phoc_view_class_init (PhocViewClass *klass)
                   NULL, NULL, NULL,
                   G_TYPE_NONE,
                   0);
+  /**
+   * PhocView::content-damaged:
+   *
+   * The contents of the view or one of its subsurfaces changed. Use
+   * [method@View.take_content_damage] to get the damaged area. This
+   * is only emitted while content damage is held via
+   * [method@View.hold_content_damage].
+   */
+  signals[CONTENT_DAMAGED] =
+    g_signal_new ("content-damaged",
+                  G_TYPE_FROM_CLASS (object_class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE,
+                  0);
 }
 
 
@@ -1937,7 +2266,11 @@ phoc_view_init (PhocView *self)
   priv->alpha = 1.0f;
   priv->scale = 1.0f;
   priv->state = PHOC_VIEW_STATE_FLOATING;
-  priv->visibility = TRUE;
+  priv->visible_outputs = G_MAXUINT32;
+  pixman_region32_init (&priv->content_damage);
+  priv->content_damage_whole = TRUE;
+  priv->opacity = g_array_new (FALSE, FALSE, sizeof (SurfaceOpacity));
+  g_array_set_clear_func (priv->opacity, (GDestroyNotify)surface_opacity_clear);
 
   wl_list_init (&self->stack);
 
@@ -2443,26 +2776,149 @@ phoc_view_is_always_on_top (PhocView *self)
 }
 
 /**
- * phoc_view_set_visiblity:
+ * phoc_view_set_visible_outputs:
  * @self: a view
- * @visibility: The views visibility
+ * @visible_outputs: The outputs the view is visible on
  *
- * Sets the views visibility as determined by
- * [method@Desktop.view_check_visible] and triggers needed actions
- * resulting from visibility changes.
+ * Sets the mask of outputs the view is visible on as determined by
+ * [method@Desktop.view_check_visibility] and triggers needed actions
+ * resulting from visibility changes. See [method@Output.get_mask].
  */
 void
-phoc_view_set_visibility (PhocView *self, gboolean visibility)
+phoc_view_set_visible_outputs (PhocView *self, guint32 visible_outputs)
 {
   PhocViewPrivate *priv;
+  gboolean was_visible;
 
   g_assert (PHOC_IS_VIEW (self));
   priv = phoc_view_get_instance_private (self);
 
-  if (priv->visibility == visibility)
+  if (priv->visible_outputs == visible_outputs)
     return;
 
-  priv->visibility = visibility;
+  was_visible = !!priv->visible_outputs;
+  priv->visible_outputs = visible_outputs;
+
+  if (was_visible != !!visible_outputs)
+    phoc_view_set_suspended (self, !visible_outputs);
+}
+
+/**
+ * phoc_view_get_visible_outputs:
+ * @self: a view
+ *
+ * Gets the mask of outputs the view was visible on when its visibility
+ * was last checked via [method@Desktop.view_check_visibility].
+ *
+ * Returns: The mask of outputs the view is visible on
+ */
+guint32
+phoc_view_get_visible_outputs (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  return priv->visible_outputs;
+}
+
+/**
+ * phoc_view_get_commit_seq:
+ * @self: a view
+ *
+ * Gets a sequence number that changes whenever the contents of the
+ * view or one of its subsurfaces might have changed. This allows
+ * caching things derived from the view's contents like thumbnails.
+ * It's only updated while content damage is held via
+ * [method@View.hold_content_damage].
+ *
+ * Returns: The view's commit sequence number
+ */
+guint
+phoc_view_get_commit_seq (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  return priv->commit_seq;
+}
+
+/**
+ * phoc_view_take_content_damage:
+ * @self: a view
+ * @damage: Return location for the damage
+ *
+ * Gets the damage of the view's surface and its subsurfaces accumulated
+ * since the last call and resets it. The damage is in the coordinate
+ * space of the view's root surface. This is meant for a single consumer
+ * like the thumbnail cache that needs to know which parts of its copy of
+ * the view's contents are out of date.
+ *
+ * Returns: `FALSE` if the whole view must be considered damaged, in
+ *   which case `damage` is left empty, otherwise `TRUE`.
+ */
+gboolean
+phoc_view_take_content_damage (PhocView *self, pixman_region32_t *damage)
+{
+  PhocViewPrivate *priv;
+  gboolean whole;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  whole = priv->content_damage_whole;
+  pixman_region32_copy (damage, &priv->content_damage);
+
+  pixman_region32_clear (&priv->content_damage);
+  priv->content_damage_whole = FALSE;
+
+  return !whole;
+}
+
+/**
+ * phoc_view_hold_content_damage:
+ * @self: a view
+ *
+ * Starts tracking the view's content damage and commit sequence
+ * number. Walking the view's surface tree on every commit is only
+ * worth it while there's a consumer like a thumbnail or a pending
+ * screencopy so they need to hold the content damage. Release it via
+ * [method@View.release_content_damage] once it's not needed anymore.
+ */
+void
+phoc_view_hold_content_damage (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
+
+  if (priv->content_consumers++)
+    return;
+
+  /* Nothing got tracked so far */
+  priv->commit_seq++;
+  priv->content_damage_whole = TRUE;
+  pixman_region32_clear (&priv->content_damage);
+}
+
+/**
+ * phoc_view_release_content_damage:
+ * @self: a view
+ *
+ * Releases content damage held via [method@View.hold_content_damage].
+ */
+void
+phoc_view_release_content_damage (PhocView *self)
+{
+  PhocViewPrivate *priv;
+
+  g_assert (PHOC_IS_VIEW (self));
+  priv = phoc_view_get_instance_private (self);
 
-  phoc_view_set_suspended (self, !visibility);
+  g_return_if_fail (priv->content_consumers > 0);
+  priv->content_consumers--;
 }
@@ -156,6 +156,7 @@ gboolean              phoc_view_is_fullscreen (PhocView *self);
 void                  phoc_view_update_decorated (PhocView *view, bool decorated);
 void                  phoc_view_arrange (PhocView *self, PhocOutput *output, gboolean center);
 void                  phoc_view_get_box (PhocView *view, struct wlr_box *box);
+void                  phoc_view_get_input_bounds (PhocView *self, struct wlr_box *bounds);
 void                  phoc_view_get_geometry (PhocView *self, struct wlr_box *box);
 void                  phoc_view_move (PhocView *self, double x, double y);
 bool                  phoc_view_move_to_next_output (PhocView *view, enum wlr_direction direction);
@@ -209,7 +210,13 @@ void                  phoc_view_set_decorated (PhocView *self,
 gboolean              phoc_view_get_maximized_box (PhocView       *self,
                                                    PhocOutput     *output,
                                                    struct wlr_box *box);
-void                  phoc_view_set_visibility (PhocView *self, gboolean visibility);
+void                  phoc_view_set_visible_outputs (PhocView *self, guint32 visible_outputs);
+guint32               phoc_view_get_visible_outputs (PhocView *self);
+guint                 phoc_view_get_commit_seq (PhocView *self);
+gboolean              phoc_view_take_content_damage (PhocView          *self,
+                                                     pixman_region32_t *damage);
+void                  phoc_view_hold_content_damage (PhocView *self);
+void                  phoc_view_release_content_damage (PhocView *self);
 gboolean              phoc_view_get_tiled_box (PhocView             *self,
                                                PhocViewTileDirection dir,
                                                PhocOutput           *output,
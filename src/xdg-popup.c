@@ -134,6 +134,9 @@ popup_handle_surface_commit (struct wl_listener *listener, void *data)
   if (self->wlr_popup->base->initial_commit)
     popup_unconstrain (self);
 
+  /* The popup's geometry is only applied on commit */
+  phoc_touch_point_invalidate_transforms ();
+
   if (self->repositioned) {
     PhocSurface *surface = PHOC_SURFACE (self->wlr_popup->base->surface->data);
     double sx, sy;
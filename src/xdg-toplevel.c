@@ -12,6 +12,7 @@
 #include "phoc-config.h"
 
 #include "cursor.h"
+#include "layout-transaction.h"
 #include "server.h"
 #include "view-private.h"
 #include "xdg-popup.h"
@@ -66,6 +67,9 @@ typedef struct _PhocXdgToplevel {
   struct wl_event_source    *frame_done_idle;
 
   uint32_t                   pending_move_resize_configure_serial;
+  /* The layout transaction waiting for a configure and its serial */
+  guint                      transaction_id;
+  uint32_t                   transaction_serial;
 
   PhocXdgToplevelDecoration *decoration;
 } PhocXdgToplevel;
@@ -107,6 +111,10 @@ send_frame_done_if_not_visible (PhocXdgToplevel *self)
   if (phoc_desktop_view_check_visibility (desktop, view) || !phoc_view_is_mapped (view))
     return;
 
+  /* One pending frame done is enough to unblock the client */
+  if (self->frame_done_idle)
+    return;
+
   display = wl_client_get_display (self->xdg_toplevel->base->client->client);
   loop = wl_display_get_event_loop (display);
 
@@ -115,6 +123,17 @@ send_frame_done_if_not_visible (PhocXdgToplevel *self)
 }
 
 
+static void
+leave_layout_transaction (PhocXdgToplevel *self)
+{
+  if (!self->transaction_id)
+    return;
+
+  phoc_layout_transaction_notify_view_configured (phoc_layout_transaction_get_default (),
+                                                  &self->transaction_id);
+}
+
+
 static void
 phoc_xdg_toplevel_set_property (GObject      *object,
                                 guint         property_id,
@@ -215,6 +234,16 @@ move_resize (PhocView *view, double x, double y, uint32_t width, uint32_t height
   } else if (self->xdg_toplevel->base->initialized) {
     self->pending_move_resize_configure_serial =
       wlr_xdg_toplevel_set_size (wlr_xdg_toplevel, constrained_width, constrained_height);
+    /* Part of a layout change, e.g. the usable area changed */
+    if (phoc_view_is_mapped (view)) {
+      phoc_layout_transaction_add_view_dirty (phoc_layout_transaction_get_default (),
+                                              &self->transaction_id);
+      /* Wait for the latest configure sent as part of the transaction */
+      if (self->transaction_id) {
+        self->transaction_serial = self->pending_move_resize_configure_serial;
+        phoc_layout_transaction_save_element (phoc_layout_transaction_get_default (), view);
+      }
+    }
   }
 
   send_frame_done_if_not_visible (self);
@@ -450,6 +479,13 @@ handle_surface_commit (struct wl_listener *listener, void *data)
       self->pending_move_resize_configure_serial = 0;
   }
 
+  /* Later configures might have superseded the one the transaction
+   * waits for. Compare the difference so serials can wrap. */
+  if (self->transaction_id &&
+      (int32_t)(xdg_toplevel->base->current.configure_serial - self->transaction_serial) >= 0) {
+    leave_layout_transaction (self);
+  }
+
   struct wlr_box geometry;
   phoc_xdg_toplevel_get_geometry (self, &geometry);
   if (self->saved_geometry.x != geometry.x || self->saved_geometry.y != geometry.y) {
@@ -494,6 +530,8 @@ static void
 handle_unmap (struct wl_listener *listener, void *data)
 {
   PhocXdgToplevel *self = wl_container_of (listener, self, unmap);
+
+  leave_layout_transaction (self);
   phoc_view_unmap (PHOC_VIEW (self));
 }
 
@@ -667,6 +705,7 @@ phoc_xdg_toplevel_finalize (GObject *object)
   PhocXdgToplevel *self = PHOC_XDG_TOPLEVEL (object);
 
   g_clear_pointer (&self->frame_done_idle, wl_event_source_remove);
+  leave_layout_transaction (self);
 
   wl_list_remove (&self->surface_commit.link);
   wl_list_remove (&self->destroy.link);
@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "testlib.h"
+#include "testlib-layer-shell.h"
+
+#include "desktop.h"
+#include "output.h"
+#include "view.h"
+
+#include "xdg-shell-client-protocol.h"
+
+#include <wlr/types/wlr_output_layout.h>
+
+/*
+ * Headless render benchmarks
+ *
+ * Spawns toplevels, layer surfaces and popups, drives them through
+ * commit storms and alpha animations and reports frame rate, per frame
+ * render time and hit test cost as JSON. The number of surfaces and
+ * frames can be tuned via `PHOC_BENCH_VIEWS` and `PHOC_BENCH_FRAMES`,
+ * the report goes to stdout or the file in `PHOC_BENCH_OUTPUT`.
+ */
+
+#define BENCH_TIMEOUT 300
+#define BENCH_DEFAULT_VIEWS 8
+#define BENCH_DEFAULT_FRAMES 300
+/* Commits per surface and frame in the commit storm */
+#define BENCH_COMMITS_PER_FRAME 4
+/* Grid spacing of the hit test positions in layout pixels */
+#define BENCH_HIT_TEST_STEP 4
+#define BENCH_HIT_TEST_ROUNDS 10
+
+typedef enum {
+  BENCH_MODE_COMMIT_STORM,
+  BENCH_MODE_ALPHA,
+} BenchMode;
+
+
+typedef struct {
+  const char *name;
+  BenchMode   mode;
+  /* Filled in by the benchmark */
+  guint       n_views;
+  guint       n_frames;
+} BenchData;
+
+
+typedef struct {
+  GPtrArray *toplevels;
+  GPtrArray *layer_surfaces;
+  GPtrArray *popups;
+} BenchScene;
+
+
+typedef struct {
+  gint64   start_us;
+  gint64   elapsed_us;
+  guint64  n_composited;
+  guint64  n_scanout;
+  guint64  n_missed;
+  guint64  render_time_mean;
+  guint32  render_time_counts[32];
+  guint    n_buckets;
+  gint64   hit_test_ns;
+  guint64  n_hit_tests;
+  guint64  n_hits;
+  float    alpha;
+} BenchStats;
+
+static GString *report;
+
+
+static guint
+get_env_uint (const char *name, guint fallback)
+{
+  const char *value = g_getenv (name);
+  guint64 ret;
+
+  if (value == NULL || !g_ascii_string_to_unsigned (value, 10, 1, G_MAXUINT, &ret, NULL))
+    return fallback;
+
+  return ret;
+}
+
+
+static gboolean
+on_reset_stats (gpointer data)
+{
+  BenchStats *stats = data;
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output;
+
+  wl_list_for_each (output, &desktop->outputs, link)
+    phoc_frame_stats_reset (phoc_output_get_frame_stats (output));
+
+  stats->start_us = g_get_monotonic_time ();
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+on_collect_stats (gpointer data)
+{
+  BenchStats *stats = data;
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output;
+  guint64 render_time_sum = 0;
+
+  stats->elapsed_us = g_get_monotonic_time () - stats->start_us;
+
+  wl_list_for_each (output, &desktop->outputs, link) {
+    PhocFrameStats *frame_stats = phoc_output_get_frame_stats (output);
+    const guint32 *counts;
+    guint n_buckets;
+
+    counts = phoc_frame_stats_get_histogram (frame_stats, PHOC_FRAME_STATS_RENDER_TIME,
+                                             &n_buckets);
+    g_assert_cmpint (n_buckets, <=, G_N_ELEMENTS (stats->render_time_counts));
+    stats->n_buckets = n_buckets;
+    for (guint i = 0; i < n_buckets; i++)
+      stats->render_time_counts[i] += counts[i];
+
+    stats->n_composited += phoc_frame_stats_get_n_composited (frame_stats);
+    stats->n_scanout += phoc_frame_stats_get_n_scanout (frame_stats);
+    stats->n_missed += phoc_frame_stats_get_n_missed (frame_stats);
+    render_time_sum += phoc_frame_stats_get_n_composited (frame_stats) *
+      phoc_frame_stats_get_mean (frame_stats, PHOC_FRAME_STATS_RENDER_TIME);
+  }
+
+  if (stats->n_composited)
+    stats->render_time_mean = render_time_sum / stats->n_composited;
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+on_hit_test (gpointer data)
+{
+  BenchStats *stats = data;
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  struct wlr_box box;
+  gint64 start;
+
+  wlr_output_layout_get_box (desktop->layout, NULL, &box);
+  g_assert_false (wlr_box_empty (&box));
+
+  start = g_get_monotonic_time ();
+  for (int round = 0; round < BENCH_HIT_TEST_ROUNDS; round++) {
+    for (int y = box.y; y < box.y + box.height; y += BENCH_HIT_TEST_STEP) {
+      for (int x = box.x; x < box.x + box.width; x += BENCH_HIT_TEST_STEP) {
+        PhocView *view = NULL;
+        double sx, sy;
+
+        if (phoc_desktop_wlr_surface_at (desktop, x + 0.5, y + 0.5, &sx, &sy, &view))
+          stats->n_hits++;
+        stats->n_hit_tests++;
+      }
+    }
+  }
+  stats->hit_test_ns = (g_get_monotonic_time () - start) * 1000;
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+on_set_alpha (gpointer data)
+{
+  BenchStats *stats = data;
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  GQueue *views = phoc_desktop_get_views (desktop);
+
+  for (GList *l = views->head; l; l = l->next)
+    g_object_set (l->data, "alpha", stats->alpha, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+bench_scene_init (BenchScene *scene, PhocTestClientGlobals *globals, guint n_views)
+{
+  static const guint32 anchors[] = {
+    ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP | ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT,
+    ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT,
+    ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM | ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT,
+    ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM | ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT,
+  };
+
+  scene->toplevels = g_ptr_array_new_with_free_func ((GDestroyNotify)phoc_test_xdg_toplevel_free);
+  scene->layer_surfaces = g_ptr_array_new_with_free_func ((GDestroyNotify)phoc_test_layer_surface_free);
+  scene->popups = g_ptr_array_new_with_free_func ((GDestroyNotify)phoc_test_xdg_popup_free);
+
+  for (guint i = 0; i < n_views; i++) {
+    PhocTestXdgToplevelSurface *xs;
+    PhocTestLayerSurface *ls;
+    guint32 color = 0xFF000000 | g_random_int_range (0, 0xFFFFFF);
+
+    xs = phoc_test_xdg_toplevel_new_with_buffer (globals, 320, 240, NULL, color);
+    g_ptr_array_add (scene->toplevels, xs);
+    g_ptr_array_add (scene->popups,
+                     phoc_test_xdg_popup_new (globals, xs, 64, 64, ~color | 0xFF000000));
+
+    ls = phoc_test_layer_surface_new (globals, 160, 40, color,
+                                      anchors[i % G_N_ELEMENTS (anchors)], 0);
+    g_ptr_array_add (scene->layer_surfaces, ls);
+  }
+}
+
+
+static void
+bench_scene_clear (BenchScene *scene)
+{
+  /* Popups need to go before their parents */
+  g_clear_pointer (&scene->popups, g_ptr_array_unref);
+  g_clear_pointer (&scene->toplevels, g_ptr_array_unref);
+  g_clear_pointer (&scene->layer_surfaces, g_ptr_array_unref);
+}
+
+
+static void
+frame_handle_done (void *data, struct wl_callback *callback, uint32_t time)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+  wl_callback_destroy (callback);
+}
+
+
+static const struct wl_callback_listener frame_listener = {
+  .done = frame_handle_done,
+};
+
+/* Commit the given surface and wait for it to be presented */
+static void
+commit_and_wait_for_frame (PhocTestClientGlobals *globals, struct wl_surface *wl_surface)
+{
+  struct wl_callback *callback;
+  gboolean done = FALSE;
+
+  callback = wl_surface_frame (wl_surface);
+  wl_callback_add_listener (callback, &frame_listener, &done);
+  wl_surface_commit (wl_surface);
+
+  while (!done && wl_display_dispatch (globals->display) != -1) {
+    /* nothing */
+  }
+  g_assert_true (done);
+}
+
+
+static void
+commit_storm (PhocTestClientGlobals *globals, BenchScene *scene, guint frame)
+{
+  for (guint i = 0; i < BENCH_COMMITS_PER_FRAME; i++) {
+    for (guint j = 0; j < scene->toplevels->len; j++) {
+      PhocTestXdgToplevelSurface *xs = g_ptr_array_index (scene->toplevels, j);
+      PhocTestXdgPopup *popup = g_ptr_array_index (scene->popups, j);
+      PhocTestLayerSurface *ls = g_ptr_array_index (scene->layer_surfaces, j);
+      /* Move a small damaged area around */
+      int x = (frame * 8 + i * 16) % (xs->width - 16);
+
+      wl_surface_attach (xs->wl_surface, xs->buffer.wl_buffer, 0, 0);
+      wl_surface_damage_buffer (xs->wl_surface, x, x % (xs->height - 16), 16, 16);
+      wl_surface_commit (xs->wl_surface);
+
+      wl_surface_attach (popup->wl_surface, popup->buffer.wl_buffer, 0, 0);
+      wl_surface_damage_buffer (popup->wl_surface, 0, 0, popup->width, popup->height);
+      wl_surface_commit (popup->wl_surface);
+
+      wl_surface_attach (ls->wl_surface, ls->buffer.wl_buffer, 0, 0);
+      wl_surface_damage_buffer (ls->wl_surface, 0, 0, ls->width, 1);
+      wl_surface_commit (ls->wl_surface);
+    }
+  }
+  wl_display_flush (globals->display);
+}
+
+
+static void
+append_stats (BenchData *bench, BenchStats *stats)
+{
+  const guint64 *bounds;
+  double fps = 0.0;
+
+  if (stats->elapsed_us)
+    fps = stats->n_composited * (double)G_USEC_PER_SEC / stats->elapsed_us;
+
+  if (report->len)
+    g_string_append (report, ",\n");
+
+  g_string_append_printf (report,
+                          "    {\n"
+                          "      \"name\": \"%s\",\n"
+                          "      \"views\": %u,\n"
+                          "      \"layer-surfaces\": %u,\n"
+                          "      \"popups\": %u,\n"
+                          "      \"frames\": %u,\n"
+                          "      \"duration-us\": %" G_GINT64_FORMAT ",\n"
+                          "      \"composited\": %" G_GUINT64_FORMAT ",\n"
+                          "      \"scanout\": %" G_GUINT64_FORMAT ",\n"
+                          "      \"missed\": %" G_GUINT64_FORMAT ",\n"
+                          "      \"fps\": %.2f,\n"
+                          "      \"render-time-mean-us\": %" G_GUINT64_FORMAT ",\n",
+                          bench->name,
+                          bench->n_views,
+                          bench->n_views,
+                          bench->n_views,
+                          bench->n_frames,
+                          stats->elapsed_us,
+                          stats->n_composited,
+                          stats->n_scanout,
+                          stats->n_missed,
+                          fps,
+                          stats->render_time_mean);
+
+  bounds = phoc_frame_stats_get_bucket_bounds (PHOC_FRAME_STATS_RENDER_TIME, NULL);
+  g_string_append (report, "      \"render-time-bounds-us\": [");
+  /* The last bucket is unbounded */
+  for (guint i = 0; i < stats->n_buckets - 1; i++)
+    g_string_append_printf (report, "%s%" G_GUINT64_FORMAT, i ? ", " : "", bounds[i]);
+  g_string_append (report, "],\n      \"render-time-counts\": [");
+  for (guint i = 0; i < stats->n_buckets; i++)
+    g_string_append_printf (report, "%s%u", i ? ", " : "", stats->render_time_counts[i]);
+  g_string_append (report, "],\n");
+
+  g_string_append_printf (report,
+                          "      \"hit-tests\": %" G_GUINT64_FORMAT ",\n"
+                          "      \"hit-test-hits\": %" G_GUINT64_FORMAT ",\n"
+                          "      \"hit-test-ns\": %.1f\n"
+                          "    }",
+                          stats->n_hit_tests,
+                          stats->n_hits,
+                          stats->n_hit_tests ? (double)stats->hit_test_ns / stats->n_hit_tests : 0.0);
+}
+
+
+static gboolean
+bench_client_run (PhocTestClientGlobals *globals, gpointer data)
+{
+  BenchData *bench = data;
+  BenchStats stats = { 0 };
+  BenchScene scene;
+  PhocTestXdgToplevelSurface *top;
+
+  bench_scene_init (&scene, globals, bench->n_views);
+  top = g_ptr_array_index (scene.toplevels, scene.toplevels->len - 1);
+
+  phoc_test_run_in_server (on_hit_test, &stats);
+
+  phoc_test_run_in_server (on_reset_stats, &stats);
+  for (guint frame = 0; frame < bench->n_frames; frame++) {
+    switch (bench->mode) {
+    case BENCH_MODE_COMMIT_STORM:
+      commit_storm (globals, &scene, frame);
+      break;
+    case BENCH_MODE_ALPHA:
+      stats.alpha = 0.5 + 0.5 * ((frame % 60) / 59.0);
+      phoc_test_run_in_server (on_set_alpha, &stats);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+    /* Pace on the topmost toplevel as it's never occluded */
+    commit_and_wait_for_frame (globals, top->wl_surface);
+  }
+  phoc_test_run_in_server (on_collect_stats, &stats);
+
+  append_stats (bench, &stats);
+  bench_scene_clear (&scene);
+
+  return TRUE;
+}
+
+
+static void
+bench_render (PhocTestFixture *fixture, gconstpointer data)
+{
+  BenchData *bench = (BenchData *)data;
+  PhocTestClientIface iface = {
+    .client_run = bench_client_run,
+  };
+
+  bench->n_views = get_env_uint ("PHOC_BENCH_VIEWS", BENCH_DEFAULT_VIEWS);
+  bench->n_frames = get_env_uint ("PHOC_BENCH_FRAMES", BENCH_DEFAULT_FRAMES);
+
+  phoc_test_client_run (BENCH_TIMEOUT, &iface, bench);
+}
+
+
+static void
+write_report (void)
+{
+  g_autoptr (GError) err = NULL;
+  g_autofree char *json = NULL;
+  const char *filename = g_getenv ("PHOC_BENCH_OUTPUT");
+
+  json = g_strdup_printf ("{\n  \"benchmarks\": [\n%s\n  ]\n}\n", report->str);
+
+  if (filename == NULL) {
+    g_print ("%s", json);
+    return;
+  }
+
+  if (!g_file_set_contents (filename, json, -1, &err))
+    g_critical ("Failed to write benchmark report to %s: %s", filename, err->message);
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  static BenchData commit_storm = { .name = "commit-storm", .mode = BENCH_MODE_COMMIT_STORM };
+  static BenchData alpha = { .name = "alpha", .mode = BENCH_MODE_ALPHA };
+  int ret;
+
+  g_test_init (&argc, &argv, NULL);
+
+  report = g_string_new (NULL);
+
+  g_test_add ("/phoc/bench/render/commit-storm", PhocTestFixture, &commit_storm,
+              (gpointer)phoc_test_setup, (gpointer)bench_render, (gpointer)phoc_test_teardown);
+  g_test_add ("/phoc/bench/render/alpha", PhocTestFixture, &alpha,
+              (gpointer)phoc_test_setup, (gpointer)bench_render, (gpointer)phoc_test_teardown);
+
+  ret = g_test_run ();
+
+  write_report ();
+  g_string_free (report, TRUE);
+
+  return ret;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "event.h"
+
+
+static void
+test_phoc_event_ref (void)
+{
+  struct wlr_touch_down_event wlr_event = { .time_msec = 42, .touch_id = 7 };
+  g_autoptr (PhocEvent) event = NULL;
+  g_autoptr (PhocEvent) copy = NULL;
+  PhocEvent *ref;
+
+  event = phoc_event_new (PHOC_EVENT_TOUCH_BEGIN, &wlr_event, sizeof (wlr_event));
+  g_assert_cmpint (event->type, ==, PHOC_EVENT_TOUCH_BEGIN);
+  g_assert_cmpint (phoc_event_get_time (event), ==, 42);
+  g_assert_true (phoc_event_get_event_sequence (event) == GUINT_TO_POINTER (7));
+
+  ref = phoc_event_ref (event);
+  g_assert_true (ref == event);
+  phoc_event_unref (ref);
+  /* Still valid */
+  g_assert_cmpint (event->type, ==, PHOC_EVENT_TOUCH_BEGIN);
+
+  copy = phoc_event_copy (event);
+  g_assert_false (copy == event);
+  g_assert_cmpint (copy->type, ==, PHOC_EVENT_TOUCH_BEGIN);
+  g_assert_cmpint (phoc_event_get_time (copy), ==, 42);
+}
+
+
+static void
+test_phoc_event_reuse (void)
+{
+  struct wlr_touch_down_event wlr_event = { .time_msec = 42 };
+  PhocEvent *event;
+
+  event = phoc_event_new (PHOC_EVENT_TOUCH_BEGIN, &wlr_event, sizeof (wlr_event));
+  phoc_event_unref (event);
+
+  /* Reused events don't carry over old data */
+  event = phoc_event_new (PHOC_EVENT_NOTHING, NULL, 0);
+  g_assert_cmpint (event->type, ==, PHOC_EVENT_NOTHING);
+  g_assert_cmpint (phoc_event_get_time (event), ==, 0);
+  phoc_event_unref (event);
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/event/ref", test_phoc_event_ref);
+  g_test_add_func ("/phoc/event/reuse", test_phoc_event_reuse);
+
+  return g_test_run ();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "frame-clock.h"
+
+
+static void
+test_phoc_frame_clock_no_feedback (void)
+{
+  g_autoptr (PhocFrameClock) clock = phoc_frame_clock_new ();
+
+  /* Nothing known, use the current time */
+  g_assert_false (phoc_frame_clock_is_synced (clock));
+  g_assert_cmpint (phoc_frame_clock_get_refresh_interval (clock), ==, 0);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 1000), ==, 1000);
+
+  /* 50Hz mode, next refresh cycle */
+  phoc_frame_clock_set_refresh_rate (clock, 50000);
+  g_assert_cmpint (phoc_frame_clock_get_refresh_interval (clock), ==, 20000);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 5000), ==, 25000);
+}
+
+
+static void
+test_phoc_frame_clock_predict (void)
+{
+  g_autoptr (PhocFrameClock) clock = phoc_frame_clock_new ();
+
+  phoc_frame_clock_set_refresh_rate (clock, 50000);
+  /* The reported refresh interval takes precedence */
+  phoc_frame_clock_add_presentation (clock, 100000, 16000);
+  g_assert_true (phoc_frame_clock_is_synced (clock));
+  g_assert_cmpint (phoc_frame_clock_get_refresh_interval (clock), ==, 16000);
+
+  /* Aligned to the vblanks after the last presentation regardless of
+   * when exactly the frame gets prepared */
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 100500), ==, 116000);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 131999), ==, 132000);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 132000), ==, 148000);
+
+  /* Frames after an idle period stay in phase */
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 1000000), ==, 1012000);
+
+  /* Changing the mode drops the phase */
+  phoc_frame_clock_set_refresh_rate (clock, 100000);
+  g_assert_false (phoc_frame_clock_is_synced (clock));
+  g_assert_cmpint (phoc_frame_clock_get_refresh_interval (clock), ==, 10000);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 2000000), ==, 2010000);
+}
+
+
+static void
+test_phoc_frame_clock_monotonic (void)
+{
+  g_autoptr (PhocFrameClock) clock = phoc_frame_clock_new ();
+
+  phoc_frame_clock_add_presentation (clock, 100000, 16000);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 101000), ==, 116000);
+
+  /* A second frame in the same cycle can't be shown at the same vblank */
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 102000), ==, 132000);
+
+  /* Late presentation of the first frame moves the phase */
+  phoc_frame_clock_add_presentation (clock, 133000, 16000);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 134000), ==, 149000);
+
+  phoc_frame_clock_reset (clock);
+  g_assert_cmpint (phoc_frame_clock_get_refresh_interval (clock), ==, 0);
+  g_assert_cmpint (phoc_frame_clock_get_frame_time (clock, 50000), ==, 50000);
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/frame-clock/no-feedback", test_phoc_frame_clock_no_feedback);
+  g_test_add_func ("/phoc/frame-clock/predict", test_phoc_frame_clock_predict);
+  g_test_add_func ("/phoc/frame-clock/monotonic", test_phoc_frame_clock_monotonic);
+
+  return g_test_run ();
+}
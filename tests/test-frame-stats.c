@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "frame-stats.h"
+
+
+static void
+test_phoc_frame_stats_counters (void)
+{
+  g_autoptr (PhocFrameStats) stats = phoc_frame_stats_new ();
+
+  phoc_frame_stats_add_composited (stats, 1000, 100);
+  phoc_frame_stats_add_composited (stats, 3000, 300);
+  phoc_frame_stats_add_scanout (stats);
+  phoc_frame_stats_add_presented (stats, 16000, FALSE);
+  phoc_frame_stats_add_presented (stats, 20000, TRUE);
+  phoc_frame_stats_add_discarded (stats);
+
+  g_assert_cmpuint (phoc_frame_stats_get_n_composited (stats), ==, 2);
+  g_assert_cmpuint (phoc_frame_stats_get_n_scanout (stats), ==, 1);
+  g_assert_cmpuint (phoc_frame_stats_get_n_missed (stats), ==, 2);
+
+  g_assert_cmpuint (phoc_frame_stats_get_mean (stats, PHOC_FRAME_STATS_RENDER_TIME), ==, 2000);
+  g_assert_cmpuint (phoc_frame_stats_get_mean (stats, PHOC_FRAME_STATS_DAMAGE_AREA), ==, 200);
+  g_assert_cmpuint (phoc_frame_stats_get_mean (stats, PHOC_FRAME_STATS_PRESENT_LATENCY), ==, 18000);
+
+  phoc_frame_stats_add_damage_rects (stats, 4, FALSE);
+  phoc_frame_stats_add_damage_rects (stats, 32, TRUE);
+  g_assert_cmpuint (phoc_frame_stats_get_n_simplified (stats), ==, 1);
+  g_assert_cmpuint (phoc_frame_stats_get_mean (stats, PHOC_FRAME_STATS_DAMAGE_RECTS), ==, 18);
+
+  phoc_frame_stats_reset (stats);
+  g_assert_cmpuint (phoc_frame_stats_get_n_composited (stats), ==, 0);
+  g_assert_cmpuint (phoc_frame_stats_get_n_missed (stats), ==, 0);
+  g_assert_cmpuint (phoc_frame_stats_get_n_simplified (stats), ==, 0);
+  g_assert_cmpuint (phoc_frame_stats_get_mean (stats, PHOC_FRAME_STATS_RENDER_TIME), ==, 0);
+}
+
+
+static void
+test_phoc_frame_stats_histogram (void)
+{
+  g_autoptr (PhocFrameStats) stats = phoc_frame_stats_new ();
+  guint window = phoc_frame_stats_get_window_size ();
+  const guint64 *bounds;
+  const guint32 *counts;
+  guint n_buckets, total = 0;
+
+  bounds = phoc_frame_stats_get_bucket_bounds (PHOC_FRAME_STATS_RENDER_TIME, &n_buckets);
+  g_assert_cmpuint (n_buckets, >, 2);
+  g_assert_cmpuint (bounds[n_buckets - 1], ==, G_MAXUINT64);
+
+  /* Values on the bound belong to the bucket */
+  phoc_frame_stats_add_composited (stats, bounds[0], 0);
+  phoc_frame_stats_add_composited (stats, bounds[0] + 1, 0);
+  phoc_frame_stats_add_composited (stats, G_MAXUINT32, 0);
+
+  counts = phoc_frame_stats_get_histogram (stats, PHOC_FRAME_STATS_RENDER_TIME, NULL);
+  g_assert_cmpuint (counts[0], ==, 1);
+  g_assert_cmpuint (counts[1], ==, 1);
+  g_assert_cmpuint (counts[n_buckets - 1], ==, 1);
+
+  /* Old samples drop out of the window */
+  for (guint i = 0; i < window; i++)
+    phoc_frame_stats_add_composited (stats, bounds[1], 0);
+
+  counts = phoc_frame_stats_get_histogram (stats, PHOC_FRAME_STATS_RENDER_TIME, NULL);
+  g_assert_cmpuint (counts[0], ==, 0);
+  g_assert_cmpuint (counts[1], ==, window);
+  g_assert_cmpuint (counts[n_buckets - 1], ==, 0);
+  for (guint i = 0; i < n_buckets; i++)
+    total += counts[i];
+  g_assert_cmpuint (total, ==, window);
+  g_assert_cmpuint (phoc_frame_stats_get_mean (stats, PHOC_FRAME_STATS_RENDER_TIME), ==, bounds[1]);
+  /* But still count as frames */
+  g_assert_cmpuint (phoc_frame_stats_get_n_composited (stats), ==, window + 3);
+}
+
+
+static void
+test_phoc_frame_stats_variant (void)
+{
+  g_autoptr (PhocFrameStats) stats = phoc_frame_stats_new ();
+  g_autoptr (GVariant) variant = NULL;
+  g_autoptr (GVariant) counts = NULL;
+  g_autoptr (GVariant) bounds = NULL;
+  g_autoptr (GVariant) mean = NULL;
+  guint64 composited;
+  const guint32 *elems;
+  gsize n_elems;
+
+  phoc_frame_stats_add_composited (stats, 100, 0);
+  variant = g_variant_ref_sink (phoc_frame_stats_to_variant (stats));
+
+  g_assert_true (g_variant_lookup (variant, "composited", "t", &composited));
+  g_assert_cmpuint (composited, ==, 1);
+
+  counts = g_variant_lookup_value (variant, "render-time-counts", G_VARIANT_TYPE ("au"));
+  g_assert_nonnull (counts);
+  elems = g_variant_get_fixed_array (counts, &n_elems, sizeof (guint32));
+  g_assert_cmpuint (elems[0], ==, 1);
+
+  bounds = g_variant_lookup_value (variant, "present-latency-bounds", G_VARIANT_TYPE ("at"));
+  g_assert_nonnull (bounds);
+  mean = g_variant_lookup_value (variant, "damage-area-mean", G_VARIANT_TYPE_UINT64);
+  g_assert_nonnull (mean);
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/frame-stats/counters", test_phoc_frame_stats_counters);
+  g_test_add_func ("/phoc/frame-stats/histogram", test_phoc_frame_stats_histogram);
+  g_test_add_func ("/phoc/frame-stats/variant", test_phoc_frame_stats_variant);
+
+  return g_test_run ();
+}
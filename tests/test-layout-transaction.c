@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "layout-transaction.h"
+
+
+static void
+test_phoc_layout_transaction_views (void)
+{
+  PhocLayoutTransaction *transaction = phoc_layout_transaction_get_default ();
+  guint id = 0, stale_id;
+
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+
+  /* Views only join active transactions */
+  phoc_layout_transaction_add_view_dirty (transaction, &id);
+  g_assert_cmpint (id, ==, 0);
+
+  phoc_layout_transaction_add_layer_dirty (transaction);
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+
+  phoc_layout_transaction_add_view_dirty (transaction, &id);
+  g_assert_cmpint (id, !=, 0);
+  stale_id = id;
+  /* Reconfiguring the view doesn't add another pending configure */
+  phoc_layout_transaction_add_view_dirty (transaction, &id);
+  g_assert_cmpint (id, ==, stale_id);
+
+  phoc_layout_transaction_notify_layer_configured (transaction);
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+
+  phoc_layout_transaction_notify_view_configured (transaction, &id);
+  g_assert_cmpint (id, ==, 0);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+
+  /* Acks for finished transactions don't affect new ones */
+  phoc_layout_transaction_add_layer_dirty (transaction);
+  phoc_layout_transaction_add_view_dirty (transaction, &id);
+  g_assert_cmpint (id, !=, stale_id);
+  phoc_layout_transaction_notify_layer_configured (transaction);
+  phoc_layout_transaction_notify_view_configured (transaction, &stale_id);
+  g_assert_cmpint (stale_id, ==, 0);
+  g_assert_true (phoc_layout_transaction_is_active (transaction));
+
+  phoc_layout_transaction_notify_view_configured (transaction, &id);
+  g_assert_false (phoc_layout_transaction_is_active (transaction));
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/layout-transaction/views", test_phoc_layout_transaction_views);
+
+  return g_test_run ();
+}
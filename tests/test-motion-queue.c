@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "motion-queue.h"
+
+
+static void
+on_motion (GString *log, int id, gpointer target, guint time_msec, double x, double y)
+{
+  g_string_append_printf (log, "motion %d %s %u %.1f,%.1f;",
+                          id, (char *)target, time_msec, x, y);
+}
+
+
+static void
+on_frame (GString *log)
+{
+  g_string_append (log, "frame;");
+}
+
+
+static PhocMotionQueue *
+motion_queue_new_logged (GString *log)
+{
+  PhocMotionQueue *queue = phoc_motion_queue_new ();
+
+  g_object_connect (queue,
+                    "swapped-signal::motion", on_motion, log,
+                    "swapped-signal::frame", on_frame, log,
+                    NULL);
+  return queue;
+}
+
+
+static void
+test_phoc_motion_queue_coalesce (void)
+{
+  g_autoptr (GString) log = g_string_new (NULL);
+  g_autoptr (PhocMotionQueue) queue = motion_queue_new_logged (log);
+
+  g_assert_false (phoc_motion_queue_is_pending (queue));
+  /* Nothing to wait for, frame goes out right away */
+  g_assert_false (phoc_motion_queue_push_frame (queue));
+
+  /* Relative and absolute motion both end up as surface local positions */
+  phoc_motion_queue_push (queue, 0, "surface", 10, 1.0, 1.0);
+  g_assert_true (phoc_motion_queue_push_frame (queue));
+  phoc_motion_queue_push (queue, 0, "surface", 12, 3.0, 2.0);
+  g_assert_true (phoc_motion_queue_push_frame (queue));
+  phoc_motion_queue_push (queue, 0, "surface", 14, 7.5, 4.0);
+  g_assert_true (phoc_motion_queue_push_frame (queue));
+  g_assert_true (phoc_motion_queue_is_pending (queue));
+  g_assert_cmpstr (log->str, ==, "");
+
+  /* One merged motion with the most recent position, then one frame */
+  phoc_motion_queue_flush (queue);
+  g_assert_cmpstr (log->str, ==, "motion 0 surface 14 7.5,4.0;frame;");
+  g_assert_false (phoc_motion_queue_is_pending (queue));
+
+  /* Nothing left */
+  g_string_truncate (log, 0);
+  phoc_motion_queue_flush (queue);
+  g_assert_cmpstr (log->str, ==, "");
+}
+
+
+static void
+test_phoc_motion_queue_touch_points (void)
+{
+  g_autoptr (GString) log = g_string_new (NULL);
+  g_autoptr (PhocMotionQueue) queue = motion_queue_new_logged (log);
+
+  /* Each touch point keeps its own motion in order of arrival */
+  phoc_motion_queue_push (queue, 3, "a", 10, 1.0, 1.0);
+  phoc_motion_queue_push (queue, 1, "b", 11, 5.0, 5.0);
+  g_assert_true (phoc_motion_queue_push_frame (queue));
+  phoc_motion_queue_push (queue, 3, "a", 20, 2.0, 2.0);
+  phoc_motion_queue_push (queue, 1, "b", 21, 6.0, 6.0);
+  g_assert_true (phoc_motion_queue_push_frame (queue));
+
+  phoc_motion_queue_flush (queue);
+  g_assert_cmpstr (log->str, ==, "motion 3 a 20 2.0,2.0;motion 1 b 21 6.0,6.0;frame;");
+}
+
+
+static void
+test_phoc_motion_queue_flush_first (void)
+{
+  g_autoptr (GString) log = g_string_new (NULL);
+  g_autoptr (PhocMotionQueue) queue = motion_queue_new_logged (log);
+  const char *events[] = { "button", "axis", "touch-down", "touch-up" };
+
+  /* Events that aren't coalesced flush pending motion first */
+  for (guint i = 0; i < G_N_ELEMENTS (events); i++) {
+    g_autofree char *expected = NULL;
+
+    g_string_truncate (log, 0);
+    phoc_motion_queue_push (queue, 0, "surface", 10, 1.0, 1.0);
+    phoc_motion_queue_push (queue, 0, "surface", 11, 2.0, 2.0);
+    g_assert_true (phoc_motion_queue_push_frame (queue));
+
+    phoc_motion_queue_flush (queue);
+    g_string_append_printf (log, "%s;", events[i]);
+
+    expected = g_strdup_printf ("motion 0 surface 11 2.0,2.0;frame;%s;", events[i]);
+    g_assert_cmpstr (log->str, ==, expected);
+  }
+
+  /* Without a frame event only the motion is sent */
+  g_string_truncate (log, 0);
+  phoc_motion_queue_push (queue, 0, "surface", 12, 3.0, 3.0);
+  phoc_motion_queue_flush (queue);
+  g_string_append (log, "button;");
+  g_assert_cmpstr (log->str, ==, "motion 0 surface 12 3.0,3.0;button;");
+}
+
+
+static void
+on_motion_push (PhocMotionQueue *queue, int id, gpointer target, guint time_msec, double x, double y)
+{
+  /* Only push once */
+  if (id == 0)
+    phoc_motion_queue_push (queue, 1, target, time_msec + 1, x + 1, y + 1);
+}
+
+
+static void
+test_phoc_motion_queue_reentrant (void)
+{
+  g_autoptr (GString) log = g_string_new (NULL);
+  g_autoptr (PhocMotionQueue) queue = motion_queue_new_logged (log);
+
+  g_signal_connect (queue, "motion", G_CALLBACK (on_motion_push), NULL);
+
+  /* Motion pushed while flushing waits for the next flush */
+  phoc_motion_queue_push (queue, 0, "surface", 10, 1.0, 1.0);
+  phoc_motion_queue_flush (queue);
+  g_assert_cmpstr (log->str, ==, "motion 0 surface 10 1.0,1.0;");
+  g_assert_true (phoc_motion_queue_is_pending (queue));
+
+  phoc_motion_queue_flush (queue);
+  g_assert_cmpstr (log->str, ==, "motion 0 surface 10 1.0,1.0;motion 1 surface 11 2.0,2.0;");
+  g_assert_false (phoc_motion_queue_is_pending (queue));
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/motion-queue/coalesce", test_phoc_motion_queue_coalesce);
+  g_test_add_func ("/phoc/motion-queue/touch-points", test_phoc_motion_queue_touch_points);
+  g_test_add_func ("/phoc/motion-queue/flush-first", test_phoc_motion_queue_flush_first);
+  g_test_add_func ("/phoc/motion-queue/reentrant", test_phoc_motion_queue_reentrant);
+
+  return g_test_run ();
+}
@@ -7,6 +7,8 @@
 #include "testlib.h"
 #include "gtk-shell-client-protocol.h"
 
+#include <wlr/util/box.h>
+
 typedef struct _PhocTestThumbnail
 {
   char* title;
@@ -84,6 +86,210 @@ test_phosh_private_thumbnail_simple (void)
   phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, GINT_TO_POINTER (FALSE));
 }
 
+typedef struct _PhocTestDamageFrame {
+  PhocTestClientGlobals *globals;
+  PhocTestBuffer buffer;
+  guint n_damage;
+  struct wlr_box damage; /* Bounding box of all damage events */
+  gboolean done;
+} PhocTestDamageFrame;
+
+
+static void
+damage_frame_handle_buffer (void                            *data,
+                            struct zwlr_screencopy_frame_v1 *handle,
+                            uint32_t                         format,
+                            uint32_t                         width,
+                            uint32_t                         height,
+                            uint32_t                         stride)
+{
+  PhocTestDamageFrame *frame = data;
+  gboolean success;
+
+  success = phoc_test_client_create_shm_buffer (frame->globals, &frame->buffer,
+                                                width, height, format);
+  g_assert_true (success);
+  zwlr_screencopy_frame_v1_copy_with_damage (handle, frame->buffer.wl_buffer);
+}
+
+
+static void
+damage_frame_handle_flags (void *data, struct zwlr_screencopy_frame_v1 *handle, uint32_t flags)
+{
+  g_assert_cmpint (flags, ==, 0);
+}
+
+
+static void
+damage_frame_handle_ready (void *data, struct zwlr_screencopy_frame_v1 *handle,
+                           uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec)
+{
+  PhocTestDamageFrame *frame = data;
+
+  frame->done = TRUE;
+}
+
+
+G_NORETURN
+static void
+damage_frame_handle_failed (void *data, struct zwlr_screencopy_frame_v1 *handle)
+{
+  g_assert_not_reached ();
+}
+
+
+static void
+damage_frame_handle_damage (void *data, struct zwlr_screencopy_frame_v1 *handle,
+                            uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+  PhocTestDamageFrame *frame = data;
+  int x2, y2;
+
+  /* Damage must arrive before ready */
+  g_assert_false (frame->done);
+
+  if (frame->n_damage++ == 0) {
+    frame->damage = (struct wlr_box) { x, y, width, height };
+    return;
+  }
+
+  x2 = MAX (frame->damage.x + frame->damage.width, (int)(x + width));
+  y2 = MAX (frame->damage.y + frame->damage.height, (int)(y + height));
+  frame->damage.x = MIN (frame->damage.x, (int)x);
+  frame->damage.y = MIN (frame->damage.y, (int)y);
+  frame->damage.width = x2 - frame->damage.x;
+  frame->damage.height = y2 - frame->damage.y;
+}
+
+
+static void
+damage_frame_handle_linux_dmabuf (void *data, struct zwlr_screencopy_frame_v1 *handle,
+                                  uint32_t format, uint32_t width, uint32_t height)
+{
+}
+
+
+static void
+damage_frame_handle_buffer_done (void *data, struct zwlr_screencopy_frame_v1 *handle)
+{
+}
+
+
+static const struct zwlr_screencopy_frame_v1_listener damage_frame_listener = {
+  .buffer = damage_frame_handle_buffer,
+  .flags = damage_frame_handle_flags,
+  .ready = damage_frame_handle_ready,
+  .failed = damage_frame_handle_failed,
+  .damage = damage_frame_handle_damage,
+  .linux_dmabuf = damage_frame_handle_linux_dmabuf,
+  .buffer_done = damage_frame_handle_buffer_done,
+};
+
+
+static struct zwlr_screencopy_frame_v1 *
+phoc_test_get_thumbnail_with_damage (PhocTestClientGlobals      *globals,
+                                     PhocTestXdgToplevelSurface *xs,
+                                     PhocTestDamageFrame        *frame)
+{
+  struct zwlr_screencopy_frame_v1 *handle;
+
+  frame->globals = globals;
+  handle = phosh_private_get_thumbnail (globals->phosh, xs->foreign_toplevel->handle,
+                                        xs->width, xs->height);
+  zwlr_screencopy_frame_v1_add_listener (handle, &damage_frame_listener, frame);
+  wl_display_roundtrip (globals->display);
+
+  return handle;
+}
+
+
+static guint32
+get_pixel (PhocTestBuffer *buffer, guint32 x, guint32 y)
+{
+  return *(guint32 *)(buffer->shm_data + y * buffer->stride + x * 4);
+}
+
+
+static gboolean
+test_client_phosh_private_thumbnail_damage (PhocTestClientGlobals *globals, gpointer data)
+{
+  PhocTestXdgToplevelSurface *xs;
+  PhocTestDamageFrame frame1 = { 0 }, frame2 = { 0 };
+  struct zwlr_screencopy_frame_v1 *handle;
+  PhocTestBuffer buffer;
+  struct wlr_box box = { 10, 20, 30, 40 };
+
+  xs = phoc_test_xdg_toplevel_new_with_buffer (globals, 0, 0, "damage", 0xFF00FF00);
+  g_assert_nonnull (xs);
+
+  /* There's no thumbnail yet so the frame is ready right away and all of it is damaged */
+  handle = phoc_test_get_thumbnail_with_damage (globals, xs, &frame1);
+  while (!frame1.done && wl_display_dispatch (globals->display) != -1) {
+  }
+  g_assert_cmpint (frame1.n_damage, >, 0);
+  g_assert_cmpint (frame1.damage.x, ==, 0);
+  g_assert_cmpint (frame1.damage.y, ==, 0);
+  g_assert_cmpint (frame1.damage.width, ==, xs->width);
+  g_assert_cmpint (frame1.damage.height, ==, xs->height);
+  g_assert_cmphex (get_pixel (&frame1.buffer, 0, 0), ==, 0xFF00FF00);
+  zwlr_screencopy_frame_v1_destroy (handle);
+
+  /* Nothing changed since, the frame is delayed */
+  handle = phoc_test_get_thumbnail_with_damage (globals, xs, &frame2);
+  wl_display_roundtrip (globals->display);
+  wl_display_roundtrip (globals->display);
+  g_assert_false (frame2.done);
+  g_assert_cmpint (frame2.n_damage, ==, 0);
+
+  /* Damage part of the view */
+  phoc_test_client_create_shm_buffer (globals, &buffer, xs->width, xs->height,
+                                      WL_SHM_FORMAT_XRGB8888);
+  for (guint32 y = 0; y < xs->height; y++) {
+    for (guint32 x = 0; x < xs->width; x++) {
+      guint32 *px = (guint32 *)(buffer.shm_data + y * buffer.stride + x * 4);
+
+      *px = wlr_box_contains_point (&box, x, y) ? 0xFFFF0000 : 0xFF00FF00;
+    }
+  }
+  wl_surface_attach (xs->wl_surface, buffer.wl_buffer, 0, 0);
+  wl_surface_damage (xs->wl_surface, box.x, box.y, box.width, box.height);
+  wl_surface_commit (xs->wl_surface);
+
+  /* Only the damaged part is reported */
+  while (!frame2.done && wl_display_dispatch (globals->display) != -1) {
+  }
+  g_assert_cmpint (frame2.n_damage, >, 0);
+  g_assert_cmpint (frame2.damage.x, <=, box.x);
+  g_assert_cmpint (frame2.damage.y, <=, box.y);
+  g_assert_cmpint (frame2.damage.x + frame2.damage.width, >=, box.x + box.width);
+  g_assert_cmpint (frame2.damage.y + frame2.damage.height, >=, box.y + box.height);
+  g_assert_cmpint (frame2.damage.width * frame2.damage.height, <, xs->width * xs->height);
+  g_assert_cmphex (get_pixel (&frame2.buffer, 0, 0), ==, 0xFF00FF00);
+  g_assert_cmphex (get_pixel (&frame2.buffer, box.x, box.y), ==, 0xFFFF0000);
+  zwlr_screencopy_frame_v1_destroy (handle);
+
+  phoc_test_xdg_toplevel_free (xs);
+  phoc_test_buffer_free (&buffer);
+  phoc_test_buffer_free (&frame1.buffer);
+  phoc_test_buffer_free (&frame2.buffer);
+
+  return TRUE;
+}
+
+static void
+test_phosh_private_thumbnail_damage (void)
+{
+  PhocTestClientIface iface = {
+   .client_run = test_client_phosh_private_thumbnail_damage,
+   .debug_flags    = PHOC_SERVER_DEBUG_FLAG_DISABLE_ANIMATIONS,
+  };
+
+  /* pixman renderer can work in containers, skip tests otherwise */
+  g_assert_cmpstr (g_getenv ("WLR_RENDERER"), ==, "pixman");
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, NULL);
+}
+
 static void
 keyboard_event_handle_grab_failed (void                                *data,
                                    struct phosh_private_keyboard_event *kbevent,
@@ -301,6 +507,7 @@ main (gint argc, gchar *argv[])
   g_test_init (&argc, &argv, NULL);
 
   PHOC_TEST_ADD ("/phoc/phosh/thumbnail/simple", test_phosh_private_thumbnail_simple);
+  PHOC_TEST_ADD ("/phoc/phosh/thumbnail/damage", test_phosh_private_thumbnail_damage);
   PHOC_TEST_ADD ("/phoc/phosh/kbevents/simple", test_phosh_private_kbevents_simple);
   PHOC_TEST_ADD ("/phoc/phosh/startup-tracker/simple", test_phosh_private_startup_tracker_simple);
   return g_test_run ();
@@ -194,6 +194,59 @@ test_phoc_property_easer_props_variant (void)
 }
 
 
+static guint n_setter_calls;
+
+static void
+set_prop_f (GObject *object, float value)
+{
+  PhocTestObj *self = PHOC_TEST_OBJ (object);
+
+  n_setter_calls++;
+  self->prop_f = value;
+}
+
+
+static void
+test_phoc_property_easer_setter (void)
+{
+  g_autoptr (PhocTestObj) obj = phoc_test_obj_new ();
+  g_autoptr (PhocPropertyEaser) easer = NULL;
+  guint n;
+
+  phoc_property_easer_install_setter (props[PROP_F], set_prop_f);
+  n_setter_calls = 0;
+
+  easer = g_object_new (PHOC_TYPE_PROPERTY_EASER,
+                        "target", obj,
+                        NULL);
+  n = phoc_property_easer_set_props (easer,
+                                     "prop-f", -100.0, 100.0,
+                                     "prop-i", 0, 10,
+                                     NULL);
+  g_assert_cmpint (n, ==, 2);
+  g_assert_cmpint (n_setter_calls, ==, 1);
+  g_assert_cmpfloat_with_epsilon (obj->prop_f, -100.0, FLT_EPSILON);
+
+  phoc_property_easer_set_progress (easer, 0.5);
+  g_assert_cmpint (n_setter_calls, ==, 2);
+  g_assert_cmpfloat_with_epsilon (obj->prop_f, 0.0, FLT_EPSILON);
+  g_assert_cmpint (obj->prop_i, ==, 5);
+
+  /* Easing a property again replaces it */
+  n = phoc_property_easer_set_props (easer, "prop-i", 100, 200, NULL);
+  g_assert_cmpint (n, ==, 1);
+  g_assert_cmpint (obj->prop_i, ==, 100);
+
+  /* Values are clamped to the property's range */
+  n = phoc_property_easer_set_props (easer, "prop-f", 0.0, 2000.0, NULL);
+  phoc_property_easer_set_progress (easer, 1.0);
+  g_assert_cmpfloat_with_epsilon (obj->prop_f, 1000.0, FLT_EPSILON);
+  g_assert_cmpint (obj->prop_i, ==, 200);
+
+  phoc_property_easer_install_setter (props[PROP_F], NULL);
+}
+
+
 gint
 main (gint argc, gchar *argv[])
 {
@@ -201,6 +254,7 @@ main (gint argc, gchar *argv[])
 
   g_test_add_func ("/phoc/propety-easer/va-list", test_phoc_property_easer_props_va_list);
   g_test_add_func ("/phoc/propety-easer/variant", test_phoc_property_easer_props_variant);
+  g_test_add_func ("/phoc/propety-easer/setter", test_phoc_property_easer_setter);
 
   return g_test_run ();
 }
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "render-scheduler.h"
+
+
+static void
+add_samples (PhocRenderScheduler *scheduler, guint n, gint64 render_us)
+{
+  for (guint i = 0; i < n; i++)
+    phoc_render_scheduler_add_render_time (scheduler, render_us);
+}
+
+
+static void
+test_phoc_render_scheduler_estimate (void)
+{
+  g_autoptr (PhocRenderScheduler) scheduler = phoc_render_scheduler_new ();
+
+  /* Too few samples */
+  add_samples (scheduler, 4, 2000);
+  g_assert_cmpint (phoc_render_scheduler_get_estimate (scheduler), ==, 0);
+
+  /* Longest recent render time wins */
+  add_samples (scheduler, 4, 3000);
+  g_assert_cmpint (phoc_render_scheduler_get_estimate (scheduler), ==, 3000);
+
+  /* Old samples drop out of the window */
+  add_samples (scheduler, 16, 1000);
+  g_assert_cmpint (phoc_render_scheduler_get_estimate (scheduler), ==, 1000);
+
+  /* Missing a deadline drops the estimate */
+  phoc_render_scheduler_add_missed (scheduler);
+  g_assert_cmpint (phoc_render_scheduler_get_estimate (scheduler), ==, 0);
+}
+
+
+static void
+test_phoc_render_scheduler_start_time (void)
+{
+  g_autoptr (PhocRenderScheduler) scheduler = phoc_render_scheduler_new ();
+  gint64 start_us = 0;
+
+  /* No estimate, render immediately */
+  g_assert_false (phoc_render_scheduler_get_start_time (scheduler, 100000, 116000, 16000,
+                                                        &start_us));
+
+  /* Render right before the vblank minus a safety margin */
+  add_samples (scheduler, 8, 2000);
+  g_assert_true (phoc_render_scheduler_get_start_time (scheduler, 100000, 116000, 16000,
+                                                       &start_us));
+  g_assert_cmpint (start_us, >, 100000);
+  g_assert_cmpint (start_us, <, 116000 - 2000);
+
+  /* Deadline too close */
+  g_assert_false (phoc_render_scheduler_get_start_time (scheduler, 113000, 116000, 16000,
+                                                        &start_us));
+
+  /* Unknown refresh rate */
+  g_assert_false (phoc_render_scheduler_get_start_time (scheduler, 100000, 116000, 0,
+                                                        &start_us));
+
+  /* Rendering takes most of the refresh cycle */
+  add_samples (scheduler, 8, 14000);
+  g_assert_false (phoc_render_scheduler_get_start_time (scheduler, 100000, 116000, 16000,
+                                                        &start_us));
+}
+
+
+static void
+on_render (PhocRenderScheduler *scheduler, gpointer data)
+{
+  gboolean *rendered = data;
+
+  *rendered = TRUE;
+}
+
+
+static void
+test_phoc_render_scheduler_defer (void)
+{
+  g_autoptr (PhocRenderScheduler) scheduler = phoc_render_scheduler_new ();
+  gboolean rendered = FALSE;
+
+  g_signal_connect (scheduler, "render", G_CALLBACK (on_render), &rendered);
+  g_assert_false (phoc_render_scheduler_is_deferred (scheduler));
+
+  phoc_render_scheduler_defer (scheduler, g_get_monotonic_time () + 1000);
+  g_assert_true (phoc_render_scheduler_is_deferred (scheduler));
+
+  while (!rendered)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_false (phoc_render_scheduler_is_deferred (scheduler));
+
+  /* Reset cancels */
+  rendered = FALSE;
+  phoc_render_scheduler_defer (scheduler, g_get_monotonic_time () + 1000);
+  phoc_render_scheduler_reset (scheduler);
+  g_assert_false (phoc_render_scheduler_is_deferred (scheduler));
+  g_usleep (2000);
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_false (rendered);
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/render-scheduler/estimate", test_phoc_render_scheduler_estimate);
+  g_test_add_func ("/phoc/render-scheduler/start-time", test_phoc_render_scheduler_start_time);
+  g_test_add_func ("/phoc/render-scheduler/defer", test_phoc_render_scheduler_defer);
+
+  return g_test_run ();
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "testlib.h"
+
+#include "desktop.h"
+#include "output.h"
+#include "view.h"
+
+#define RED   0xFFFF0000
+#define GREEN 0xFF00FF00
+
+typedef struct {
+  double x, y;
+  float  alpha;
+} TopViewState;
+
+
+static PhocOutput *
+get_output (void)
+{
+  PhocDesktop *desktop = phoc_server_get_desktop (phoc_server_get_default ());
+  PhocOutput *output;
+
+  g_assert_cmpint (wl_list_length (&desktop->outputs), ==, 1);
+  output = wl_container_of (desktop->outputs.next, output, link);
+
+  return output;
+}
+
+
+static gboolean
+on_set_top_view_state (gpointer data)
+{
+  TopViewState *state = data;
+  GQueue *views = phoc_desktop_get_views (phoc_server_get_desktop (phoc_server_get_default ()));
+  PhocView *top, *bottom;
+
+  g_assert_cmpint (g_queue_get_length (views), ==, 2);
+  top = g_queue_peek_head (views);
+  bottom = g_queue_peek_tail (views);
+
+  phoc_view_move (bottom, 0, 0);
+  phoc_view_move (top, state->x, state->y);
+  g_object_set (top, "alpha", state->alpha, NULL);
+
+  /* Render everything so all elements go through culling */
+  phoc_output_damage_whole (get_output ());
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static guint32
+get_pixel (PhocTestBuffer *buffer, guint32 x, guint32 y)
+{
+  g_assert_cmpint (x, <, buffer->width);
+  g_assert_cmpint (y, <, buffer->height);
+
+  return *(guint32 *)(buffer->shm_data + y * buffer->stride + x * 4) & 0x00FFFFFF;
+}
+
+
+static PhocTestBuffer *
+capture_with_top_view_state (PhocTestClientGlobals *globals, double x, double y, float alpha)
+{
+  TopViewState state = { .x = x, .y = y, .alpha = alpha };
+
+  phoc_test_run_in_server (on_set_top_view_state, &state);
+
+  return phoc_test_client_capture_output (globals, &globals->output);
+}
+
+
+static gboolean
+test_client_render_occlusion (PhocTestClientGlobals *globals, gpointer data)
+{
+  PhocTestXdgToplevelSurface *bottom, *top;
+  PhocTestBuffer *buffer;
+  guint32 px;
+
+  bottom = phoc_test_xdg_toplevel_new_with_buffer (globals, 0, 0, NULL, RED);
+  g_assert_nonnull (bottom);
+  top = phoc_test_xdg_toplevel_new_with_buffer (globals, 0, 0, NULL, GREEN);
+  g_assert_nonnull (top);
+  g_assert_cmpint (top->width, ==, bottom->width);
+  g_assert_cmpint (top->height, ==, bottom->height);
+
+  /* Opaque occluder: the bottom view is culled, only the top one shows */
+  buffer = capture_with_top_view_state (globals, 0, 0, 1.0);
+  g_assert_cmphex (get_pixel (buffer, 0, 0), ==, GREEN & 0x00FFFFFF);
+  g_assert_cmphex (get_pixel (buffer, top->width / 2, top->height / 2), ==, GREEN & 0x00FFFFFF);
+  g_assert_cmphex (get_pixel (buffer, top->width - 1, top->height - 1), ==, GREEN & 0x00FFFFFF);
+  phoc_test_buffer_free (buffer);
+
+  /* Partial occluder: the uncovered part of the bottom view is drawn */
+  buffer = capture_with_top_view_state (globals, top->width / 2, 0, 1.0);
+  g_assert_cmphex (get_pixel (buffer, 0, 0), ==, RED & 0x00FFFFFF);
+  g_assert_cmphex (get_pixel (buffer, top->width / 2 - 1, top->height - 1), ==, RED & 0x00FFFFFF);
+  g_assert_cmphex (get_pixel (buffer, top->width / 2, 0), ==, GREEN & 0x00FFFFFF);
+  g_assert_cmphex (get_pixel (buffer, top->width - 1, top->height - 1), ==, GREEN & 0x00FFFFFF);
+  g_assert_cmphex (get_pixel (buffer, top->width, top->height / 2), ==, GREEN & 0x00FFFFFF);
+  phoc_test_buffer_free (buffer);
+
+  /* Translucent occluder: the bottom view shines through */
+  buffer = capture_with_top_view_state (globals, 0, 0, 0.5);
+  px = get_pixel (buffer, top->width / 2, top->height / 2);
+  g_assert_cmphex ((px >> 16) & 0xFF, >, 0);
+  g_assert_cmphex ((px >> 8) & 0xFF, >, 0);
+  g_assert_cmphex ((px >> 8) & 0xFF, <, 0xFF);
+  phoc_test_buffer_free (buffer);
+
+  phoc_test_xdg_toplevel_free (top);
+  phoc_test_xdg_toplevel_free (bottom);
+
+  return TRUE;
+}
+
+
+static void
+test_render_occlusion (void)
+{
+  PhocTestClientIface iface = {
+    .client_run  = test_client_render_occlusion,
+    .debug_flags = PHOC_SERVER_DEBUG_FLAG_DISABLE_ANIMATIONS,
+  };
+
+  phoc_test_client_run (TEST_PHOC_CLIENT_TIMEOUT, &iface, NULL);
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  PHOC_TEST_ADD ("/phoc/render/occlusion", test_render_occlusion);
+
+  return g_test_run ();
+}
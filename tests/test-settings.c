@@ -18,6 +18,13 @@ test_phoc_config_defaults (void)
 
   g_assert_true (config->xwayland);
   g_assert_true (config->xwayland_lazy);
+  g_assert_cmpint (config->max_damage_rects, ==, PHOC_CONFIG_DEFAULT_MAX_DAMAGE_RECTS);
+  g_assert_cmpfloat (config->damage_overdraw, ==, (float)PHOC_CONFIG_DEFAULT_DAMAGE_OVERDRAW);
+  g_assert_false (config->coalesce_motion);
+  g_assert_false (config->render_deadline);
+  g_assert_cmpint (config->hidden_frame_rate, ==, PHOC_CONFIG_DEFAULT_HIDDEN_FRAME_RATE);
+  g_assert_true (config->freeze_suspended);
+  g_assert_false (config->scale_to_fit_prescale);
   g_assert_cmpint (g_slist_length (config->outputs), ==, 0);
   g_assert_null (config->config_path);
 }
@@ -50,6 +57,64 @@ test_phoc_config_output (void)
 }
 
 
+typedef enum {
+  OPTION_BOOL,
+  OPTION_UINT,
+  OPTION_FLOAT,
+} OptionType;
+
+typedef struct {
+  const char *key;
+  const char *value;
+  OptionType  type;
+  gsize       offset;
+  double      expected;
+} CoreOption;
+
+#define CORE_OPTION(k, v, t, field, e) { k, v, t, G_STRUCT_OFFSET (PhocConfig, field), e }
+
+static const CoreOption core_options[] = {
+  CORE_OPTION ("max-damage-rects", "0", OPTION_UINT, max_damage_rects, 0),
+  /* Clamped */
+  CORE_OPTION ("damage-overdraw", "2.0", OPTION_FLOAT, damage_overdraw, 1.0),
+  CORE_OPTION ("damage-overdraw", "0.5", OPTION_FLOAT, damage_overdraw, 0.5),
+  CORE_OPTION ("coalesce-motion", "true", OPTION_BOOL, coalesce_motion, TRUE),
+  CORE_OPTION ("render-deadline", "true", OPTION_BOOL, render_deadline, TRUE),
+  /* Clamped */
+  CORE_OPTION ("hidden-frame-rate", "5000", OPTION_UINT, hidden_frame_rate, 1000),
+  CORE_OPTION ("hidden-frame-rate", "0", OPTION_UINT, hidden_frame_rate, 0),
+  CORE_OPTION ("freeze-suspended", "false", OPTION_BOOL, freeze_suspended, FALSE),
+  CORE_OPTION ("scale-to-fit-prescale", "true", OPTION_BOOL, scale_to_fit_prescale, TRUE),
+};
+
+
+static void
+test_phoc_config_core_options (void)
+{
+  for (guint i = 0; i < G_N_ELEMENTS (core_options); i++) {
+    const CoreOption *option = &core_options[i];
+    g_autofree char *data = g_strdup_printf ("[core]\n%s = %s\n", option->key, option->value);
+    g_autoptr (PhocConfig) config = phoc_config_new_from_data (data);
+    gpointer field = G_STRUCT_MEMBER_P (config, option->offset);
+
+    g_test_message ("Checking %s = %s", option->key, option->value);
+    switch (option->type) {
+    case OPTION_BOOL:
+      g_assert_cmpint (*(bool *)field, ==, (bool)option->expected);
+      break;
+    case OPTION_UINT:
+      g_assert_cmpuint (*(guint *)field, ==, (guint)option->expected);
+      break;
+    case OPTION_FLOAT:
+      g_assert_cmpfloat (*(float *)field, ==, (float)option->expected);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+  }
+}
+
+
 static void
 test_phoc_config_modelines (void)
 {
@@ -77,6 +142,7 @@ main (gint argc, gchar *argv[])
   g_test_add_func ("/phoc/config/simple", test_phoc_config_defaults);
   g_test_add_func ("/phoc/config/output", test_phoc_config_output);
   g_test_add_func ("/phoc/config/modelines", test_phoc_config_modelines);
+  g_test_add_func ("/phoc/config/core-options", test_phoc_config_core_options);
 
   return g_test_run ();
 }
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "spatial-index.h"
+
+static int items[4];
+
+
+static void
+test_phoc_spatial_index_query (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new ();
+  g_autoptr (GPtrArray) results = g_ptr_array_new ();
+  struct wlr_box box1 = { 0, 0, 100, 100 };
+  struct wlr_box box2 = { 50, 50, 600, 600 };
+  struct wlr_box box3 = { -300, -300, 100, 100 };
+
+  phoc_spatial_index_update (index, &items[0], &box1);
+  phoc_spatial_index_update (index, &items[1], &box2);
+  phoc_spatial_index_update (index, &items[2], &box3);
+  g_assert_cmpint (phoc_spatial_index_get_n_items (index), ==, 3);
+
+  phoc_spatial_index_query (index, 10, 10, results);
+  g_assert_cmpint (results->len, ==, 1);
+  g_assert_true (g_ptr_array_index (results, 0) == &items[0]);
+
+  /* Right and bottom edges aren't part of the box */
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, 100, 10, results);
+  g_assert_cmpint (results->len, ==, 0);
+
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, 500, 500, results);
+  g_assert_cmpint (results->len, ==, 1);
+  g_assert_true (g_ptr_array_index (results, 0) == &items[1]);
+
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, -250.5, -201, results);
+  g_assert_cmpint (results->len, ==, 1);
+  g_assert_true (g_ptr_array_index (results, 0) == &items[2]);
+
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, -150, -150, results);
+  g_assert_cmpint (results->len, ==, 0);
+}
+
+
+static void
+test_phoc_spatial_index_negative (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new ();
+  g_autoptr (GPtrArray) results = g_ptr_array_new ();
+  /* Cells left of and above the origin must not clash with others */
+  struct wlr_box left = { -100, 10, 50, 50 };
+  struct wlr_box above = { 10, -100, 50, 50 };
+
+  phoc_spatial_index_update (index, &items[0], &left);
+  phoc_spatial_index_update (index, &items[1], &above);
+
+  phoc_spatial_index_query (index, -75, 20, results);
+  g_assert_cmpint (results->len, ==, 1);
+  g_assert_true (g_ptr_array_index (results, 0) == &items[0]);
+
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, 20, -75, results);
+  g_assert_cmpint (results->len, ==, 1);
+  g_assert_true (g_ptr_array_index (results, 0) == &items[1]);
+
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, 20, 20, results);
+  g_assert_cmpint (results->len, ==, 0);
+}
+
+
+static void
+test_phoc_spatial_index_order (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new ();
+  g_autoptr (GPtrArray) results = g_ptr_array_new ();
+  struct wlr_box box = { 0, 0, 100, 100 };
+  /* Too large for the grid */
+  struct wlr_box large = { -100000, -100000, 200000, 200000 };
+
+  phoc_spatial_index_update (index, &items[0], &box);
+  phoc_spatial_index_update (index, &items[1], &box);
+  phoc_spatial_index_update (index, &items[2], &large);
+  phoc_spatial_index_set_order (index, &items[0], 1);
+  phoc_spatial_index_set_order (index, &items[1], 3);
+  phoc_spatial_index_set_order (index, &items[2], 2);
+
+  phoc_spatial_index_query (index, 50, 50, results);
+  g_assert_cmpint (results->len, ==, 3);
+  g_assert_true (g_ptr_array_index (results, 0) == &items[1]);
+  g_assert_true (g_ptr_array_index (results, 1) == &items[2]);
+  g_assert_true (g_ptr_array_index (results, 2) == &items[0]);
+
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, 5000, 5000, results);
+  g_assert_cmpint (results->len, ==, 1);
+  g_assert_true (g_ptr_array_index (results, 0) == &items[2]);
+}
+
+
+static void
+test_phoc_spatial_index_update (void)
+{
+  g_autoptr (PhocSpatialIndex) index = phoc_spatial_index_new ();
+  g_autoptr (GPtrArray) results = g_ptr_array_new ();
+  struct wlr_box box = { 0, 0, 100, 100 };
+  struct wlr_box empty = { 0 };
+
+  phoc_spatial_index_update (index, &items[0], &box);
+
+  /* Move the item */
+  box.x = 1000;
+  phoc_spatial_index_update (index, &items[0], &box);
+  g_assert_cmpint (phoc_spatial_index_get_n_items (index), ==, 1);
+
+  phoc_spatial_index_query (index, 50, 50, results);
+  g_assert_cmpint (results->len, ==, 0);
+  phoc_spatial_index_query (index, 1050, 50, results);
+  g_assert_cmpint (results->len, ==, 1);
+
+  /* Empty boxes remove the item */
+  phoc_spatial_index_update (index, &items[0], &empty);
+  g_assert_cmpint (phoc_spatial_index_get_n_items (index), ==, 0);
+
+  phoc_spatial_index_update (index, &items[1], &box);
+  phoc_spatial_index_remove (index, &items[1]);
+  phoc_spatial_index_remove (index, &items[1]);
+  g_assert_cmpint (phoc_spatial_index_get_n_items (index), ==, 0);
+
+  g_ptr_array_set_size (results, 0);
+  phoc_spatial_index_query (index, 1050, 50, results);
+  g_assert_cmpint (results->len, ==, 0);
+}
+
+
+gint
+main (gint argc, gchar *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phoc/spatial-index/query", test_phoc_spatial_index_query);
+  g_test_add_func ("/phoc/spatial-index/order", test_phoc_spatial_index_order);
+  g_test_add_func ("/phoc/spatial-index/negative", test_phoc_spatial_index_negative);
+  g_test_add_func ("/phoc/spatial-index/update", test_phoc_spatial_index_update);
+
+  return g_test_run ();
+}
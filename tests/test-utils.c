@@ -44,12 +44,109 @@ test_phoc_utils_compute_scale (void)
   g_assert_cmpfloat (scale, ==, 1.0);
 }
 
+/*
+ * Test opaque regions are rounded inwards when scaled.
+ */
+static void
+test_phoc_utils_scale_opaque_region (void)
+{
+  pixman_region32_t opaque, scaled;
+  pixman_box32_t *extents;
+
+  pixman_region32_init_rect (&opaque, 1, 1, 10, 10);
+  pixman_region32_init (&scaled);
+
+  phoc_utils_scale_opaque_region (&scaled, &opaque, 2, 3, 2.0);
+  extents = pixman_region32_extents (&scaled);
+  g_assert_cmpint (extents->x1, ==, 6);
+  g_assert_cmpint (extents->y1, ==, 8);
+  g_assert_cmpint (extents->x2, ==, 26);
+  g_assert_cmpint (extents->y2, ==, 28);
+
+  /* Partially covered pixels aren't opaque */
+  pixman_region32_clear (&scaled);
+  phoc_utils_scale_opaque_region (&scaled, &opaque, 0, 0, 1.5);
+  extents = pixman_region32_extents (&scaled);
+  g_assert_cmpint (extents->x1, ==, 2);
+  g_assert_cmpint (extents->y1, ==, 2);
+  g_assert_cmpint (extents->x2, ==, 16);
+  g_assert_cmpint (extents->y2, ==, 16);
+
+  /* Regions that don't cover a full pixel vanish */
+  pixman_region32_clear (&scaled);
+  pixman_region32_fini (&opaque);
+  pixman_region32_init_rect (&opaque, 1, 1, 1, 1);
+  phoc_utils_scale_opaque_region (&scaled, &opaque, 0, 0, 0.5);
+  g_assert_false (pixman_region32_not_empty (&scaled));
+
+  pixman_region32_fini (&scaled);
+  pixman_region32_fini (&opaque);
+}
+
+/*
+ * Test damage regions are simplified within the budget while still
+ * covering the original region.
+ */
+static void
+test_phoc_utils_simplify_region (void)
+{
+  pixman_region32_t region, orig, uncovered;
+  pixman_box32_t *extents;
+
+  /* Single rectangles are left alone */
+  pixman_region32_init_rect (&region, 0, 0, 100, 10);
+  g_assert_false (phoc_utils_simplify_region (&region, 32, 0.25));
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 1);
+
+  /* Little overdraw, use the bounding box */
+  pixman_region32_union_rect (&region, &region, 0, 12, 100, 10);
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 2);
+  g_assert_true (phoc_utils_simplify_region (&region, 32, 0.25));
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 1);
+  extents = pixman_region32_extents (&region);
+  g_assert_cmpint (extents->y2, ==, 22);
+
+  /* Far apart but within budget */
+  pixman_region32_fini (&region);
+  pixman_region32_init_rect (&region, 0, 0, 10, 10);
+  pixman_region32_union_rect (&region, &region, 1000, 1000, 10, 10);
+  g_assert_false (phoc_utils_simplify_region (&region, 32, 0.25));
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 2);
+
+  /* Lots of small rectangles like e.g. a terminal */
+  pixman_region32_clear (&region);
+  for (int row = 0; row < 20; row++) {
+    for (int col = 0; col < 10; col++)
+      pixman_region32_union_rect (&region, &region, col * 40, row * 20, 8, 8);
+  }
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 200);
+  pixman_region32_init (&orig);
+  pixman_region32_copy (&orig, &region);
+
+  /* No budget */
+  g_assert_false (phoc_utils_simplify_region (&region, 0, 0.25));
+  g_assert_cmpint (pixman_region32_n_rects (&region), ==, 200);
+
+  g_assert_true (phoc_utils_simplify_region (&region, 16, 0.25));
+  g_assert_cmpint (pixman_region32_n_rects (&region), <=, 16);
+
+  pixman_region32_init (&uncovered);
+  pixman_region32_subtract (&uncovered, &orig, &region);
+  g_assert_false (pixman_region32_not_empty (&uncovered));
+
+  pixman_region32_fini (&uncovered);
+  pixman_region32_fini (&orig);
+  pixman_region32_fini (&region);
+}
+
 gint
 main (gint argc, gchar *argv[])
 {
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/phoc/utils/compute_scale", test_phoc_utils_compute_scale);
+  g_test_add_func ("/phoc/utils/scale_opaque_region", test_phoc_utils_scale_opaque_region);
+  g_test_add_func ("/phoc/utils/simplify_region", test_phoc_utils_simplify_region);
 
   return g_test_run ();
 }
@@ -1035,6 +1035,170 @@ phoc_test_xdg_update_buffer (PhocTestClientGlobals      *globals,
   xs->buffer = buffer;
 }
 
+static void
+xdg_popup_handle_configure (void             *data,
+                            struct xdg_popup *xdg_popup,
+                            int32_t           x,
+                            int32_t           y,
+                            int32_t           width,
+                            int32_t           height)
+{
+  PhocTestXdgPopup *popup = data;
+
+  popup->width = width;
+  popup->height = height;
+  popup->configured = TRUE;
+}
+
+static void
+xdg_popup_handle_done (void *data, struct xdg_popup *xdg_popup)
+{
+}
+
+static void
+xdg_popup_handle_repositioned (void *data, struct xdg_popup *xdg_popup, uint32_t token)
+{
+}
+
+static const struct xdg_popup_listener xdg_popup_listener = {
+  .configure = xdg_popup_handle_configure,
+  .popup_done = xdg_popup_handle_done,
+  .repositioned = xdg_popup_handle_repositioned,
+};
+
+static void
+xdg_popup_surface_handle_configure (void *data, struct xdg_surface *xdg_surface, uint32_t serial)
+{
+  xdg_surface_ack_configure (xdg_surface, serial);
+}
+
+static const struct xdg_surface_listener xdg_popup_surface_listener = {
+  .configure = xdg_popup_surface_handle_configure,
+};
+
+/**
+ * phoc_test_xdg_popup_new:
+ * @globals: The wayland globals
+ * @parent: The parent toplevel
+ * @width: The desired popup width
+ * @height: The desired popup height
+ * @color: The color to fill the popup with
+ *
+ * Creates a xdg popup anchored to the bottom right of the center of
+ * `parent` and attaches a buffer with the given color. Free with
+ * `phoc_test_xdg_popup_free`.
+ *
+ * Returns: The popup
+ */
+PhocTestXdgPopup *
+phoc_test_xdg_popup_new (PhocTestClientGlobals      *globals,
+                         PhocTestXdgToplevelSurface *parent,
+                         guint32                     width,
+                         guint32                     height,
+                         guint32                     color)
+{
+  struct xdg_positioner *xdg_positioner;
+  PhocTestXdgPopup *popup = g_new0 (PhocTestXdgPopup, 1);
+
+  popup->wl_surface = wl_compositor_create_surface (globals->compositor);
+  g_assert_nonnull (popup->wl_surface);
+  popup->xdg_surface = xdg_wm_base_get_xdg_surface (globals->xdg_shell, popup->wl_surface);
+  g_assert_nonnull (popup->xdg_surface);
+
+  xdg_positioner = xdg_wm_base_create_positioner (globals->xdg_shell);
+  xdg_positioner_set_size (xdg_positioner, width, height);
+  xdg_positioner_set_anchor_rect (xdg_positioner, 0, 0, parent->width / 2, parent->height / 2);
+  xdg_positioner_set_anchor (xdg_positioner, XDG_POSITIONER_ANCHOR_BOTTOM_RIGHT);
+  xdg_positioner_set_gravity (xdg_positioner, XDG_POSITIONER_GRAVITY_BOTTOM_RIGHT);
+
+  popup->xdg_popup = xdg_surface_get_popup (popup->xdg_surface, parent->xdg_surface,
+                                            xdg_positioner);
+  g_assert_nonnull (popup->xdg_popup);
+  xdg_surface_add_listener (popup->xdg_surface, &xdg_popup_surface_listener, popup);
+  xdg_popup_add_listener (popup->xdg_popup, &xdg_popup_listener, popup);
+
+  wl_surface_commit (popup->wl_surface);
+  wl_display_roundtrip (globals->display);
+  xdg_positioner_destroy (xdg_positioner);
+  g_assert_true (popup->configured);
+
+  phoc_test_client_create_shm_buffer (globals, &popup->buffer, popup->width, popup->height,
+                                      WL_SHM_FORMAT_XRGB8888);
+  for (int i = 0; i < popup->width * popup->height * 4; i += 4)
+    *(guint32*)(popup->buffer.shm_data + i) = color;
+
+  wl_surface_attach (popup->wl_surface, popup->buffer.wl_buffer, 0, 0);
+  wl_surface_damage (popup->wl_surface, 0, 0, popup->width, popup->height);
+  wl_surface_commit (popup->wl_surface);
+  wl_display_roundtrip (globals->display);
+
+  return popup;
+}
+
+
+void
+phoc_test_xdg_popup_free (PhocTestXdgPopup *popup)
+{
+  xdg_popup_destroy (popup->xdg_popup);
+  xdg_surface_destroy (popup->xdg_surface);
+  wl_surface_destroy (popup->wl_surface);
+  phoc_test_buffer_free (&popup->buffer);
+  g_free (popup);
+}
+
+
+typedef struct {
+  GSourceFunc func;
+  gpointer    data;
+  GMutex      mutex;
+  GCond       cond;
+  gboolean    done;
+} PhocTestServerCall;
+
+
+static gboolean
+on_server_call (gpointer data)
+{
+  PhocTestServerCall *call = data;
+
+  call->func (call->data);
+
+  g_mutex_lock (&call->mutex);
+  call->done = TRUE;
+  g_cond_signal (&call->cond);
+  g_mutex_unlock (&call->mutex);
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * phoc_test_run_in_server:
+ * @func: The function to run
+ * @data: Data passed to `func`
+ *
+ * Runs `func` in the compositor's main loop and waits for it to
+ * finish so it can access compositor state. Meant to be invoked from
+ * the test client.
+ */
+void
+phoc_test_run_in_server (GSourceFunc func, gpointer data)
+{
+  PhocTestServerCall call = { .func = func, .data = data };
+
+  g_mutex_init (&call.mutex);
+  g_cond_init (&call.cond);
+
+  g_main_context_invoke (NULL, on_server_call, &call);
+
+  g_mutex_lock (&call.mutex);
+  while (!call.done)
+    g_cond_wait (&call.cond, &call.mutex);
+  g_mutex_unlock (&call.mutex);
+
+  g_mutex_clear (&call.mutex);
+  g_cond_clear (&call.cond);
+}
+
 /**
  * phoc_test_setup:
  * @fixture: Test fixture
@@ -1062,8 +1226,10 @@ phoc_test_setup (PhocTestFixture *fixture, gconstpointer data)
   g_assert_no_error (err);
 
   g_setenv ("XDG_RUNTIME_DIR", fixture->tmpdir, TRUE);
-  g_setenv ("DISPLAY", display, TRUE);
-  g_setenv ("WLR_BACKENDS", "x11", TRUE);
+  if (display)
+    g_setenv ("DISPLAY", display, TRUE);
+  /* Allow e.g. benchmarks to pick the headless backend */
+  g_setenv ("WLR_BACKENDS", "x11", FALSE);
 }
 
 static void
@@ -1116,7 +1282,8 @@ phoc_test_teardown (PhocTestFixture *fixture, gconstpointer unused)
   g_test_dbus_down (fixture->bus);
   g_clear_object (&fixture->bus);
 
-  g_setenv ("DISPLAY", display, TRUE);
+  if (display)
+    g_setenv ("DISPLAY", display, TRUE);
   phoc_test_remove_tree (file);
   g_free (fixture->tmpdir);
 }
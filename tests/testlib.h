@@ -111,6 +111,16 @@ typedef struct _PhocTestXdgToplevelSurface
 } PhocTestXdgToplevelSurface;
 
 
+typedef struct _PhocTestXdgPopup {
+  struct wl_surface *wl_surface;
+  struct xdg_surface *xdg_surface;
+  struct xdg_popup *xdg_popup;
+  PhocTestBuffer buffer;
+  guint32 width, height;
+  gboolean configured;
+} PhocTestXdgPopup;
+
+
 typedef struct _PhocTestFixture {
   GTestDBus   *bus;
   char        *tmpdir;
@@ -144,6 +154,14 @@ void            phoc_test_xdg_toplevel_free (PhocTestXdgToplevelSurface *xs);
 void            phoc_test_xdg_update_buffer (PhocTestClientGlobals      *globals,
                                              PhocTestXdgToplevelSurface *xs,
                                              guint32                     color);
+PhocTestXdgPopup *
+                phoc_test_xdg_popup_new (PhocTestClientGlobals      *globals,
+                                         PhocTestXdgToplevelSurface *parent,
+                                         guint32                     width,
+                                         guint32                     height,
+                                         guint32                     color);
+void            phoc_test_xdg_popup_free (PhocTestXdgPopup *popup);
+void            phoc_test_run_in_server (GSourceFunc func, gpointer data);
 /* Buffers */
 gboolean phoc_test_buffer_equal (PhocTestBuffer *buf1, PhocTestBuffer *buf2);
 gboolean phoc_test_buffer_save (PhocTestBuffer *buffer, const gchar *filename);